@@ -0,0 +1,47 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+/**
+ * Three-term recurrence of the Chebyshev propagator, in place on p_next:
+ * p_next = alpha * p_next + beta * p_prev
+ * where p_next holds L * p_k on input, and p_(k+1) on output.
+ * p_prev is not read if beta is zero.
+ */
+__kernel void chebyshev_recurrence(
+	__global       real_t* restrict p_next,
+	const real_t alpha,
+	const real_t beta,
+	__global const real_t* restrict p_prev
+)
+{
+	// sigma matrix id processed by this work item
+	#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+	#define sigma_real(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)))
+	#define sigma_imag(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)) + 1)
+
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	for (int i = 0; i < NUM_STATES; ++i) // row
+	{
+		for (int j = 0; j < NUM_STATES; ++j) // column
+		{
+			if (beta != 0.0)
+			{
+				p_next[sigma_real(i,j)] = alpha * p_next[sigma_real(i,j)] + beta * p_prev[sigma_real(i,j)];
+				p_next[sigma_imag(i,j)] = alpha * p_next[sigma_imag(i,j)] + beta * p_prev[sigma_imag(i,j)];
+			}
+			else
+			{
+				p_next[sigma_real(i,j)] *= alpha;
+				p_next[sigma_imag(i,j)] *= alpha;
+			}
+		}
+	}
+}
@@ -0,0 +1,353 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+#include "stage_input.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+// optional defines: NOMA_NUM_ODE_ACCUMULATE, NOMA_NUM_SUBDIAGONAL, NOMA_NUM_ODE_FUSED (see the steppers' ode_compile_options())
+//                   NOMA_NUM_K_STORAGE_HALF, NOMA_NUM_K_STORAGE_BF16, format of out (see k_storage.hpp)
+//                   NOMA_NUM_REGISTER_BLOCK, number of result columns kept in registers per work-item
+
+// number of complex elements of one matrix
+#define NOMA_NUM_MATRIX_DIM (NUM_STATES * NUM_STATES)
+
+#ifndef NOMA_NUM_REGISTER_BLOCK
+	#define NOMA_NUM_REGISTER_BLOCK (NUM_STATES < 8 ? NUM_STATES : 8)
+#endif
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+
+// complex element (i, j) of matrix m, interleaved real and imaginary parts
+#define matrix_real(m, i, j) (2 * ((m) * NOMA_NUM_MATRIX_DIM + (i) * NUM_STATES + (j)))
+#define matrix_imag(m, i, j) (2 * ((m) * NOMA_NUM_MATRIX_DIM + (i) * NUM_STATES + (j)) + 1)
+#define matrix_load(buf, m, i, j) ((complex_t)((buf)[matrix_real(m, i, j)], (buf)[matrix_imag(m, i, j)]))
+// same for the ODE input, i.e. the stage input for NOMA_NUM_ODE_FUSED (see stage_input.cl)
+#define matrix_load_input(buf, m, i, j) ((complex_t)(NOMA_NUM_LOAD_INPUT(buf, matrix_real(m, i, j)), NOMA_NUM_LOAD_INPUT(buf, matrix_imag(m, i, j))))
+
+// complex fused multiply-add: acc + a * b
+inline complex_t cmad(complex_t a, complex_t b, complex_t acc)
+{
+	return (complex_t)(acc.x + a.x * b.x - a.y * b.y, acc.y + a.x * b.y + a.y * b.x);
+}
+
+/**
+ * Batched small complex matrix multiplication, one matrix per work-item:
+ * c = alpha * a * b + beta * c
+ *
+ * Result columns are computed in blocks of NOMA_NUM_REGISTER_BLOCK, such that
+ * each loaded element of a is reused for a whole block.
+ */
+__kernel void complex_matrix_gemm(
+	__global       real_t* restrict c,
+	const real_t alpha_real,
+	const real_t alpha_imag,
+	__global const real_t* restrict a,
+	__global const real_t* restrict b,
+	const real_t beta_real,
+	const real_t beta_imag
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const complex_t alpha = (complex_t)(alpha_real, alpha_imag);
+	const complex_t beta = (complex_t)(beta_real, beta_imag);
+
+	for (int i = 0; i < NUM_STATES; ++i) {
+		for (int j0 = 0; j0 < NUM_STATES; j0 += NOMA_NUM_REGISTER_BLOCK) {
+			complex_t acc[NOMA_NUM_REGISTER_BLOCK];
+			for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb)
+				acc[jb] = (complex_t)(0.0, 0.0);
+
+			for (int k = 0; k < NUM_STATES; ++k) {
+				const complex_t a_ik = matrix_load(a, sigma_id, i, k);
+				for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb)
+					if (j0 + jb < NUM_STATES)
+						acc[jb] = cmad(a_ik, matrix_load(b, sigma_id, k, j0 + jb), acc[jb]);
+			}
+
+			for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb) {
+				if (j0 + jb < NUM_STATES) {
+					const int j = j0 + jb;
+					complex_t result = cmult(alpha, acc[jb]);
+					if (beta.x != 0.0 || beta.y != 0.0) // NOTE: c is not read for beta = 0, i.e. may be uninitialised
+						result = cmad(beta, matrix_load(c, sigma_id, i, j), result);
+					c[matrix_real(sigma_id, i, j)] = result.x;
+					c[matrix_imag(sigma_id, i, j)] = result.y;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Right-hand side of the von Neumann equation and its variants, one matrix
+ * per work-item, with a Hamiltonian h shared by all matrices:
+ *
+ * f(in) = alpha * (h * in + sign * in * h)
+ *
+ * alpha = -i, sign = -1: commutator,     f(in) = -i [h, in]
+ * sign = +1:             anticommutator, f(in) = alpha {h, in}
+ *
+ * h is staged in local memory by the whole work-group. Result columns are
+ * computed in blocks of NOMA_NUM_REGISTER_BLOCK.
+ *
+ * Output, depending on the defines from the stepper:
+ * default:                 out = f(in)
+ * NOMA_NUM_ODE_ACCUMULATE: out = f(in), acc = (init ? in : acc) + acc_coeff * f(in)
+ * NOMA_NUM_SUBDIAGONAL:    as above, but out = y_n + next_coeff * f(in) if next is set,
+ *                          i.e. out is the input of the next stage
+ * NOMA_NUM_ODE_FUSED:      as NOMA_NUM_ODE_ACCUMULATE, but in holds y_n, and f is evaluated
+ *                          for the stage input formed on the fly (see stage_input.cl),
+ *                          once per element into private memory, i.e. y_n and each k are read once
+ */
+__kernel void complex_matrix_commutator(
+	__global       k_real_t* restrict out,
+	__global const real_t* restrict in,
+	__global const real_t* restrict h,
+	const real_t alpha_real,
+	const real_t alpha_imag,
+	const real_t sign
+#ifdef NOMA_NUM_ODE_ACCUMULATE
+	,
+	__global       real_t* restrict acc,
+	const real_t acc_coeff,
+	const int_t init
+#ifdef NOMA_NUM_SUBDIAGONAL
+	,
+	__global const real_t* y_n, // NOTE: no restrict, aliases in for the first stage
+	const real_t next_coeff,
+	const int_t next
+#endif
+#endif
+	NOMA_NUM_STAGE_PARAMS
+)
+{
+	__local real_t h_local[2 * NOMA_NUM_MATRIX_DIM];
+
+	// load h cooperatively, before skipping padded work-items, as all of them must reach the barrier
+	const size_t local_size = get_local_size(0) * get_local_size(1);
+	const size_t local_id = get_local_id(1) * get_local_size(0) + get_local_id(0);
+	for (size_t e = local_id; e < 2 * NOMA_NUM_MATRIX_DIM; e += local_size)
+		h_local[e] = h[e];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const complex_t alpha = (complex_t)(alpha_real, alpha_imag);
+
+#ifdef NOMA_NUM_ODE_FUSED
+	// form the stage input once per element, instead of on every load in the k loop below
+	complex_t in_stage[NOMA_NUM_MATRIX_DIM];
+	for (int e = 0; e < NOMA_NUM_MATRIX_DIM; ++e)
+		in_stage[e] = matrix_load_input(in, sigma_id, 0, e);
+	#define commutator_input(i, j) (in_stage[(i) * NUM_STATES + (j)])
+#else
+	#define commutator_input(i, j) matrix_load(in, sigma_id, i, j)
+#endif
+
+	for (int i = 0; i < NUM_STATES; ++i) {
+		for (int j0 = 0; j0 < NUM_STATES; j0 += NOMA_NUM_REGISTER_BLOCK) {
+			complex_t h_in[NOMA_NUM_REGISTER_BLOCK]; // (h * in)_ij
+			complex_t in_h[NOMA_NUM_REGISTER_BLOCK]; // (in * h)_ij
+			for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb) {
+				h_in[jb] = (complex_t)(0.0, 0.0);
+				in_h[jb] = (complex_t)(0.0, 0.0);
+			}
+
+			for (int k = 0; k < NUM_STATES; ++k) {
+				const complex_t h_ik = matrix_load(h_local, 0, i, k);
+				const complex_t in_ik = commutator_input(i, k);
+				for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb) {
+					if (j0 + jb < NUM_STATES) {
+						h_in[jb] = cmad(h_ik, commutator_input(k, j0 + jb), h_in[jb]);
+						in_h[jb] = cmad(in_ik, matrix_load(h_local, 0, k, j0 + jb), in_h[jb]);
+					}
+				}
+			}
+
+			for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb) {
+				if (j0 + jb < NUM_STATES) {
+					const int j = j0 + jb;
+					const complex_t f = cmult(alpha, h_in[jb] + sign * in_h[jb]);
+
+#ifdef NOMA_NUM_ODE_ACCUMULATE
+					const complex_t acc_old = init ? matrix_load(in, sigma_id, i, j) : matrix_load(acc, sigma_id, i, j);
+					acc[matrix_real(sigma_id, i, j)] = acc_old.x + acc_coeff * f.x;
+					acc[matrix_imag(sigma_id, i, j)] = acc_old.y + acc_coeff * f.y;
+#ifdef NOMA_NUM_SUBDIAGONAL
+					if (next) {
+						out[matrix_real(sigma_id, i, j)] = y_n[matrix_real(sigma_id, i, j)] + next_coeff * f.x;
+						out[matrix_imag(sigma_id, i, j)] = y_n[matrix_imag(sigma_id, i, j)] + next_coeff * f.y;
+						continue;
+					}
+#endif
+#endif
+					NOMA_NUM_STORE_K(out, matrix_real(sigma_id, i, j), f.x);
+					NOMA_NUM_STORE_K(out, matrix_imag(sigma_id, i, j), f.y);
+				}
+			}
+		}
+	}
+
+	#undef commutator_input
+}
+
+/**
+ * Element-wise decay, e.g. dephasing, one matrix per work-item:
+ * out_ij = -rates_ij * in_ij
+ *
+ * with one complex rate per element, used as split implicit part of the
+ * commutator ODE (see commutator_ode::decay()).
+ */
+__kernel void complex_matrix_decay(
+	__global       real_t* restrict out,
+	__global const real_t* restrict in,
+	__global const real_t* restrict rates
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	for (int i = 0; i < NUM_STATES; ++i) {
+		for (int j = 0; j < NUM_STATES; ++j) {
+			const complex_t f = -cmult(matrix_load(rates, 0, i, j), matrix_load(in, sigma_id, i, j));
+			out[matrix_real(sigma_id, i, j)] = f.x;
+			out[matrix_imag(sigma_id, i, j)] = f.y;
+		}
+	}
+}
+
+// vectorised variant:
+// each work-item processes VEC_LENGTH matrices, stored interleaved ("packed"),
+// i.e. element (i, j) of package p holds VEC_LENGTH real parts, followed by VEC_LENGTH imaginary parts
+#define VLOAD_HELPER(n) vload ## n
+#define VLOAD(n) VLOAD_HELPER(n)
+#define VSTORE_HELPER(n) vstore ## n
+#define VSTORE(n) VSTORE_HELPER(n)
+
+#define NUM_PACKAGES (NUM_MATRICES / VEC_LENGTH)
+#define package_real(p, i, j) (2 * ((p) * NOMA_NUM_MATRIX_DIM + (i) * NUM_STATES + (j)))
+#define package_imag(p, i, j) (2 * ((p) * NOMA_NUM_MATRIX_DIM + (i) * NUM_STATES + (j)) + 1)
+
+#if defined(NOMA_NUM_K_STORAGE_HALF) || defined(NOMA_NUM_K_STORAGE_BF16)
+// stores value like VSTORE(VEC_LENGTH), converting every component to the k storage format
+inline void packed_store_k(const real_vec_t value, const size_t offset, __global k_real_t* p)
+{
+	real_t components[VEC_LENGTH];
+	VSTORE(VEC_LENGTH)(value, 0, components);
+	for (int l = 0; l < VEC_LENGTH; ++l)
+		NOMA_NUM_STORE_K(p, offset * VEC_LENGTH + l, components[l]);
+}
+#else
+#define packed_store_k(value, offset, p) VSTORE(VEC_LENGTH)((value), (offset), (p))
+#endif
+
+/**
+ * Same as complex_matrix_commutator(), for the packed layout, with complex
+ * arithmetic on real_vec_t, i.e. over VEC_LENGTH matrices at once.
+ *
+ * NOTE: requires NUM_MATRICES to be a multiple of VEC_LENGTH, and a global
+ *       range of NUM_MATRICES / VEC_LENGTH work-items.
+ */
+__kernel void complex_matrix_commutator_packed(
+	__global       k_real_t* restrict out,
+	__global const real_t* restrict in,
+	__global const real_t* restrict h,
+	const real_t alpha_real,
+	const real_t alpha_imag,
+	const real_t sign
+#ifdef NOMA_NUM_ODE_ACCUMULATE
+	,
+	__global       real_t* restrict acc,
+	const real_t acc_coeff,
+	const int_t init
+#ifdef NOMA_NUM_SUBDIAGONAL
+	,
+	__global const real_t* y_n, // NOTE: no restrict, aliases in for the first stage
+	const real_t next_coeff,
+	const int_t next
+#endif
+#endif
+)
+{
+	__local real_t h_local[2 * NOMA_NUM_MATRIX_DIM];
+
+	// load h cooperatively, before skipping padded work-items, as all of them must reach the barrier
+	const size_t local_size = get_local_size(0) * get_local_size(1);
+	const size_t local_id = get_local_id(1) * get_local_size(0) + get_local_id(0);
+	for (size_t e = local_id; e < 2 * NOMA_NUM_MATRIX_DIM; e += local_size)
+		h_local[e] = h[e];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// skip padded work-items
+	if (sigma_id >= NUM_PACKAGES)
+		return;
+
+	for (int i = 0; i < NUM_STATES; ++i) {
+		for (int j0 = 0; j0 < NUM_STATES; j0 += NOMA_NUM_REGISTER_BLOCK) {
+			real_vec_t h_in_real[NOMA_NUM_REGISTER_BLOCK];
+			real_vec_t h_in_imag[NOMA_NUM_REGISTER_BLOCK];
+			real_vec_t in_h_real[NOMA_NUM_REGISTER_BLOCK];
+			real_vec_t in_h_imag[NOMA_NUM_REGISTER_BLOCK];
+			for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb) {
+				h_in_real[jb] = 0.0;
+				h_in_imag[jb] = 0.0;
+				in_h_real[jb] = 0.0;
+				in_h_imag[jb] = 0.0;
+			}
+
+			for (int k = 0; k < NUM_STATES; ++k) {
+				const complex_t h_ik = matrix_load(h_local, 0, i, k);
+				const real_vec_t in_ik_real = VLOAD(VEC_LENGTH)(package_real(sigma_id, i, k), in);
+				const real_vec_t in_ik_imag = VLOAD(VEC_LENGTH)(package_imag(sigma_id, i, k), in);
+				for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb) {
+					if (j0 + jb < NUM_STATES) {
+						const real_vec_t in_kj_real = VLOAD(VEC_LENGTH)(package_real(sigma_id, k, j0 + jb), in);
+						const real_vec_t in_kj_imag = VLOAD(VEC_LENGTH)(package_imag(sigma_id, k, j0 + jb), in);
+						const complex_t h_kj = matrix_load(h_local, 0, k, j0 + jb);
+
+						h_in_real[jb] += h_ik.x * in_kj_real - h_ik.y * in_kj_imag;
+						h_in_imag[jb] += h_ik.x * in_kj_imag + h_ik.y * in_kj_real;
+						in_h_real[jb] += in_ik_real * h_kj.x - in_ik_imag * h_kj.y;
+						in_h_imag[jb] += in_ik_real * h_kj.y + in_ik_imag * h_kj.x;
+					}
+				}
+			}
+
+			for (int jb = 0; jb < NOMA_NUM_REGISTER_BLOCK; ++jb) {
+				if (j0 + jb < NUM_STATES) {
+					const int j = j0 + jb;
+					const real_vec_t sum_real = h_in_real[jb] + sign * in_h_real[jb];
+					const real_vec_t sum_imag = h_in_imag[jb] + sign * in_h_imag[jb];
+					const real_vec_t f_real = alpha_real * sum_real - alpha_imag * sum_imag;
+					const real_vec_t f_imag = alpha_real * sum_imag + alpha_imag * sum_real;
+
+#ifdef NOMA_NUM_ODE_ACCUMULATE
+					__global const real_t* acc_src = init ? in : acc;
+					const real_vec_t acc_real = VLOAD(VEC_LENGTH)(package_real(sigma_id, i, j), acc_src) + acc_coeff * f_real;
+					const real_vec_t acc_imag = VLOAD(VEC_LENGTH)(package_imag(sigma_id, i, j), acc_src) + acc_coeff * f_imag;
+					VSTORE(VEC_LENGTH)(acc_real, package_real(sigma_id, i, j), acc);
+					VSTORE(VEC_LENGTH)(acc_imag, package_imag(sigma_id, i, j), acc);
+#ifdef NOMA_NUM_SUBDIAGONAL
+					if (next) {
+						VSTORE(VEC_LENGTH)(VLOAD(VEC_LENGTH)(package_real(sigma_id, i, j), y_n) + next_coeff * f_real, package_real(sigma_id, i, j), out);
+						VSTORE(VEC_LENGTH)(VLOAD(VEC_LENGTH)(package_imag(sigma_id, i, j), y_n) + next_coeff * f_imag, package_imag(sigma_id, i, j), out);
+						continue;
+					}
+#endif
+#endif
+					packed_store_k(f_real, package_real(sigma_id, i, j), out);
+					packed_store_k(f_imag, package_imag(sigma_id, i, j), out);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,26 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+// optional defines: NOMA_NUM_K_STORAGE_HALF, NOMA_NUM_K_STORAGE_BF16 (see k_storage.hpp)
+
+// Prefix of the weighted add kernels custom_rk_stepper generates for its Butcher tableau at runtime (see custom_rk_stepper.cpp),
+// one per stage input, and one for the result, with the non-zero coefficients as constants, e.g. for the third stage of RK4:
+//
+// __kernel void custom_rk_stage_2(const real_t h, __global real_t* out, __global const real_t* y_n, __global const k_real_t* restrict k1)
+// {
+// 	NOMA_NUM_CUSTOM_RK_FOR_EACH_ELEMENT(e)
+// 		out[e] = y_n[e] + h * ((5.0e-01) * NOMA_NUM_LOAD_K(k1, e));
+// }
+//
+// NOTE: out has no restrict, it may alias y_n for in-place steps
+
+// loops over the real and imaginary parts of all elements of the matrix processed by this work-item, skips padded work-items
+#define NOMA_NUM_CUSTOM_RK_FOR_EACH_ELEMENT(e) \
+	const size_t sigma_id = get_global_id(1) * get_global_size(0) + get_global_id(0); \
+	if (sigma_id >= NUM_MATRICES) \
+		return; \
+	for (size_t e = 2 * sigma_id * NUM_STATES * NUM_STATES; e < 2 * (sigma_id + 1) * NUM_STATES * NUM_STATES; ++e)
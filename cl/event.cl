@@ -0,0 +1,204 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES, NOMA_NUM_EVENT_FUNCTION(event, t) (see event_detector.hpp)
+// optional defines: NOMA_NUM_EVENTS, NOMA_NUM_EVENT_MAX_ITERATIONS, NOMA_NUM_EVENT_TOLERANCE
+
+#ifndef NOMA_NUM_EVENTS
+	#define NOMA_NUM_EVENTS 1
+#endif
+
+#ifndef NOMA_NUM_EVENT_MAX_ITERATIONS
+	#define NOMA_NUM_EVENT_MAX_ITERATIONS 32
+#endif
+
+// tolerance of the located event, relative to the step size
+#ifndef NOMA_NUM_EVENT_TOLERANCE
+	#define NOMA_NUM_EVENT_TOLERANCE 1.0e-10
+#endif
+
+// number of complex elements of one state
+#define NOMA_NUM_STATE_DIM (NUM_STATES * NUM_STATES)
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+#define sigma_real(e) (2 * (sigma_id * NOMA_NUM_STATE_DIM + (e)))
+#define sigma_imag(e) (2 * (sigma_id * NOMA_NUM_STATE_DIM + (e)) + 1)
+
+// event directions, see event_direction in event_detector.hpp
+#define NOMA_NUM_EVENT_BOTH 0
+#define NOMA_NUM_EVENT_RISING 1
+#define NOMA_NUM_EVENT_FALLING 2
+
+/**
+ * Element e of the linear interpolant y(theta) = (1 - theta) * y_n + theta * y_np1
+ * of the state processed by this work-item, as a complex_t, for use in
+ * NOMA_NUM_EVENT_FUNCTION.
+ */
+#define NOMA_NUM_EVENT_STATE(e) \
+	((complex_t)((1.0 - theta) * y_n[sigma_real(e)] + theta * y_np1[sigma_real(e)], \
+	             (1.0 - theta) * y_n[sigma_imag(e)] + theta * y_np1[sigma_imag(e)]))
+
+// event function g_event(t, y(theta)) of the state processed by this work-item
+inline real_t event_function(const int_t event, const real_t t, const real_t theta, __global const real_t* y_n, __global const real_t* y_np1)
+{
+	return NOMA_NUM_EVENT_FUNCTION(event, t);
+}
+
+inline bool event_crossed(const int_t direction, const real_t g_a, const real_t g_b)
+{
+	const bool rising = (g_a < 0.0) && (g_b >= 0.0);
+	const bool falling = (g_a > 0.0) && (g_b <= 0.0);
+	return (direction == NOMA_NUM_EVENT_RISING) ? rising : (direction == NOMA_NUM_EVENT_FALLING) ? falling : (rising || falling);
+}
+
+/**
+ * Illinois variant of regula falsi on the interpolant, for a sign change of
+ * g_event between theta = 0 (g_a) and theta = 1 (g_b), returns the
+ * located theta.
+ */
+inline real_t event_locate(const int_t event, const real_t t, const real_t h, real_t g_a, real_t g_b, __global const real_t* y_n, __global const real_t* y_np1)
+{
+	real_t a = 0.0;
+	real_t b = 1.0;
+	int side = 0; // end replaced by the last iteration, -1: b, 1: a
+
+	for (int i = 0; i < NOMA_NUM_EVENT_MAX_ITERATIONS && (b - a) > NOMA_NUM_EVENT_TOLERANCE; ++i)
+	{
+		const real_t c = (a * g_b - b * g_a) / (g_b - g_a);
+		const real_t g_c = event_function(event, t + c * h, c, y_n, y_np1);
+
+		if (g_c * g_b > 0.0) {
+			b = c;
+			g_b = g_c;
+			if (side == -1) // the same end twice in a row, i.e. regula falsi would stall
+				g_a *= 0.5;
+			side = -1;
+		} else if (g_a * g_c > 0.0) {
+			a = c;
+			g_a = g_c;
+			if (side == 1)
+				g_b *= 0.5;
+			side = 1;
+		} else { // exact root
+			return c;
+		}
+	}
+
+	// NOTE: b is on the far side of the sign change, i.e. an event is never reported before it happened
+	return b;
+}
+
+/**
+ * Makes the compile-time problem dimensions available to the host:
+ * dims[0] = NUM_MATRICES, dims[1] = NOMA_NUM_EVENTS
+ */
+__kernel void event_dimensions(__global int_t* dims)
+{
+	if (sigma_id == 0) {
+		dims[0] = NUM_MATRICES;
+		dims[1] = NOMA_NUM_EVENTS;
+	}
+}
+
+/**
+ * Evaluates the event functions of the initial state y at time t, and
+ * unfreezes all systems.
+ */
+__kernel void event_initialise(
+	const real_t t,
+	__global const real_t* restrict y,
+	__global       real_t* restrict g_prev, // NOMA_NUM_EVENTS per system
+	__global       int_t* restrict frozen   // one per system
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const real_t theta = 0.0;
+	for (int_t event = 0; event < NOMA_NUM_EVENTS; ++event)
+		g_prev[sigma_id * NOMA_NUM_EVENTS + event] = event_function(event, t, theta, y, y);
+	frozen[sigma_id] = 0;
+}
+
+/**
+ * Sign-change detection and location of all events in the step from y_n at
+ * t to y_np1 at t + h. The located events are appended to the records, up to
+ * the earliest terminal event of the system. For a terminal event, y_np1 is
+ * set to the interpolated state at the event, and the system is frozen, i.e.
+ * y_np1 = y_n in all later steps.
+ */
+__kernel void event_detect(
+	const real_t t,
+	const real_t h,
+	__global const real_t* restrict y_n,
+	__global       real_t* restrict y_np1,
+	__global       real_t* restrict g_prev,    // NOMA_NUM_EVENTS per system, g at y_n before, at y_np1 afterwards
+	__global       int_t* restrict frozen,     // one per system
+	__global const int_t* restrict config,     // direction and terminal flag, per event
+	__global       int_t* restrict count,      // number of records, appended atomically
+	__global       int_t* restrict record_ids, // system and event, per record
+	__global       real_t* restrict record_thetas
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	if (frozen[sigma_id]) {
+		for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e) {
+			y_np1[sigma_real(e)] = y_n[sigma_real(e)];
+			y_np1[sigma_imag(e)] = y_n[sigma_imag(e)];
+		}
+		return;
+	}
+
+	real_t thetas[NOMA_NUM_EVENTS];
+	real_t g_new[NOMA_NUM_EVENTS];
+	real_t theta_terminal = 2.0; // none
+
+	for (int_t event = 0; event < NOMA_NUM_EVENTS; ++event)
+	{
+		const real_t theta = 1.0;
+		const real_t g_a = g_prev[sigma_id * NOMA_NUM_EVENTS + event];
+		g_new[event] = event_function(event, t + h, theta, y_n, y_np1);
+		thetas[event] = 2.0; // none
+
+		if (event_crossed(config[2 * event], g_a, g_new[event])) {
+			thetas[event] = event_locate(event, t, h, g_a, g_new[event], y_n, y_np1);
+			if (config[2 * event + 1])
+				theta_terminal = fmin(theta_terminal, thetas[event]);
+		}
+	}
+
+	for (int_t event = 0; event < NOMA_NUM_EVENTS; ++event)
+	{
+		if (thetas[event] <= theta_terminal) {
+			const int_t record = atomic_inc(count);
+			record_ids[2 * record] = sigma_id;
+			record_ids[2 * record + 1] = event;
+			record_thetas[record] = thetas[event];
+		}
+	}
+
+	if (theta_terminal <= 1.0) {
+		const real_t theta = theta_terminal;
+		for (int_t event = 0; event < NOMA_NUM_EVENTS; ++event)
+			g_new[event] = event_function(event, t + theta * h, theta, y_n, y_np1);
+
+		// NOTE: element-wise, i.e. the interpolant reads y_np1[e] before it is overwritten
+		for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e) {
+			const complex_t y = NOMA_NUM_EVENT_STATE(e);
+			y_np1[sigma_real(e)] = y.x;
+			y_np1[sigma_imag(e)] = y.y;
+		}
+		frozen[sigma_id] = 1;
+	}
+
+	for (int_t event = 0; event < NOMA_NUM_EVENTS; ++event)
+		g_prev[sigma_id * NOMA_NUM_EVENTS + event] = g_new[event];
+}
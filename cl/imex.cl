@@ -0,0 +1,141 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+// number of complex elements of one state, i.e. dimension of the implicit operator
+#define NOMA_NUM_STATE_DIM (NUM_STATES * NUM_STATES)
+
+// must match imex_stepper's max_stages
+#define NOMA_NUM_IMEX_MAX_STAGES 6
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+
+// values of solve, see imex_stepper.hpp
+#define NOMA_NUM_IMEX_SOLVE_NONE 0
+#define NOMA_NUM_IMEX_SOLVE_DIAGONAL 1
+#define NOMA_NUM_IMEX_SOLVE_DENSE 2
+
+// right-hand side of a stage: y + sum(l)(ce_l * k_e_l + ci_l * k_i_l) at complex element i of the whole buffer,
+// inputs with a zero coefficient are not read
+inline complex_t imex_rhs(const size_t i, __global const real_t* y, const real_t* c, __global const real_t** k)
+{
+	complex_t sum = (complex_t)(y[2 * i], y[2 * i + 1]);
+	for (int l = 0; l < 2 * NOMA_NUM_IMEX_MAX_STAGES; ++l)
+	{
+		if (c[l] != 0.0)
+		{
+			sum.x += c[l] * k[l][2 * i];
+			sum.y += c[l] * k[l][2 * i + 1];
+		}
+	}
+	return sum;
+}
+
+#define NOMA_NUM_IMEX_STAGE_PARAMS \
+	__global       real_t* restrict y_out, \
+	__global       real_t* restrict k_i_out, \
+	__global const real_t* restrict y, \
+	const real_t ce0, __global const real_t* restrict k_e0, \
+	const real_t ce1, __global const real_t* restrict k_e1, \
+	const real_t ce2, __global const real_t* restrict k_e2, \
+	const real_t ce3, __global const real_t* restrict k_e3, \
+	const real_t ce4, __global const real_t* restrict k_e4, \
+	const real_t ce5, __global const real_t* restrict k_e5, \
+	const real_t ci0, __global const real_t* restrict k_i0, \
+	const real_t ci1, __global const real_t* restrict k_i1, \
+	const real_t ci2, __global const real_t* restrict k_i2, \
+	const real_t ci3, __global const real_t* restrict k_i3, \
+	const real_t ci4, __global const real_t* restrict k_i4, \
+	const real_t ci5, __global const real_t* restrict k_i5, \
+	__global const real_t* restrict op, \
+	const real_t gamma_h
+
+#define NOMA_NUM_IMEX_STAGE_INPUTS \
+	const real_t c[] = { ce0, ce1, ce2, ce3, ce4, ce5, ci0, ci1, ci2, ci3, ci4, ci5 }; \
+	__global const real_t* k[] = { k_e0, k_e1, k_e2, k_e3, k_e4, k_e5, k_i0, k_i1, k_i2, k_i3, k_i4, k_i5 };
+
+/**
+ * Stage of an additive (IMEX) Runge-Kutta method, see imex_stepper.hpp:
+ * rhs = y + sum(l)(ce_l * k_e_l + ci_l * k_i_l)
+ * y_out = op * rhs
+ * k_i_out = (y_out - rhs) / gamma_h, i.e. L * y_out, without evaluating L
+ *
+ * with op = (I - gamma_h * L)^-1 of each matrix as row-major
+ * NOMA_NUM_STATE_DIM x NOMA_NUM_STATE_DIM complex matrix, one work-item per
+ * matrix. For diagonal L, and without a solve, see imex_stage_elementwise.
+ */
+__kernel void imex_stage(
+	NOMA_NUM_IMEX_STAGE_PARAMS
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	NOMA_NUM_IMEX_STAGE_INPUTS
+
+	#define state_elem(e) (2 * (sigma_id * NOMA_NUM_STATE_DIM + (e)))
+	#define op_elem(r, c) (2 * ((sigma_id * NOMA_NUM_STATE_DIM + (r)) * NOMA_NUM_STATE_DIM + (c)))
+
+	// keep the right-hand side in registers, the solve reads it once per row
+	complex_t rhs[NOMA_NUM_STATE_DIM];
+	for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e)
+		rhs[e] = imex_rhs(sigma_id * NOMA_NUM_STATE_DIM + e, y, c, k);
+
+	for (int r = 0; r < NOMA_NUM_STATE_DIM; ++r)
+	{
+		complex_t x = (complex_t)(0.0, 0.0);
+		for (int col = 0; col < NOMA_NUM_STATE_DIM; ++col)
+			x = cadd(x, cmult((complex_t)(op[op_elem(r, col)], op[op_elem(r, col) + 1]), rhs[col]));
+
+		y_out[state_elem(r)] = x.x;
+		y_out[state_elem(r) + 1] = x.y;
+		k_i_out[state_elem(r)] = (x.x - rhs[r].x) / gamma_h;
+		k_i_out[state_elem(r) + 1] = (x.y - rhs[r].y) / gamma_h;
+	}
+
+	#undef state_elem
+	#undef op_elem
+}
+
+// complex element processed by this work item, over all matrices
+#define elem_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+
+/**
+ * As imex_stage, for the stages that need no coupling between the elements
+ * of a matrix, i.e. with op holding the diagonal of (I - gamma_h * L)^-1
+ * (solve = NOMA_NUM_IMEX_SOLVE_DIAGONAL), or without a solve, where
+ * y_out = rhs, and k_i_out is not written (solve = NOMA_NUM_IMEX_SOLVE_NONE).
+ *
+ * One work-item per complex element, i.e. the global range is
+ * NUM_MATRICES * NOMA_NUM_STATE_DIM.
+ */
+__kernel void imex_stage_elementwise(
+	NOMA_NUM_IMEX_STAGE_PARAMS,
+	const int_t solve
+)
+{
+	// skip padded work-items
+	if (elem_id >= NUM_MATRICES * NOMA_NUM_STATE_DIM)
+		return;
+
+	NOMA_NUM_IMEX_STAGE_INPUTS
+
+	const complex_t rhs = imex_rhs(elem_id, y, c, k);
+	complex_t x = rhs;
+	if (solve == NOMA_NUM_IMEX_SOLVE_DIAGONAL)
+		x = cmult((complex_t)(op[2 * elem_id], op[2 * elem_id + 1]), rhs);
+
+	y_out[2 * elem_id] = x.x;
+	y_out[2 * elem_id + 1] = x.y;
+	if (solve != NOMA_NUM_IMEX_SOLVE_NONE)
+	{
+		k_i_out[2 * elem_id] = (x.x - rhs.x) / gamma_h;
+		k_i_out[2 * elem_id + 1] = (x.y - rhs.y) / gamma_h;
+	}
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+// number of complex elements of one state
+#define NOMA_NUM_STATE_DIM (NUM_STATES * NUM_STATES)
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+#define sigma_elem(buf, e) ((complex_t)((buf)[2 * (sigma_id * NOMA_NUM_STATE_DIM + (e))], (buf)[2 * (sigma_id * NOMA_NUM_STATE_DIM + (e)) + 1]))
+
+// per-matrix complex coefficients, stride per matrix is passed as argument
+#define coeff_real(i) (2 * (sigma_id * stride + (i)))
+#define coeff_imag(i) (2 * (sigma_id * stride + (i)) + 1)
+
+// NOTE: must be consistent with number of basis vector arguments below
+#define NOMA_NUM_KRYLOV_VECTORS 8
+
+#define NOMA_NUM_KRYLOV_VECTOR_ARGS \
+	__global const real_t* restrict v0, \
+	__global const real_t* restrict v1, \
+	__global const real_t* restrict v2, \
+	__global const real_t* restrict v3, \
+	__global const real_t* restrict v4, \
+	__global const real_t* restrict v5, \
+	__global const real_t* restrict v6, \
+	__global const real_t* restrict v7
+
+/**
+ * Inner products of w with up to NOMA_NUM_KRYLOV_VECTORS basis vectors:
+ * dots(first + l) = <v_l, w>, for l < n
+ */
+__kernel void krylov_dot(
+	__global real_t* restrict dots,
+	const int_t stride,
+	const int_t first,
+	const int_t n,
+	__global const real_t* restrict w,
+	NOMA_NUM_KRYLOV_VECTOR_ARGS
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	__global const real_t* restrict v[] = { v0, v1, v2, v3, v4, v5, v6, v7 };
+
+	complex_t sum[NOMA_NUM_KRYLOV_VECTORS];
+	for (int l = 0; l < NOMA_NUM_KRYLOV_VECTORS; ++l)
+		sum[l] = (complex_t)(0.0, 0.0);
+
+	for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e) {
+		const complex_t w_e = sigma_elem(w, e);
+		for (int l = 0; l < n; ++l)
+			sum[l] = cadd(sum[l], cmult(conj(sigma_elem(v[l], e)), w_e));
+	}
+
+	for (int l = 0; l < n; ++l) {
+		dots[coeff_real(first + l)] = sum[l].x;
+		dots[coeff_imag(first + l)] = sum[l].y;
+	}
+}
+
+/**
+ * Adds a linear combination of up to NOMA_NUM_KRYLOV_VECTORS basis vectors
+ * with per-matrix complex coefficients:
+ * out = (init ? 0 : out) + sign * sum(l < n) coeffs(first + l) * v_l
+ */
+__kernel void krylov_combine(
+	__global real_t* restrict out,
+	const int_t init,
+	const real_t sign,
+	__global const real_t* restrict coeffs,
+	const int_t stride,
+	const int_t first,
+	const int_t n,
+	NOMA_NUM_KRYLOV_VECTOR_ARGS
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	__global const real_t* restrict v[] = { v0, v1, v2, v3, v4, v5, v6, v7 };
+
+	complex_t c[NOMA_NUM_KRYLOV_VECTORS];
+	for (int l = 0; l < n; ++l)
+		c[l] = sign * (complex_t)(coeffs[coeff_real(first + l)], coeffs[coeff_imag(first + l)]);
+
+	for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e) {
+		complex_t sum = init ? (complex_t)(0.0, 0.0) : sigma_elem(out, e);
+		for (int l = 0; l < n; ++l)
+			sum = cadd(sum, cmult(c[l], sigma_elem(v[l], e)));
+		out[2 * (sigma_id * NOMA_NUM_STATE_DIM + e)] = sum.x;
+		out[2 * (sigma_id * NOMA_NUM_STATE_DIM + e) + 1] = sum.y;
+	}
+}
+
+/**
+ * Normalises each state: norms[sigma_id] = ||in||, out = in / ||in||
+ * A zero state stays zero. out may be the same buffer as in.
+ */
+__kernel void krylov_normalise(
+	__global real_t* out,
+	__global real_t* restrict norms,
+	__global const real_t* in
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	real_t sum = 0.0;
+	for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e)
+		sum += cnorm(sigma_elem(in, e));
+
+	const real_t norm = sqrt(sum);
+	const real_t scale = (norm > 0.0) ? 1.0 / norm : 0.0;
+	norms[sigma_id] = norm;
+
+	for (int e = 0; e < 2 * NOMA_NUM_STATE_DIM; ++e)
+		out[2 * sigma_id * NOMA_NUM_STATE_DIM + e] = scale * in[2 * sigma_id * NOMA_NUM_STATE_DIM + e];
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+// Philox4x32-10 counter-based random number generator, and normal variates derived from it
+// J.K. Salmon et al., Parallel random numbers: as easy as 1, 2, 3, SC'11
+// NOTE: expects types.cl to be included before
+
+#define NOMA_NUM_PHILOX_M0 0xD2511F53u
+#define NOMA_NUM_PHILOX_M1 0xCD9E8D57u
+#define NOMA_NUM_PHILOX_W0 0x9E3779B9u
+#define NOMA_NUM_PHILOX_W1 0xBB67AE85u
+
+// encrypts the counter c in place with the key (k0, k1)
+inline void philox4x32_10(uint_t c[4], uint_t k0, uint_t k1)
+{
+	for (int r = 0; r < 10; ++r)
+	{
+		if (r > 0) {
+			k0 += NOMA_NUM_PHILOX_W0;
+			k1 += NOMA_NUM_PHILOX_W1;
+		}
+		const uint_t hi0 = mul_hi(NOMA_NUM_PHILOX_M0, c[0]);
+		const uint_t lo0 = NOMA_NUM_PHILOX_M0 * c[0];
+		const uint_t hi1 = mul_hi(NOMA_NUM_PHILOX_M1, c[2]);
+		const uint_t lo1 = NOMA_NUM_PHILOX_M1 * c[2];
+		c[0] = hi1 ^ c[1] ^ k0;
+		c[1] = lo1;
+		c[2] = hi0 ^ c[3] ^ k1;
+		c[3] = lo0;
+	}
+}
+
+// uniform in (0, 1), i.e. safe for log()
+inline real_t philox_uniform(uint_t x)
+{
+	return ((real_t)x + (real_t)0.5) * (real_t)2.3283064365386963e-10; // 2^-32
+}
+
+// four independent standard normal variates for counter (c0, c1, c2, c3) and key (k0, k1), by Box-Muller
+inline void philox_normal4(real_t n[4], uint_t c0, uint_t c1, uint_t c2, uint_t c3, uint_t k0, uint_t k1)
+{
+	uint_t c[4] = { c0, c1, c2, c3 };
+	philox4x32_10(c, k0, k1);
+
+	for (int i = 0; i < 4; i += 2)
+	{
+		const real_t r = sqrt((real_t)-2.0 * log(philox_uniform(c[i])));
+		const real_t theta = (real_t)6.283185307179586 * philox_uniform(c[i + 1]);
+		n[i] = r * cos(theta);
+		n[i + 1] = r * sin(theta);
+	}
+}
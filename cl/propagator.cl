@@ -0,0 +1,48 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+// number of complex elements of one state, i.e. dimension of the propagator
+#define NOMA_NUM_STATE_DIM (NUM_STATES * NUM_STATES)
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+
+/**
+ * Applies the cached propagator of each matrix to its state:
+ * out = p * in
+ * with p as row-major NOMA_NUM_STATE_DIM x NOMA_NUM_STATE_DIM complex matrix per state.
+ */
+__kernel void propagator_apply(
+	__global       real_t* restrict out,
+	__global const real_t* restrict p,
+	__global const real_t* restrict in
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	#define p_elem(r, c) (2 * ((sigma_id * NOMA_NUM_STATE_DIM + (r)) * NOMA_NUM_STATE_DIM + (c)))
+
+	// keep input state in registers, it is read once per row
+	complex_t x[NOMA_NUM_STATE_DIM];
+	for (int c = 0; c < NOMA_NUM_STATE_DIM; ++c)
+		x[c] = (complex_t)(in[2 * (sigma_id * NOMA_NUM_STATE_DIM + c)], in[2 * (sigma_id * NOMA_NUM_STATE_DIM + c) + 1]);
+
+	for (int r = 0; r < NOMA_NUM_STATE_DIM; ++r) // row
+	{
+		complex_t sum = (complex_t)(0.0, 0.0);
+		for (int c = 0; c < NOMA_NUM_STATE_DIM; ++c) // column
+			sum = cadd(sum, cmult((complex_t)(p[p_elem(r, c)], p[p_elem(r, c) + 1]), x[c]));
+
+		out[2 * (sigma_id * NOMA_NUM_STATE_DIM + r)] = sum.x;
+		out[2 * (sigma_id * NOMA_NUM_STATE_DIM + r) + 1] = sum.y;
+	}
+
+	#undef p_elem
+}
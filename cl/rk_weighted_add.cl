@@ -3,8 +3,10 @@
 // See accompanying file LICENSE and README for further information.
 
 #include "types.cl"
+#include "status.cl"
 
 // expected defines: NUM_MATRICES, NUM_STATES
+// optional defines: NOMA_NUM_K_STORAGE_HALF, NOMA_NUM_K_STORAGE_BF16 (see k_storage.hpp), NOMA_NUM_STATUS (see status_monitor.hpp)
 
 /**
  * computes the weighted sum:
@@ -16,23 +18,27 @@
 __kernel void rk_weighted_add(
 	const int    n,                         // number of terms to add, i.e. coefficients to use
 	const real_t h,                         // step width
-	__global       real_t* restrict out,    // output buffer (accumulated on)
-	__global const real_t* restrict y_n,    // input buffers 
+	__global       real_t* out,             // output buffer, NOTE: no restrict, may alias y_n for in-place steps
+	__global const real_t* y_n,             // input buffer
 	real_t c1,
-	__global const real_t* restrict k1,     // ks as in Runge Kutta methods
+	__global const k_real_t* restrict k1,     // ks as in Runge Kutta methods
 	real_t c2,
-	__global const real_t* restrict k2,
+	__global const k_real_t* restrict k2,
 	real_t c3,
-	__global const real_t* restrict k3,
+	__global const k_real_t* restrict k3,
 	real_t c4,
-	__global const real_t* restrict k4, 
+	__global const k_real_t* restrict k4, 
 	real_t c5,
-	__global const real_t* restrict k5, 
+	__global const k_real_t* restrict k5, 
 	real_t c6,
-	__global const real_t* restrict k6,
+	__global const k_real_t* restrict k6,
 	real_t c7,
-	__global const real_t* restrict k7      // TODO: add more if needed
-
+	__global const k_real_t* restrict k7      // TODO: add more if needed
+#ifdef NOMA_NUM_STATUS
+	,
+	__global real_t* status,                // one status word per work-group, see status.cl
+	__local  real_t* status_local           // one element per work-item
+#endif
 )
 {
 	// sigma matrix id processed by this work item
@@ -40,38 +46,48 @@ __kernel void rk_weighted_add(
 	#define sigma_real(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)))
 	#define sigma_imag(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)) + 1)
 
+#ifdef NOMA_NUM_STATUS
+	// NOTE: padded work-items take part in the work-group reduction
+	real_t status_value = 0.0;
+	if (sigma_id < NUM_MATRICES) {
+#else
 	// skip padded work-items
 	if (sigma_id >= NUM_MATRICES)
 		return;
+#endif
 
 	const real_t c[] = { c1, c2, c3, c4, c5, c6, c7 }; // TODO: add more if needed
-	__global const real_t* restrict k[] = { k1, k2, k3, k4, k5, k6, k7 }; // TODO: add more if needed
+	__global const k_real_t* restrict k[] = { k1, k2, k3, k4, k5, k6, k7 }; // TODO: add more if needed
 
 	// process matrix elements
 	for (int i = 0; i < NUM_STATES; ++i) // row
 	{
 		for (int j = 0; j < NUM_STATES; ++j) // column
 		{
-//			out[sigma_real(i,j)] = y_n[sigma_real(i,j)];
-//			out[sigma_imag(i,j)] = y_n[sigma_imag(i,j)];
-			out[sigma_real(i,j)] = 0.0;
-			out[sigma_imag(i,j)] = 0.0;
-
-			// iterate through coefficients and ks and accumulate them on out
+			// iterate through coefficients and ks and accumulate them privately, such that out is written once, after reading y_n
+			real_t sum_real = 0.0;
+			real_t sum_imag = 0.0;
 			for (int l = 0; l < n; ++l)
 			{
-//				out[sigma_real(i,j)] += h * c[l] * k[l][sigma_real(i,j)];
-//				out[sigma_imag(i,j)] += h * c[l] * k[l][sigma_imag(i,j)];
 				if (c[l] != 0.0) 
 				{
-					out[sigma_real(i,j)] += c[l] * k[l][sigma_real(i,j)];
-					out[sigma_imag(i,j)] += c[l] * k[l][sigma_imag(i,j)];
+					sum_real += c[l] * NOMA_NUM_LOAD_K(k[l], sigma_real(i,j));
+					sum_imag += c[l] * NOMA_NUM_LOAD_K(k[l], sigma_imag(i,j));
 				}
 			}
-			out[sigma_real(i,j)] *= h;
-			out[sigma_imag(i,j)] *= h;
-			out[sigma_real(i,j)] += y_n[sigma_real(i,j)];
-			out[sigma_imag(i,j)] += y_n[sigma_imag(i,j)];
+			const real_t out_real = y_n[sigma_real(i,j)] + h * sum_real;
+			const real_t out_imag = y_n[sigma_imag(i,j)] + h * sum_imag;
+			out[sigma_real(i,j)] = out_real;
+			out[sigma_imag(i,j)] = out_imag;
+#ifdef NOMA_NUM_STATUS
+			status_value = fmax(status_value, fmax(noma_num_status_value(out_real), noma_num_status_value(out_imag)));
+#endif
 		}
 	}
+
+#ifdef NOMA_NUM_STATUS
+	} // sigma_id < NUM_MATRICES
+
+	noma_num_status_merge(status, status_local, status_value);
+#endif
 }
@@ -0,0 +1,60 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+/**
+ * Linear combination of up to five states, i.e. a stage of the
+ * Runge-Kutta-Chebyshev recurrence (see rkc_stepper.hpp):
+ * Y_j = (1 - mu_j - nu_j) * Y_0 + mu_j * Y_(j-1) + nu_j * Y_(j-2) + mu~_j * h * F_(j-1) + gamma~_j * h * F_0
+ * out = c0 * y_0 + c1 * y_jm1 + c2 * y_jm2 + c3 * f_jm1 + c4 * f_0
+ * Inputs with a zero coefficient are not read.
+ */
+__kernel void rkc_stage(
+	__global       real_t* out,             // NOTE: no restrict, may alias y_jm2
+	const real_t c0,
+	__global const real_t* y_0,
+	const real_t c1,
+	__global const real_t* y_jm1,
+	const real_t c2,
+	__global const real_t* y_jm2,
+	const real_t c3,
+	__global const real_t* f_jm1,
+	const real_t c4,
+	__global const real_t* f_0
+)
+{
+	// sigma matrix id processed by this work item
+	#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+	#define sigma_real(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)))
+	#define sigma_imag(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)) + 1)
+
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const real_t c[] = { c0, c1, c2, c3, c4 };
+	__global const real_t* in[] = { y_0, y_jm1, y_jm2, f_jm1, f_0 };
+
+	for (int i = 0; i < NUM_STATES; ++i) // row
+	{
+		for (int j = 0; j < NUM_STATES; ++j) // column
+		{
+			real_t sum_real = 0.0;
+			real_t sum_imag = 0.0;
+			for (int l = 0; l < 5; ++l)
+			{
+				if (c[l] != 0.0)
+				{
+					sum_real += c[l] * in[l][sigma_real(i,j)];
+					sum_imag += c[l] * in[l][sigma_imag(i,j)];
+				}
+			}
+			out[sigma_real(i,j)] = sum_real;
+			out[sigma_imag(i,j)] = sum_imag;
+		}
+	}
+}
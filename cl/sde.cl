@@ -0,0 +1,92 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+#include "philox.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+/**
+ * computes the weighted sum with noise, element-wise for diagonal noise:
+ * out = y_n + h * (c1 * k1 + c2 * k2)
+ *           + sqrt(h) * g1 * (a1 * xi + b1 * zeta + m1 * (xi^2 - 1) + d1)
+ *           + sqrt(h) * g2 * (a2 * xi + b2 * zeta + m2 * (xi^2 - 1) + d2)
+ *
+ * xi and zeta are independent standard normal variates per real state
+ * element, generated by Philox4x32-10 with the counter (step, element, stream)
+ * and the key (trajectory, seed), where trajectory = trajectory_offset + sigma
+ * matrix id. The same arguments always yield the same noise, i.e. all kernel
+ * calls of a step see the same Wiener increment xi * sqrt(h), without storing
+ * it. Noise is only generated if a coefficient of xi or zeta is non-zero.
+ */
+__kernel void sde_weighted_add(
+	const int    n,                         // number of drift terms to add, i.e. coefficients to use
+	const real_t h,                         // step width
+	__global       real_t* out,             // output buffer, NOTE: no restrict, may alias y_n for in-place steps
+	__global const real_t* y_n,             // input buffer
+	real_t c1,
+	__global const real_t* restrict k1,     // drift evaluations
+	real_t c2,
+	__global const real_t* restrict k2,
+	__global const real_t* restrict g1,     // diffusion evaluations
+	real_t a1, real_t b1, real_t m1, real_t d1,
+	__global const real_t* restrict g2,
+	real_t a2, real_t b2, real_t m2, real_t d2,
+	const uint_t seed,
+	const uint_t trajectory_offset,
+	const uint_t step_lo,                   // 64 bit step counter
+	const uint_t step_hi
+)
+{
+	// sigma matrix id processed by this work item
+	#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const int num_elements = 2 * NUM_STATES * NUM_STATES; // real elements per matrix
+	const size_t base = sigma_id * num_elements;
+	const uint_t trajectory = trajectory_offset + (uint_t)sigma_id;
+
+	const real_t c[] = { c1, c2 };
+	__global const real_t* restrict k[] = { k1, k2 };
+
+	const real_t sqrt_h = sqrt(h);
+	const bool need_xi = (a1 != 0.0 || m1 != 0.0 || a2 != 0.0 || m2 != 0.0);
+	const bool need_zeta = (b1 != 0.0 || b2 != 0.0);
+	const bool need_g1 = (a1 != 0.0 || b1 != 0.0 || m1 != 0.0 || d1 != 0.0);
+	const bool need_g2 = (a2 != 0.0 || b2 != 0.0 || m2 != 0.0 || d2 != 0.0);
+
+	real_t xi[4] = { 0.0, 0.0, 0.0, 0.0 };
+	real_t zeta[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+	// process blocks of four elements, one Philox call per block and variate
+	for (int block = 0; block < num_elements; block += 4)
+	{
+		if (need_xi)
+			philox_normal4(xi, step_lo, step_hi, (uint_t)block, 0u, trajectory, seed);
+		if (need_zeta)
+			philox_normal4(zeta, step_lo, step_hi, (uint_t)block, 1u, trajectory, seed);
+
+		for (int l = 0; l < 4 && block + l < num_elements; ++l)
+		{
+			const size_t e = base + block + l;
+
+			real_t sum = 0.0;
+			for (int i = 0; i < n; ++i)
+				if (c[i] != 0.0)
+					sum += c[i] * k[i][e];
+			sum *= h;
+
+			const real_t xi2_minus_1 = xi[l] * xi[l] - (real_t)1.0;
+			if (need_g1)
+				sum += sqrt_h * g1[e] * (a1 * xi[l] + b1 * zeta[l] + m1 * xi2_minus_1 + d1);
+			if (need_g2)
+				sum += sqrt_h * g2[e] * (a2 * xi[l] + b2 * zeta[l] + m2 * xi2_minus_1 + d2);
+
+			out[e] = y_n[e] + sum;
+		}
+	}
+}
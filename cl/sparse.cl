@@ -0,0 +1,217 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+// optional defines: NOMA_NUM_ODE_ACCUMULATE, NOMA_NUM_SUBDIAGONAL (see the steppers' ode_compile_options())
+//                   NOMA_NUM_K_STORAGE_HALF, NOMA_NUM_K_STORAGE_BF16, format of out (see k_storage.hpp)
+
+// number of complex elements of one state
+#define NOMA_NUM_STATE_DIM (NUM_STATES * NUM_STATES)
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+
+// additional kernel parameters and arguments for the accumulate methods
+#if defined(NOMA_NUM_SUBDIAGONAL)
+	#define NOMA_NUM_ACCUMULATE_PARAMS , __global real_t* acc, const real_t acc_coeff, const int_t init, __global const real_t* y_n, const real_t next_coeff, const int_t next
+	#define NOMA_NUM_ACCUMULATE_ARGS , acc, acc_coeff, init, y_n, next_coeff, next
+#elif defined(NOMA_NUM_ODE_ACCUMULATE)
+	#define NOMA_NUM_ACCUMULATE_PARAMS , __global real_t* acc, const real_t acc_coeff, const int_t init
+	#define NOMA_NUM_ACCUMULATE_ARGS , acc, acc_coeff, init
+#else
+	#define NOMA_NUM_ACCUMULATE_PARAMS
+	#define NOMA_NUM_ACCUMULATE_ARGS
+#endif
+
+/**
+ * Writes the value f of the ODE right-hand side for state element e, depending on the defines from the stepper:
+ * default:                 out = f
+ * NOMA_NUM_ODE_ACCUMULATE: out = f, acc = (init ? in : acc) + acc_coeff * f
+ * NOMA_NUM_SUBDIAGONAL:    as above, but out = y_n + next_coeff * f if next is set, i.e. out is the input of the next stage
+ */
+inline void sparse_store(__global k_real_t* out, __global const real_t* in, const int e, const complex_t f NOMA_NUM_ACCUMULATE_PARAMS)
+{
+#ifdef NOMA_NUM_ODE_ACCUMULATE
+	const real_t acc_real = init ? in[2 * e] : acc[2 * e];
+	const real_t acc_imag = init ? in[2 * e + 1] : acc[2 * e + 1];
+	acc[2 * e] = acc_real + acc_coeff * f.x;
+	acc[2 * e + 1] = acc_imag + acc_coeff * f.y;
+#ifdef NOMA_NUM_SUBDIAGONAL
+	if (next) {
+		out[2 * e] = y_n[2 * e] + next_coeff * f.x;
+		out[2 * e + 1] = y_n[2 * e + 1] + next_coeff * f.y;
+		return;
+	}
+#endif
+#endif
+	NOMA_NUM_STORE_K(out, 2 * e, f.x);
+	NOMA_NUM_STORE_K(out, 2 * e + 1, f.y);
+}
+
+// complex fused multiply-add: acc + a * b
+inline complex_t sparse_cmad(complex_t a, complex_t b, complex_t acc)
+{
+	return (complex_t)(acc.x + a.x * b.x - a.y * b.y, acc.y + a.x * b.y + a.y * b.x);
+}
+
+// NOTE: the *_row_product() functions compute sum_k a_rk * sigma[offset + k * k_stride]:
+//       k_stride = NUM_STATES, offset = j:              (a * sigma)_rj
+//       k_stride = 1,          offset = i * NUM_STATES: (sigma * a^T)_ir
+
+inline complex_t csr_row_product(__global const int_t* row_ptr, __global const int_t* col_idx, __global const real_t* values,
+                                 const int r, __global const real_t* sigma, const int k_stride, const int offset)
+{
+	complex_t sum = (complex_t)(0.0, 0.0);
+	for (int e = row_ptr[r]; e < row_ptr[r + 1]; ++e) {
+		const int s = 2 * (offset + col_idx[e] * k_stride);
+		sum = sparse_cmad((complex_t)(values[2 * e], values[2 * e + 1]), (complex_t)(sigma[s], sigma[s + 1]), sum);
+	}
+	return sum;
+}
+
+inline complex_t ell_row_product(const int_t width, __global const int_t* col_idx, __global const real_t* values,
+                                 const int r, __global const real_t* sigma, const int k_stride, const int offset)
+{
+	complex_t sum = (complex_t)(0.0, 0.0);
+	for (int k = 0; k < width; ++k) {
+		const int e = r * width + k;
+		const int s = 2 * (offset + col_idx[e] * k_stride);
+		sum = sparse_cmad((complex_t)(values[2 * e], values[2 * e + 1]), (complex_t)(sigma[s], sigma[s + 1]), sum);
+	}
+	return sum;
+}
+
+// NOTE: values are per matrix, entry e of matrix m is at e * NUM_MATRICES + m
+inline complex_t sliced_ell_row_product(const int_t slice_size, __global const int_t* slice_ptr, __global const int_t* slice_width, __global const int_t* col_idx, __global const real_t* values,
+                                        const int r, __global const real_t* sigma, const int k_stride, const int offset)
+{
+	const int slice = r / slice_size;
+	const int row_in_slice = r % slice_size;
+	complex_t sum = (complex_t)(0.0, 0.0);
+	for (int k = 0; k < slice_width[slice]; ++k) {
+		const int e = slice_ptr[slice] + k * slice_size + row_in_slice;
+		const int v = 2 * (e * NUM_MATRICES + sigma_id);
+		const int s = 2 * (offset + col_idx[e] * k_stride);
+		sum = sparse_cmad((complex_t)(values[v], values[v + 1]), (complex_t)(sigma[s], sigma[s + 1]), sum);
+	}
+	return sum;
+}
+
+/**
+ * Sparse operator ODE right-hand sides, one state per work-item:
+ *
+ * f(in) = alpha * (a * in + sign * in * a)
+ *
+ * sign = 0:              sparse times dense matrix product (at is not accessed)
+ * sign = -1, alpha = -i: commutator, i.e. von Neumann equation
+ * sign = +1:             anticommutator
+ *
+ * at must be the transpose of a in the same format, such that in * a can be
+ * computed from rows as well.
+ */
+__kernel void sparse_csr_operator(
+	__global       k_real_t* restrict out,
+	__global const real_t* restrict in,
+	__global const int_t* restrict a_row_ptr,
+	__global const int_t* restrict a_col_idx,
+	__global const real_t* restrict a_values,
+	__global const int_t* restrict at_row_ptr,
+	__global const int_t* restrict at_col_idx,
+	__global const real_t* restrict at_values,
+	const real_t alpha_real,
+	const real_t alpha_imag,
+	const real_t sign
+	NOMA_NUM_ACCUMULATE_PARAMS
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const complex_t alpha = (complex_t)(alpha_real, alpha_imag);
+	__global const real_t* sigma = in + 2 * sigma_id * NOMA_NUM_STATE_DIM;
+
+	for (int i = 0; i < NUM_STATES; ++i) {
+		for (int j = 0; j < NUM_STATES; ++j) {
+			complex_t f = csr_row_product(a_row_ptr, a_col_idx, a_values, i, sigma, NUM_STATES, j);
+			if (sign != 0.0)
+				f += sign * csr_row_product(at_row_ptr, at_col_idx, at_values, j, sigma, 1, i * NUM_STATES);
+
+			sparse_store(out, in, sigma_id * NOMA_NUM_STATE_DIM + i * NUM_STATES + j, cmult(alpha, f) NOMA_NUM_ACCUMULATE_ARGS);
+		}
+	}
+}
+
+// same as sparse_csr_operator(), for ELLPACK
+__kernel void sparse_ell_operator(
+	__global       k_real_t* restrict out,
+	__global const real_t* restrict in,
+	const int_t a_width,
+	__global const int_t* restrict a_col_idx,
+	__global const real_t* restrict a_values,
+	const int_t at_width,
+	__global const int_t* restrict at_col_idx,
+	__global const real_t* restrict at_values,
+	const real_t alpha_real,
+	const real_t alpha_imag,
+	const real_t sign
+	NOMA_NUM_ACCUMULATE_PARAMS
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const complex_t alpha = (complex_t)(alpha_real, alpha_imag);
+	__global const real_t* sigma = in + 2 * sigma_id * NOMA_NUM_STATE_DIM;
+
+	for (int i = 0; i < NUM_STATES; ++i) {
+		for (int j = 0; j < NUM_STATES; ++j) {
+			complex_t f = ell_row_product(a_width, a_col_idx, a_values, i, sigma, NUM_STATES, j);
+			if (sign != 0.0)
+				f += sign * ell_row_product(at_width, at_col_idx, at_values, j, sigma, 1, i * NUM_STATES);
+
+			sparse_store(out, in, sigma_id * NOMA_NUM_STATE_DIM + i * NUM_STATES + j, cmult(alpha, f) NOMA_NUM_ACCUMULATE_ARGS);
+		}
+	}
+}
+
+// same as sparse_csr_operator(), for sliced ELLPACK with separate values per matrix
+__kernel void sparse_sliced_ell_operator(
+	__global       k_real_t* restrict out,
+	__global const real_t* restrict in,
+	const int_t slice_size,
+	__global const int_t* restrict a_slice_ptr,
+	__global const int_t* restrict a_slice_width,
+	__global const int_t* restrict a_col_idx,
+	__global const real_t* restrict a_values,
+	__global const int_t* restrict at_slice_ptr,
+	__global const int_t* restrict at_slice_width,
+	__global const int_t* restrict at_col_idx,
+	__global const real_t* restrict at_values,
+	const real_t alpha_real,
+	const real_t alpha_imag,
+	const real_t sign
+	NOMA_NUM_ACCUMULATE_PARAMS
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	const complex_t alpha = (complex_t)(alpha_real, alpha_imag);
+	__global const real_t* sigma = in + 2 * sigma_id * NOMA_NUM_STATE_DIM;
+
+	for (int i = 0; i < NUM_STATES; ++i) {
+		for (int j = 0; j < NUM_STATES; ++j) {
+			complex_t f = sliced_ell_row_product(slice_size, a_slice_ptr, a_slice_width, a_col_idx, a_values, i, sigma, NUM_STATES, j);
+			if (sign != 0.0)
+				f += sign * sliced_ell_row_product(slice_size, at_slice_ptr, at_slice_width, at_col_idx, at_values, j, sigma, 1, i * NUM_STATES);
+
+			sparse_store(out, in, sigma_id * NOMA_NUM_STATE_DIM + i * NUM_STATES + j, cmult(alpha, f) NOMA_NUM_ACCUMULATE_ARGS);
+		}
+	}
+}
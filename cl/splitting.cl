@@ -0,0 +1,44 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+/**
+ * Updates one half of a partitioned state in place:
+ * y[half] = y[half] + h * k
+ *
+ * The state buffer holds the positions of all NUM_MATRICES systems in its
+ * first half (half = 0), and the momenta in its second half (half = 1), each
+ * in the usual layout of NUM_STATES x NUM_STATES complex matrices. k has the
+ * size of one half.
+ */
+__kernel void splitting_update(
+	__global       real_t* restrict y,      // partitioned state, updated in place
+	const int    half,                      // 0: positions, 1: momenta
+	const real_t h,                         // coefficient times step width
+	__global const real_t* restrict k       // derivative of the updated half
+)
+{
+	// sigma matrix id processed by this work item
+	#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+	#define sigma_real(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)))
+	#define sigma_imag(i, j) (2 * (sigma_id * NUM_STATES * NUM_STATES + (i) * NUM_STATES + (j)) + 1)
+
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	__global real_t* restrict y_half = y + half * 2 * NUM_MATRICES * NUM_STATES * NUM_STATES;
+
+	for (int i = 0; i < NUM_STATES; ++i) // row
+	{
+		for (int j = 0; j < NUM_STATES; ++j) // column
+		{
+			y_half[sigma_real(i,j)] += h * k[sigma_real(i,j)];
+			y_half[sigma_imag(i,j)] += h * k[sigma_imag(i,j)];
+		}
+	}
+}
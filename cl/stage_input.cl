@@ -0,0 +1,60 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+// Stage input of accumulate_method::fused (see rk_stepper.hpp), formed by the ODE kernel while loading its input:
+// in = y_n + stage_h * sum(l)(stage_c_l * stage_k_l), for l < stage_n
+// i.e. the kernel's input buffer holds y_n, and the stepper needs no weighted add kernel, and no temporary stage input buffer.
+//
+// Usage in an ODE kernel:
+// - NOMA_NUM_STAGE_PARAMS at the end of the parameter list, see stage_input.hpp for the host side
+// - NOMA_NUM_LOAD_INPUT(in, i) instead of in[i] for every load of the input, each call reads y_n and all ks at i,
+//   i.e. kernels that load an element more than once should form it once into private or local memory
+// - for NOMA_NUM_ODE_ACCUMULATE with init, acc is initialised from in[i] as usual, i.e. from y_n
+//
+// NOTE: expects types.cl to be included before
+
+#define NOMA_NUM_STAGE_MAX_KS 7 // must match stage_input::max_ks
+
+#ifdef NOMA_NUM_ODE_FUSED
+
+#define NOMA_NUM_STAGE_PARAMS \
+	, const real_t stage_h, const int_t stage_n, \
+	const real_t stage_c1, __global const k_real_t* restrict stage_k1, \
+	const real_t stage_c2, __global const k_real_t* restrict stage_k2, \
+	const real_t stage_c3, __global const k_real_t* restrict stage_k3, \
+	const real_t stage_c4, __global const k_real_t* restrict stage_k4, \
+	const real_t stage_c5, __global const k_real_t* restrict stage_k5, \
+	const real_t stage_c6, __global const k_real_t* restrict stage_k6, \
+	const real_t stage_c7, __global const k_real_t* restrict stage_k7
+
+#define NOMA_NUM_STAGE_ARGS \
+	, stage_h, stage_n, stage_c1, stage_k1, stage_c2, stage_k2, stage_c3, stage_k3, stage_c4, stage_k4, stage_c5, stage_k5, stage_c6, stage_k6, stage_c7, stage_k7
+
+// accumulates c * k[i], unless the coefficient is zero, or l is not used by the stage
+#define NOMA_NUM_STAGE_TERM(l) \
+	if (l <= stage_n && stage_c ## l != 0.0) \
+		sum += stage_c ## l * NOMA_NUM_LOAD_K(stage_k ## l, i);
+
+inline real_t noma_num_stage_input(__global const real_t* in, const size_t i NOMA_NUM_STAGE_PARAMS)
+{
+	real_t sum = 0.0;
+	NOMA_NUM_STAGE_TERM(1)
+	NOMA_NUM_STAGE_TERM(2)
+	NOMA_NUM_STAGE_TERM(3)
+	NOMA_NUM_STAGE_TERM(4)
+	NOMA_NUM_STAGE_TERM(5)
+	NOMA_NUM_STAGE_TERM(6)
+	NOMA_NUM_STAGE_TERM(7)
+	return in[i] + stage_h * sum;
+}
+
+#define NOMA_NUM_LOAD_INPUT(in, i) noma_num_stage_input((in), (i) NOMA_NUM_STAGE_ARGS)
+
+#else
+
+#define NOMA_NUM_STAGE_PARAMS
+#define NOMA_NUM_STAGE_ARGS
+#define NOMA_NUM_LOAD_INPUT(in, i) ((in)[i])
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+// number of complex elements of one state
+#define NOMA_NUM_STATE_DIM (NUM_STATES * NUM_STATES)
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+#define sigma_real(e) (2 * (sigma_id * NOMA_NUM_STATE_DIM + (e)))
+#define sigma_imag(e) (2 * (sigma_id * NOMA_NUM_STATE_DIM + (e)) + 1)
+
+/**
+ * Makes the compile-time problem dimensions available to the host:
+ * dims[0] = NUM_MATRICES, dims[1] = NUM_STATES
+ */
+__kernel void state_dimensions(__global int_t* dims)
+{
+	if (sigma_id == 0) {
+		dims[0] = NUM_MATRICES;
+		dims[1] = NUM_STATES;
+	}
+}
+
+/**
+ * Sets every state to the j-th unit basis vector of the state space.
+ */
+__kernel void state_set_basis(
+	__global real_t* restrict out,
+	const int_t j
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e) {
+		out[sigma_real(e)] = (e == j) ? 1.0 : 0.0;
+		out[sigma_imag(e)] = 0.0;
+	}
+}
+
+/**
+ * out = alpha * in
+ */
+__kernel void state_scale(
+	__global       real_t* restrict out,
+	const real_t alpha,
+	__global const real_t* restrict in
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e) {
+		out[sigma_real(e)] = alpha * in[sigma_real(e)];
+		out[sigma_imag(e)] = alpha * in[sigma_imag(e)];
+	}
+}
+
+/**
+ * Squared 2-norm of each state: norms[sigma_id] = sum |in_e|^2
+ */
+__kernel void state_norm2(
+	__global       real_t* restrict norms,
+	__global const real_t* restrict in
+)
+{
+	// skip padded work-items
+	if (sigma_id >= NUM_MATRICES)
+		return;
+
+	real_t sum = 0.0;
+	for (int e = 0; e < NOMA_NUM_STATE_DIM; ++e)
+		sum += cnorm((complex_t)(in[sigma_real(e)], in[sigma_imag(e)]));
+
+	norms[sigma_id] = sum;
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+// Status word of state buffers, i.e. the max. norm of all elements, with NaN and Inf mapped to INFINITY,
+// computed on the fly by kernels that write states anyway, see status_monitor.hpp
+// NOTE: expects types.cl to be included before
+
+// status of a single element
+inline real_t noma_num_status_value(const real_t x)
+{
+	return isfinite(x) ? fabs(x) : INFINITY;
+}
+
+/**
+ * Reduces the per work-item status values of a work-group in local memory,
+ * and merges the result into the group's status word, i.e. status keeps the
+ * max. over all launches until it is reset by status_reduce.
+ *
+ * NOTE: must be reached by all work-items of the work-group, including padded
+ *       ones, which pass 0.0
+ * NOTE: status_local needs one element per work-item of the work-group
+ */
+inline void noma_num_status_merge(__global real_t* status, __local real_t* status_local, const real_t value)
+{
+	const size_t local_size = get_local_size(0) * get_local_size(1);
+	const size_t local_id = get_local_id(1) * get_local_size(0) + get_local_id(0);
+
+	status_local[local_id] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// tree reduction, also for non-power-of-two work-group sizes
+	for (size_t stride = 1; stride < local_size; stride *= 2)
+	{
+		if ((local_id % (2 * stride)) == 0 && (local_id + stride) < local_size)
+			status_local[local_id] = fmax(status_local[local_id], status_local[local_id + stride]);
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (local_id == 0) {
+		const size_t group_id = get_group_id(1) * get_num_groups(0) + get_group_id(0);
+		status[group_id] = fmax(status[group_id], status_local[0]);
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "types.cl"
+#include "status.cl"
+
+// expected defines: NUM_MATRICES, NUM_STATES
+
+// number of real elements of one state
+#define NOMA_NUM_STATE_REALS (2 * NUM_STATES * NUM_STATES)
+
+// sigma matrix id processed by this work item
+#define sigma_id (get_global_id(1) * get_global_size(0) + get_global_id(0))
+
+/**
+ * Reduces the n per work-group status words to result[0], and resets them.
+ * NOTE: run by a single work-item, n is small compared to the state size
+ */
+__kernel void status_reduce(
+	const int_t n,
+	__global real_t* restrict status,
+	__global real_t* restrict result
+)
+{
+	real_t value = 0.0;
+	for (int_t i = 0; i < n; ++i) {
+		value = fmax(value, status[i]);
+		status[i] = 0.0;
+	}
+	result[0] = value;
+}
+
+/**
+ * Computes the status of a complete state buffer, for steppers without a
+ * fused status computation, see status_monitor::scan()
+ */
+__kernel void status_scan(
+	__global const real_t* restrict in,
+	__global       real_t* status,
+	__local        real_t* status_local
+)
+{
+	real_t value = 0.0;
+
+	// NOTE: padded work-items take part in the work-group reduction
+	if (sigma_id < NUM_MATRICES) {
+		for (int e = 0; e < NOMA_NUM_STATE_REALS; ++e)
+			value = fmax(value, noma_num_status_value(in[sigma_id * NOMA_NUM_STATE_REALS + e]));
+	}
+
+	noma_num_status_merge(status, status_local, value);
+}
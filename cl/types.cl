@@ -60,3 +60,25 @@ inline real_t cnorm(complex_t a) // TODO: decide whether to apply sqrt(..) here
 	return a.x * a.x + a.y * a.y;
 }
 
+
+// storage format of the Runge-Kutta stage derivatives (k buffers), see k_storage.hpp
+// NOTE: ODE kernels declare their output as __global k_real_t*, and write it by NOMA_NUM_STORE_K()
+#if defined(NOMA_NUM_K_STORAGE_HALF)
+	typedef half k_real_t;
+	#define NOMA_NUM_LOAD_K(p, i) ((real_t)vload_half((i), (p)))
+	#define NOMA_NUM_STORE_K(p, i, value) vstore_half((value), (i), (p))
+#elif defined(NOMA_NUM_K_STORAGE_BF16)
+	typedef ushort k_real_t;
+	// round to nearest even
+	inline ushort noma_num_float_to_bf16(float value)
+	{
+		const uint bits = as_uint(value);
+		return (ushort)((bits + 0x7FFFu + ((bits >> 16) & 1u)) >> 16);
+	}
+	#define NOMA_NUM_LOAD_K(p, i) ((real_t)as_float((uint)(p)[i] << 16))
+	#define NOMA_NUM_STORE_K(p, i, value) ((p)[i] = noma_num_float_to_bf16((float)(value)))
+#else
+	typedef real_t k_real_t;
+	#define NOMA_NUM_LOAD_K(p, i) ((p)[i])
+	#define NOMA_NUM_STORE_K(p, i, value) ((p)[i] = (value))
+#endif
@@ -0,0 +1,221 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_autotuner_hpp
+#define noma_num_autotuner_hpp
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/make_stepper.hpp"
+#include "noma/num/meta_stepper.hpp"
+#include "noma/num/stepper_type.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * One point of the autotuning search space.
+ */
+struct tuning_config
+{
+	stepper_type_t stepper_type; // an accumulate variant of the requested stepper type
+	size_t local_size; // work-group size, 0 means implementation-defined
+	size_t vec_length; // VEC_LENGTH define, see types.cl
+};
+
+std::ostream& operator<<(std::ostream& out, const tuning_config& config);
+
+/**
+ * Search space and measurement parameters of autotune().
+ */
+struct tuning_options
+{
+	std::vector<size_t> local_sizes { 0, 16, 32, 64, 128, 256 };
+	std::vector<size_t> vec_lengths { 2, 4, 8, 16 }; // NOTE: OpenCL vector widths only, only the first one is used unless vectorised_work_items is set
+	bool tune_accumulate_method = true; // try all accumulate variants in the registry
+	bool vectorised_work_items = false; // the ODE processes vec_length matrices per work-item, i.e. uses num_matrices / vec_length work-items
+	size_t warmup_steps = 2;
+	size_t steps = 10;
+	std::ostream* log = nullptr; // per candidate timings, if set
+};
+
+/**
+ * File cache of autotuning results, one line per key, keyed by device, problem
+ * shape, and requested stepper type.
+ */
+class tuning_cache
+{
+public:
+	explicit tuning_cache(const boost::filesystem::path& file_name); // loads file_name, if it exists
+
+	bool lookup(const std::string& key, tuning_config& config) const;
+	void store(const std::string& key, const tuning_config& config); // updates the file
+
+	static std::string make_key(ocl::helper& ocl, size_t num_matrices, size_t num_states, stepper_type_t stepper_type);
+
+private:
+	void save() const;
+
+	boost::filesystem::path file_name_;
+	std::map<std::string, tuning_config> entries_;
+};
+
+// registry entries that only differ from stepper_type in the accumulate method, including stepper_type itself
+std::vector<stepper_type_t> accumulate_variants(stepper_type_t stepper_type);
+
+// creates an ODE for the complete source_header, i.e. including VEC_LENGTH and the stepper's ODE compile options, and range
+template<typename ODE>
+using ode_factory = std::function<std::unique_ptr<ODE>(const std::string& source_header, const ocl::nd_range& range)>;
+
+/**
+ * A meta_stepper together with the ODE, range and source header it was
+ * created with.
+ */
+template<typename ODE>
+struct autotuned_stepper
+{
+	tuning_config config;
+	std::string source_header;
+	ocl::nd_range range;
+	std::unique_ptr<ODE> ode;
+	std::unique_ptr<meta_stepper> stepper; // NOTE: references *ode
+};
+
+namespace detail {
+
+inline ocl::nd_range tuning_range(size_t num_matrices, const tuning_config& config, const tuning_options& options)
+{
+	size_t work_items = options.vectorised_work_items ? (num_matrices + config.vec_length - 1) / config.vec_length : num_matrices;
+	if (config.local_size > 0) // round up to a multiple of the work-group size, the kernels skip padded work-items
+		work_items = (work_items + config.local_size - 1) / config.local_size * config.local_size;
+
+	return ocl::nd_range(cl::NDRange(work_items), config.local_size > 0 ? cl::NDRange(config.local_size) : cl::NullRange);
+}
+
+template<typename ODE>
+autotuned_stepper<ODE> make_tuned_stepper(const tuning_config& config, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options,
+                                          size_t num_matrices, const ode_factory<ODE>& factory, const tuning_options& options)
+{
+	autotuned_stepper<ODE> result;
+	result.config = config;
+
+	std::stringstream header;
+	header << "#define VEC_LENGTH " << config.vec_length << "\n";
+	make_stepper_ode_compile_option<ODE, meta_stepper>(config.stepper_type, header);
+	header << source_header;
+	result.source_header = header.str();
+
+	result.range = tuning_range(num_matrices, config, options);
+	result.ode = factory(result.source_header, result.range);
+	result.stepper.reset(new meta_stepper(config.stepper_type, ocl, result.source_header, ocl_compile_options, result.range, *result.ode));
+
+	return result;
+}
+
+// wall-clock seconds per step, including all kernels of the ODE and the stepper
+template<typename ODE>
+double measure(autotuned_stepper<ODE>& candidate, ocl::helper& ocl, const tuning_options& options)
+{
+	cl::Buffer in = ocl.create_buffer(CL_MEM_READ_WRITE, candidate.ode->buffer_size_byte(), nullptr);
+	cl::Buffer out = ocl.create_buffer(CL_MEM_READ_WRITE, candidate.ode->buffer_size_byte(), nullptr);
+	cl_int err = ocl.command_queue().enqueueFillBuffer(in, static_cast<cl_uint>(0), 0, candidate.ode->buffer_size_byte());
+	ocl::error_handler(err, "clEnqueueFillBuffer(in)");
+
+	const real_t step_size = 1.0e-3;
+	for (size_t i = 0; i < options.warmup_steps; ++i)
+		candidate.stepper->step(0.0, step_size, in, out);
+	ocl.command_queue().finish();
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < options.steps; ++i) {
+		candidate.stepper->step(0.0, step_size, in, out);
+		std::swap(in, out);
+	}
+	ocl.command_queue().finish();
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	return elapsed.count() / static_cast<double>(std::max(options.steps, static_cast<size_t>(1)));
+}
+
+} // namespace detail
+
+/**
+ * Creates a meta_stepper for stepper_type with an autotuned configuration:
+ * the work-group size, VEC_LENGTH, and (optionally) the accumulate method are
+ * chosen by short calibration runs of every candidate, unless the cache has an
+ * entry for this device, problem shape, and stepper type. The winner is stored
+ * in the cache.
+ *
+ * Candidates that fail to build or run, e.g. due to unsupported work-group
+ * sizes, are skipped.
+ *
+ * NOTE: The calibration runs use wall-clock time per step, as kernel_stats()
+ *       only covers the stepper's own kernel, not the ODE evaluations.
+ */
+template<typename ODE>
+autotuned_stepper<ODE> autotune(stepper_type_t stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options,
+                                size_t num_matrices, size_t num_states, const ode_factory<ODE>& factory,
+                                tuning_cache* cache = nullptr, const tuning_options& options = tuning_options())
+{
+	const std::string key = tuning_cache::make_key(ocl, num_matrices, num_states, stepper_type);
+
+	tuning_config config;
+	if (cache && cache->lookup(key, config))
+		return detail::make_tuned_stepper<ODE>(config, ocl, source_header, ocl_compile_options, num_matrices, factory, options);
+
+	const std::vector<stepper_type_t> stepper_types = options.tune_accumulate_method ? accumulate_variants(stepper_type) : std::vector<stepper_type_t> { stepper_type };
+
+	// VEC_LENGTH changes the work distribution of vectorised ODEs only, otherwise all candidates would be the same
+	const std::vector<size_t> vec_lengths = (options.vectorised_work_items || options.vec_lengths.empty()) ? options.vec_lengths : std::vector<size_t> { options.vec_lengths.front() };
+
+	double best_time = std::numeric_limits<double>::max();
+	bool found = false;
+	for (stepper_type_t type : stepper_types) {
+		for (size_t vec_length : vec_lengths) {
+			for (size_t local_size : options.local_sizes) {
+				const tuning_config candidate_config { type, local_size, vec_length };
+				try {
+					autotuned_stepper<ODE> candidate = detail::make_tuned_stepper<ODE>(candidate_config, ocl, source_header, ocl_compile_options, num_matrices, factory, options);
+					const double time = detail::measure(candidate, ocl, options);
+					if (options.log)
+						*options.log << "autotune(): " << candidate_config << ": " << time << " s/step" << std::endl;
+					if (time < best_time) {
+						best_time = time;
+						config = candidate_config;
+						found = true;
+					}
+				} catch (const std::exception& e) {
+					if (options.log)
+						*options.log << "autotune(): " << candidate_config << ": skipped: " << e.what() << std::endl;
+				}
+			}
+		}
+	}
+
+	if (!found)
+		throw std::runtime_error("autotune(): error: no valid configuration found for '" + stepper_type_names.at(stepper_type) + "'");
+
+	if (cache)
+		cache->store(key, config);
+
+	return detail::make_tuned_stepper<ODE>(config, ocl, source_header, ocl_compile_options, num_matrices, factory, options);
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_autotuner_hpp
@@ -0,0 +1,28 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_bessel_hpp
+#define noma_num_bessel_hpp
+
+#include <cstddef>
+#include <vector>
+
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Returns J_0(z), ..., J_n(z), i.e. the Bessel functions of the first kind
+ * of integer order 0 to n, for z >= 0.
+ *
+ * Uses Miller's backward recurrence, normalised with
+ * J_0(z) + 2 * sum(k) J_2k(z) = 1, which is stable for all orders.
+ */
+std::vector<long_real_t> bessel_j_sequence(long_real_t z, size_t n);
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_bessel_hpp
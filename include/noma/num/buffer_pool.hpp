@@ -0,0 +1,89 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_buffer_pool_hpp
+#define noma_num_buffer_pool_hpp
+
+#include <cstddef>
+
+#include <noma/ocl/helper.hpp>
+
+namespace noma {
+namespace num {
+
+/**
+ * Pooled allocator for the temporary state buffers of steppers.
+ *
+ * Reserves one large OpenCL buffer and hands out aligned sub-buffers of it.
+ * Allocations are organised in groups, and every group starts at offset 0,
+ * i.e. all groups share the same device memory. Steppers open a group for
+ * their temporaries on construction, hence steppers that share a pool must
+ * never run concurrently.
+ *
+ * The high-water mark is the largest extent used by any group so far. It is
+ * the exact capacity needed to serve all steppers created from the pool.
+ */
+class buffer_pool
+{
+public:
+	buffer_pool(ocl::helper& ocl, size_t capacity_byte);
+
+	// start a new group of allocations at offset 0
+	void begin_group();
+
+	// returns an aligned sub-buffer of size_byte behind the previous allocation of the current group
+	cl::Buffer allocate(size_t size_byte);
+
+	size_t capacity() const { return capacity_; }
+	size_t alignment() const { return alignment_; }
+	size_t high_water_mark() const { return high_water_mark_; }
+
+private:
+	ocl::helper& ocl_;
+	cl::Buffer buffer_;
+
+	const size_t capacity_;
+	size_t alignment_; // in byte, as required for sub-buffer origins by the device
+
+	size_t offset_ = 0; // end of the last allocation in the current group
+	size_t high_water_mark_ = 0;
+};
+
+/**
+ * Creates a temporary buffer of size_byte, taken from pool if given, or as
+ * an individual OpenCL buffer otherwise.
+ */
+cl::Buffer create_temporary_buffer(ocl::helper& ocl, buffer_pool* pool, size_t size_byte);
+
+/**
+ * Spare state buffer for the in-place step(time, step_size, d_mem) of
+ * steppers that cannot integrate in place: the step writes y_(n+1) into the
+ * spare buffer, which is then copied back into d_mem (see copy_to()).
+ *
+ * NOTE: d_mem is never rotated with the spare buffer, as the caller's buffer
+ *       may be special, e.g. the host memory of a host_buffer, or a
+ *       sub-buffer of a buffer_pool.
+ * NOTE: The buffer is allocated on first use.
+ */
+class spare_buffer
+{
+public:
+	// returns the spare buffer, allocates it with size_byte if needed
+	cl::Buffer& get(ocl::helper& ocl, size_t size_byte);
+
+	// exchanges the handles of the spare buffer and d_mem, for buffers owned by the same object only
+	void swap(cl::Buffer& d_mem);
+
+	// enqueues a copy of the whole spare buffer into d_mem
+	void copy_to(ocl::helper& ocl, cl::Buffer& d_mem);
+
+private:
+	cl::Buffer buffer_;
+	size_t size_byte_ = 0;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_buffer_pool_hpp
@@ -0,0 +1,464 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_bulirsch_stoer_stepper_hpp
+#define noma_num_bulirsch_stoer_stepper_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/state_kernels.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * This class template integrates over the step by Gragg-Bulirsch-Stoer
+ * extrapolation, with internal adaptation of order and sub-step size.
+ *
+ * For each internal sub-step h, the modified midpoint rule is applied with the
+ * sub-step sequence n_j = 2 * j, j = 1..rows:
+ *
+ * z_0 = y, z_1 = z_0 + h / n * f(z_0), z_(m+1) = z_(m-1) + 2 * h / n * f(z_m), T_(j,1) = z_n
+ *
+ * and the results are extrapolated to h -> 0 by the Aitken-Neville scheme,
+ * which has an error expansion in even powers of h. Every tableau entry
+ * T_(j,k) is a linear combination of T_(1,1)..T_(j,1) with scalar weights,
+ * which are computed on the host, such that all device work is done by ODE
+ * evaluations and the rk_weighted_add kernel.
+ *
+ * The difference of the two highest-order entries serves as error estimate,
+ * scaled per matrix by tolerance * max(1, ||y||). The order and the next
+ * sub-step size are chosen to minimise the ODE evaluations per unit time.
+ *
+ * The sub-step sequences j are independent. By default they are computed one
+ * after another on ocl's command queue. Additional lanes, i.e. command queues
+ * in the same context as ocl (e.g. of sub-devices), with their own ODE
+ * instance, can be added by add_lane(). The sequences are then distributed
+ * over all lanes, balancing the number of ODE evaluations, and run
+ * concurrently.
+ *
+ * Temporary state buffers: max_rows for the T_(j,1), two for sub-step results
+ * and the error, and four per lane.
+ */
+template<typename ODE_T>
+class bulirsch_stoer_stepper : public ocl::kernel_wrapper
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::separated;
+
+	// NOTE: must be consistent with the number of buffer arguments in the rk_weighted_add OpenCL kernel
+	static constexpr size_t max_rows = 7;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	bulirsch_stoer_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	// to fullfill the same 'concept' as rk_stepper.hpp, the passed kernel is used as weighted add kernel
+	bulirsch_stoer_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+	                       const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+	bulirsch_stoer_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+	                       const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	// NOTE: d_mem_in and d_mem_out may be the same buffer, rejected sub-steps never overwrite the current state
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards, through a spare buffer (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	// adds a lane for concurrent sub-step sequences, ocl must share the context with the stepper's ocl, ode must be created on ocl
+	void add_lane(ocl::helper& ocl, ODE_T& ode);
+
+	// local error bound per sub-step
+	void tolerance(real_t tol) { tolerance_ = tol; }
+	real_t tolerance() const { return tolerance_; }
+
+	size_t rows() const { return rows_; } // current number of extrapolation rows, i.e. order 2 * rows
+	size_t accepted_sub_steps() const { return accepted_; }
+	size_t rejected_sub_steps() const { return rejected_; }
+
+	// cost and memory model of a single sub-step attempt for the current rows(), see stepper_cost.hpp
+	// NOTE: the number of sub-steps per step() depends on the tolerance, see accepted_sub_steps() and rejected_sub_steps()
+	stepper_cost cost(size_t buffer_size_byte) const;
+
+private:
+	struct lane {
+		ocl::helper* ocl;
+		ODE_T* ode;
+		std::unique_ptr<kernel_function> weighted_add;
+		cl::Buffer f;
+		cl::Buffer z[3];
+		cl::Event done;
+	};
+
+	void add_lane(ocl::helper& ocl, ODE_T& ode, std::unique_ptr<kernel_function> weighted_add, buffer_pool* pool);
+
+	// out = y + h * sum(i) c[i] * k[i], with up to max_rows terms
+	void weighted_add(kernel_function& kernel, cl::Buffer& out, real_t h, cl::Buffer& y, const std::vector<real_t>& c, const std::vector<cl::Buffer*>& k);
+
+	// T_(j,1) for sequence j from y, over h
+	void modified_midpoint(lane& l, size_t j, real_t time, real_t h, cl::Buffer& y);
+
+	// weights of T_(1,1)..T_(rows,1) for T_(row,column), 1-based
+	std::vector<real_t> neville_weights(size_t row, size_t column) const;
+
+	// combine T_(1,1).. with weights into out
+	void combine(cl::Buffer& out, const std::vector<real_t>& weights);
+
+	// scaled error of the tableau rows 2..rows, from the difference of the two highest-order entries, max. over all matrices
+	std::vector<real_t> errors(size_t rows, cl::Buffer& y_new);
+
+	static size_t sequence(size_t j) { return 2 * j; } // n_j, 1-based
+	static size_t work(size_t rows); // ODE evaluations for rows
+
+	ODE_T& ode_;
+	state_kernels state_;
+
+	std::vector<std::unique_ptr<lane>> lanes_;
+
+	real_t tolerance_ = 1.0e-10;
+	size_t rows_ = 4;
+	real_t sub_step_size_ = 0.0; // 0.0 means none, i.e. use the full step
+	size_t accepted_ = 0;
+	size_t rejected_ = 0;
+
+	const std::string source_header_;
+	const std::string ocl_compile_options_;
+	const ocl::nd_range range_;
+	buffer_pool* pool_;
+
+	// OpenCL buffers
+	spare_buffer spare_; // y_(n+1) of the in-place step(), copied back into d_mem
+	std::vector<cl::Buffer> t_buffers_; // T_(j,1)
+	cl::Buffer y_buffer_; // intermediate sub-step results
+	cl::Buffer error_buffer_;
+
+	static const std::string embedded_ocl_source_;
+	static const std::string embedded_ocl_kernel_name_;
+};
+
+template<typename ODE_T>
+const std::string bulirsch_stoer_stepper<ODE_T>::embedded_ocl_source_ {
+#include "rk_weighted_add.cl.hpp"  // NOTE: generated by CMake
+};
+
+template<typename ODE_T>
+const std::string bulirsch_stoer_stepper<ODE_T>::embedded_ocl_kernel_name_ { "rk_weighted_add" };
+
+template<typename ODE_T>
+bulirsch_stoer_stepper<ODE_T>::bulirsch_stoer_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: bulirsch_stoer_stepper(ocl, embedded_ocl_source_, embedded_ocl_kernel_name_, source_header, ocl_compile_options, range, ode, pool)
+{ }
+
+template<typename ODE_T>
+bulirsch_stoer_stepper<ODE_T>::bulirsch_stoer_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+                                                      const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: kernel_wrapper(ocl), ode_(ode), // NOTE: dummy initialisation of kernel_wrapper, the lanes own the weighted add kernels
+	  state_(ocl, source_header, ocl_compile_options, range),
+	  source_header_(source_header), ocl_compile_options_(ocl_compile_options), range_(range), pool_(pool)
+{
+	if (pool)
+		pool->begin_group();
+
+	for (size_t j = 0; j < max_rows; ++j)
+		t_buffers_.push_back(create_temporary_buffer(ocl_, pool, ode.buffer_size_byte()));
+	y_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+	error_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+
+	add_lane(ocl, ode, std::unique_ptr<kernel_function>(new kernel_function(ocl, kernel_source, kernel_name, weighted_add_source_header(source_header, k_storage::full), ocl_compile_options, range)), pool);
+}
+
+template<typename ODE_T>
+bulirsch_stoer_stepper<ODE_T>::bulirsch_stoer_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+                                                      const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: bulirsch_stoer_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) // NOTE: file_name is ignored, as in chebyshev_stepper
+{ }
+
+template<typename ODE_T>
+void bulirsch_stoer_stepper<ODE_T>::ode_compile_options(std::ostream&)
+{
+	// NOTE: plain ODE evaluation, nothing to define
+}
+
+template<typename ODE_T>
+void bulirsch_stoer_stepper<ODE_T>::add_lane(ocl::helper& ocl, ODE_T& ode)
+{
+	// NOTE: lanes added later do not use the pool, its group may already be shared by other steppers
+	add_lane(ocl, ode, std::unique_ptr<kernel_function>(new kernel_function(ocl, embedded_ocl_source_, embedded_ocl_kernel_name_, weighted_add_source_header(source_header_, k_storage::full), ocl_compile_options_, range_)), nullptr);
+}
+
+template<typename ODE_T>
+void bulirsch_stoer_stepper<ODE_T>::add_lane(ocl::helper& ocl, ODE_T& ode, std::unique_ptr<kernel_function> weighted_add, buffer_pool* pool)
+{
+	std::unique_ptr<lane> l(new lane());
+	l->ocl = &ocl;
+	l->ode = &ode;
+	l->weighted_add = std::move(weighted_add);
+	l->f = create_temporary_buffer(ocl, pool, ode.buffer_size_byte());
+	for (auto& z : l->z)
+		z = create_temporary_buffer(ocl, pool, ode.buffer_size_byte());
+	lanes_.push_back(std::move(l));
+}
+
+template<typename ODE_T>
+size_t bulirsch_stoer_stepper<ODE_T>::work(size_t rows)
+{
+	size_t result = 0;
+	for (size_t j = 1; j <= rows; ++j)
+		result += sequence(j);
+	return result;
+}
+
+template<typename ODE_T>
+void bulirsch_stoer_stepper<ODE_T>::weighted_add(kernel_function& kernel, cl::Buffer& out, real_t h, cl::Buffer& y, const std::vector<real_t>& c, const std::vector<cl::Buffer*>& k)
+{
+	// NOTE: unused terms get a zero coefficient and a valid buffer, see rk_stepper::set_dynamic_args()
+	real_t cs[max_rows] = { };
+	cl::Buffer* ks[max_rows];
+	for (size_t i = 0; i < max_rows; ++i) {
+		cs[i] = i < c.size() ? c[i] : 0.0;
+		ks[i] = i < k.size() ? k[i] : k[0];
+	}
+
+	kernel(static_cast<int_t>(c.size()), h, out, y,
+	       cs[0], *ks[0], cs[1], *ks[1], cs[2], *ks[2], cs[3], *ks[3], cs[4], *ks[4], cs[5], *ks[5], cs[6], *ks[6]);
+}
+
+template<typename ODE_T>
+void bulirsch_stoer_stepper<ODE_T>::modified_midpoint(lane& l, size_t j, real_t time, real_t h, cl::Buffer& y)
+{
+	const size_t n = sequence(j);
+	const real_t h_n = h / static_cast<real_t>(n);
+	cl::Buffer& result = t_buffers_[j - 1];
+
+	// z_m is y for m = 0, result for m = n, and in the rotating l.z[(m - 1) % 3] otherwise
+	auto z = [&](size_t m) -> cl::Buffer& { return m == 0 ? y : (m == n ? result : l.z[(m - 1) % 3]); };
+
+	// z_1 = z_0 + h_n * f(z_0)
+	l.ode->solve(time, 0.0, y, l.f, h_n);
+	weighted_add(*l.weighted_add, z(1), h_n, y, { 1.0 }, { &l.f });
+
+	// z_(m+1) = z_(m-1) + 2 * h_n * f(z_m)
+	for (size_t m = 1; m < n; ++m) {
+		l.ode->solve(time, static_cast<real_t>(m) * h_n, z(m), l.f, h_n);
+		weighted_add(*l.weighted_add, z(m + 1), 2.0 * h_n, z(m - 1), { 1.0 }, { &l.f });
+	}
+}
+
+template<typename ODE_T>
+stepper_cost bulirsch_stoer_stepper<ODE_T>::cost(size_t buffer_size_byte) const
+{
+	stepper_cost c;
+	// modified midpoint: every ODE evaluation reads z_m and writes f, every weighted add reads z_(m-1) and f, and writes z_(m+1)
+	c.ode_evaluations = work(rows_);
+	c.weighted_add_launches = work(rows_);
+	c.read_byte = 3 * work(rows_) * buffer_size_byte;
+	c.written_byte = 2 * work(rows_) * buffer_size_byte;
+
+	// extrapolation: combine() reads T_(1,1) and the T_(j,1) of every row, errors() one norm of y_new, and a combine() and norm per row
+	c.weighted_add_launches += 1 + 1 + 2 * (rows_ - 1);
+	c.read_byte += (rows_ + 1) * buffer_size_byte + buffer_size_byte;
+	c.written_byte += buffer_size_byte;
+	for (size_t row = 2; row <= rows_; ++row) {
+		c.read_byte += (row + 1) * buffer_size_byte + buffer_size_byte;
+		c.written_byte += buffer_size_byte;
+	}
+
+	c.temporary_buffers = max_rows + 2 + 4 * lanes_.size();
+	c.temporary_byte = c.temporary_buffers * buffer_size_byte;
+	c.spare_byte = buffer_size_byte;
+	return c;
+}
+
+template<typename ODE_T>
+std::vector<real_t> bulirsch_stoer_stepper<ODE_T>::neville_weights(size_t row, size_t column) const
+{
+	// t[j][i]: weight of T_(i+1,1) in T_(j+1,k), updated column by column
+	std::vector<std::vector<long_real_t>> t(row, std::vector<long_real_t>(row, 0.0));
+	for (size_t j = 0; j < row; ++j)
+		t[j][j] = 1.0;
+
+	for (size_t k = 1; k < column; ++k) {
+		// T_(j,k+1) = T_(j,k) + (T_(j,k) - T_(j-1,k)) / ((n_j / n_(j-k))^2 - 1), for j > k, from the bottom up
+		for (size_t j = row - 1; j >= k; --j) {
+			const long_real_t ratio = static_cast<long_real_t>(sequence(j + 1)) / static_cast<long_real_t>(sequence(j + 1 - k));
+			const long_real_t factor = 1.0 / (ratio * ratio - 1.0);
+			for (size_t i = 0; i < row; ++i)
+				t[j][i] += factor * (t[j][i] - t[j - 1][i]);
+		}
+	}
+
+	return std::vector<real_t>(t[row - 1].begin(), t[row - 1].end());
+}
+
+template<typename ODE_T>
+void bulirsch_stoer_stepper<ODE_T>::combine(cl::Buffer& out, const std::vector<real_t>& weights)
+{
+	// out = T_(1,1) + sum(i) c_i * T_(i,1), with c_1 = w_1 - 1 and c_i = w_i otherwise
+	std::vector<real_t> c(weights);
+	c[0] -= 1.0;
+	std::vector<cl::Buffer*> k;
+	for (size_t i = 0; i < weights.size(); ++i)
+		k.push_back(&t_buffers_[i]);
+
+	weighted_add(*lanes_[0]->weighted_add, out, 1.0, t_buffers_[0], c, k);
+}
+
+template<typename ODE_T>
+std::vector<real_t> bulirsch_stoer_stepper<ODE_T>::errors(size_t rows, cl::Buffer& y_new)
+{
+	const std::vector<real_t> y_norm2 = state_.norm2(y_new);
+
+	// errors[j] for j + 1 rows, j >= 1
+	std::vector<real_t> result(rows, 0.0);
+	for (size_t row = 2; row <= rows; ++row) {
+		std::vector<real_t> weights = neville_weights(row, row);
+		const std::vector<real_t> lower = neville_weights(row, row - 1);
+		for (size_t i = 0; i < row; ++i)
+			weights[i] -= lower[i];
+
+		// NOTE: the weights of a difference sum up to zero, combine() yields it without y
+		combine(error_buffer_, weights);
+		const std::vector<real_t> error_norm2 = state_.norm2(error_buffer_);
+
+		real_t error = 0.0;
+		for (size_t m = 0; m < error_norm2.size(); ++m)
+			error = std::max(error, std::sqrt(error_norm2[m]) / (tolerance_ * std::max(static_cast<real_t>(1.0), std::sqrt(y_norm2[m]))));
+		result[row - 1] = error;
+	}
+
+	return result;
+}
+
+template<typename ODE_T>
+real_t bulirsch_stoer_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	const real_t end = time + step_size;
+	if (sub_step_size_ <= 0.0 || sub_step_size_ > step_size)
+		sub_step_size_ = step_size;
+
+	cl::CommandQueue& queue = ocl_.command_queue();
+	cl_int err = 0;
+
+	cl::Buffer* y = &d_mem_in;
+	real_t t = time;
+	while (t < end) {
+		const real_t h = std::min(sub_step_size_, end - t);
+		const bool last = (h >= end - t);
+
+		// distribute the sequences over the lanes, longest first, to the lane with the least work
+		std::vector<size_t> lane_work(lanes_.size(), 0);
+		std::vector<std::vector<size_t>> lane_sequences(lanes_.size());
+		for (size_t j = rows_; j >= 1; --j) {
+			const size_t l = std::min_element(lane_work.begin(), lane_work.end()) - lane_work.begin();
+			lane_sequences[l].push_back(j);
+			lane_work[l] += sequence(j);
+		}
+
+		// other lanes start after y is ready on the stepper's queue
+		cl::Event y_ready;
+		if (lanes_.size() > 1) {
+			err = queue.enqueueMarkerWithWaitList(nullptr, &y_ready);
+			ocl::error_handler(err, "clEnqueueMarkerWithWaitList(y_ready)");
+			queue.flush();
+		}
+
+		std::vector<cl::Event> lanes_done;
+		for (size_t l = 0; l < lanes_.size(); ++l) {
+			lane& ln = *lanes_[l];
+			if (l > 0) {
+				std::vector<cl::Event> wait { y_ready };
+				err = ln.ocl->command_queue().enqueueBarrierWithWaitList(&wait);
+				ocl::error_handler(err, "clEnqueueBarrierWithWaitList(lane)");
+			}
+			for (size_t j : lane_sequences[l])
+				modified_midpoint(ln, j, t, h, *y);
+			if (l > 0) {
+				err = ln.ocl->command_queue().enqueueMarkerWithWaitList(nullptr, &ln.done);
+				ocl::error_handler(err, "clEnqueueMarkerWithWaitList(lane)");
+				ln.ocl->command_queue().flush();
+				lanes_done.push_back(ln.done);
+			}
+		}
+		if (!lanes_done.empty()) {
+			err = queue.enqueueBarrierWithWaitList(&lanes_done);
+			ocl::error_handler(err, "clEnqueueBarrierWithWaitList(lanes_done)");
+		}
+
+		// extrapolate into the buffer y is not in, such that y is kept if the sub-step is rejected
+		// NOTE: y may be in d_mem_out, after an accepted sub-step, or if d_mem_in and d_mem_out are the same
+		cl::Buffer* y_new = (y == &y_buffer_) ? &d_mem_out : &y_buffer_;
+		combine(*y_new, neville_weights(rows_, rows_));
+
+		const std::vector<real_t> error = errors(rows_, *y_new);
+
+		// step size per row from the error estimate of order 2 * row - 1, and work per unit step
+		std::vector<real_t> h_row(rows_ + 1, h);
+		std::vector<real_t> work_per_step(rows_ + 1, std::numeric_limits<real_t>::max());
+		for (size_t row = 2; row <= rows_; ++row) {
+			const real_t e = std::max(error[row - 1], static_cast<real_t>(1.0e-10));
+			h_row[row] = h * std::min(static_cast<real_t>(4.0), std::max(static_cast<real_t>(0.2), static_cast<real_t>(0.94 * std::pow(0.65 / e, 1.0 / (2.0 * row - 1.0)))));
+			work_per_step[row] = static_cast<real_t>(work(row)) / h_row[row];
+		}
+		const size_t best = std::min_element(work_per_step.begin() + 2, work_per_step.end()) - work_per_step.begin();
+
+		if (error[rows_ - 1] <= 1.0) {
+			++accepted_;
+			t += h;
+			y = y_new;
+
+			// order and step size for the next sub-step, increase the order if the highest one is the most efficient
+			size_t next_rows = best;
+			real_t next_h = h_row[best];
+			if (best == rows_ && rows_ < max_rows) {
+				next_rows = rows_ + 1;
+				next_h = h_row[best] * static_cast<real_t>(work(rows_ + 1)) / static_cast<real_t>(work(rows_));
+			}
+			rows_ = std::max(static_cast<size_t>(2), next_rows);
+			if (!last) // NOTE: keep the unclamped size for the next step
+				sub_step_size_ = next_h;
+			else if (h == sub_step_size_)
+				sub_step_size_ = next_h;
+		} else {
+			++rejected_;
+			rows_ = std::max(static_cast<size_t>(2), best);
+			sub_step_size_ = std::min(h_row[rows_], static_cast<real_t>(0.5) * h);
+			if (sub_step_size_ < std::numeric_limits<real_t>::epsilon() * std::abs(end))
+				throw std::runtime_error("bulirsch_stoer_stepper::step(): error: step size underflow at time " + std::to_string(t));
+		}
+	}
+
+	if ((*y)() != d_mem_out()) { // NOTE: the accepted result is in y_buffer_, or no sub-step was taken, i.e. step_size <= 0
+		err = queue.enqueueCopyBuffer(*y, d_mem_out, 0, 0, ode_.buffer_size_byte());
+		ocl::error_handler(err, "clEnqueueCopyBuffer(d_mem_out)");
+	}
+
+	return 0.0;
+}
+
+template<typename ODE_T>
+real_t bulirsch_stoer_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_bulirsch_stoer_stepper_hpp
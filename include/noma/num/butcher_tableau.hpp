@@ -6,6 +6,9 @@
 #define noma_num_butcher_tableau_hpp
 
 #include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
 #include <vector>
 
 #include "noma/num/types.hpp"
@@ -31,6 +34,68 @@ struct butcher_tableau
  */
 const butcher_tableau& get_butcher_tableau(const rk_method_t rkm);
 
+/**
+ * Returns true iff the a coefficients of the tableau have (at least two rows
+ * and) only zeros apart from the first subdiagonal, i.e. every stage depends
+ * only on its predecessor. This is needed for accumulate_method::subdiagonal.
+ */
+bool is_subdiagonal(const butcher_tableau& b_tab);
+
+// compile-time counterpart of is_subdiagonal() for the built-in tableaus of get_butcher_tableau(), used by rk_stepper's static_assert
+constexpr bool is_subdiagonal(const rk_method_t rkm) { return rkm == rk_method_t::midpoint || rkm == rk_method_t::rk4; }
+
+// default tolerance for the order conditions and the row sums of runtime-loaded tableaus
+const real_t butcher_tableau_tolerance = std::sqrt(std::numeric_limits<real_t>::epsilon());
+
+/**
+ * Returns the highest order p <= 5, for which the weights b (b_tab.b, or
+ * b_tab.b_cmp of an embedded pair) satisfy all order conditions, i.e. the 17
+ * rooted trees up to order 5, or 0 if not even sum(b) = 1 holds.
+ * NOTE: assumes c_i = sum(j) a_ij, see analyse_butcher_tableau()
+ */
+size_t tableau_order(const butcher_tableau& b_tab, const butcher_tableau::b_coeffs_t& b, real_t tolerance = butcher_tableau_tolerance);
+
+/**
+ * Structure of an explicit Butcher tableau, used by custom_rk_stepper to skip
+ * work and to pick the cheapest accumulate_method.
+ */
+struct tableau_structure
+{
+	size_t stages = 0;
+	size_t order = 0; // see tableau_order()
+	size_t embedded_order = 0; // of b_cmp, 0 without an embedded pair
+	bool embedded = false; // b_cmp is set
+	bool subdiagonal = false; // see is_subdiagonal()
+	bool fsal = false; // first same as last, i.e. the last row of a is b, and the last c is one
+	std::vector<bool> zero_row; // per stage, all a_ij are zero, i.e. the stage input is y_n
+	std::vector<bool> unused; // per stage, k_j is neither used by b, nor by the a of a used stage, e.g. the last stage of an FSAL method, which only serves b_cmp
+	size_t max_terms = 0; // maximum number of non-zero coefficients in a row of a, or in b
+};
+
+/**
+ * Validates b_tab and returns its structure, throws std::runtime_error, if
+ * the dimensions do not match, a is not strictly lower triangular, c_i is not
+ * sum(j) a_ij, or b is not even consistent (order 0).
+ */
+tableau_structure analyse_butcher_tableau(const butcher_tableau& b_tab, real_t tolerance = butcher_tableau_tolerance);
+
+/**
+ * Text format of a butcher_tableau, for tableaus from config files, e.g.
+ * Heun's method with an embedded Euler step:
+ *
+ * a = 0; 1 | b = 1/2 1/2 | b_cmp = 1 0 | c = 0 1
+ *
+ * Sections are separated by '|' or new lines, the rows of a by ';', and
+ * coefficients by white space. Coefficients are decimal numbers or fractions
+ * p/q. Rows of a may omit trailing zeros, b_cmp is optional, and c defaults to
+ * the row sums of a. '#' starts a comment until the end of the line.
+ *
+ * operator>>() reads the whole stream, and throws noma::typa::parser_error for
+ * invalid input, including tableaus that analyse_butcher_tableau() rejects.
+ */
+std::ostream& operator<<(std::ostream& out, const butcher_tableau& b_tab);
+std::istream& operator>>(std::istream& in, butcher_tableau& b_tab);
+
 // Euler method, 1st order
 // https://en.wikipedia.org/wiki/Runge%E2%80%93Kutta_methods#Examples
 // https://en.wikipedia.org/wiki/Euler_method
@@ -151,6 +216,7 @@ const butcher_tableau bosha32_tableau {
 	};
 
 // TODO: exploit FSAL (First Same As Last) property (last k of step n is first k of next step n+1) of bosha32 and dopri54, maybe add flag to the tableau
+// NOTE: analyse_butcher_tableau() detects FSAL, custom_rk_stepper drops the last stage of such methods, since it only serves b_cmp
 
 } // namespace num
 } // namespace noma
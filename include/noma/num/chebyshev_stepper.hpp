@@ -0,0 +1,252 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_chebyshev_stepper_hpp
+#define noma_num_chebyshev_stepper_hpp
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/bessel.hpp"
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/spectral_radius.hpp"
+#include "noma/num/state_kernels.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * This class template performs a single integration step by a Chebyshev
+ * expansion of the propagator exp(h * L):
+ *
+ * exp(h * L) = J_0(z) + 2 * sum(k) J_k(z) * P_k(L / rho), with z = h * rho
+ *
+ * where J_k are Bessel functions, rho bounds the spectral radius of L, and
+ * P_k are the modified Chebyshev polynomials P_0 = 1, P_1 = x,
+ * P_(k+1) = 2 * x * P_k + P_(k-1), which only need real coefficients.
+ *
+ * WARNING: This is mathematically correct iff ODE_T is linear, L does not
+ * depend on time during a step, and the spectrum of L is purely imaginary,
+ * e.g. the von Neumann equation.
+ *
+ * The order is chosen per step size from z, such that all neglected J_k are
+ * below the tolerance. The spectral radius can be set by the user, otherwise
+ * it is estimated by power iteration on the first step.
+ *
+ * ORDER many evaluations of ODE_T are performed and accumulated into the
+ * result like in taylor_stepper. Independent of ORDER, three temporary state
+ * buffers are required, since the recurrence needs two previous terms in
+ * addition to the ODE output.
+ */
+template<typename ODE_T>
+class chebyshev_stepper : public ocl::kernel_wrapper
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::integrated;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	chebyshev_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	// to fullfill the same 'concept' as rk_stepper.hpp, the passed kernel is ignored
+	chebyshev_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+	                  const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: chebyshev_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+	chebyshev_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+	                  const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: chebyshev_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards, through a spare buffer (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	// upper bound for the spectral radius of L, a value <= 0.0 means estimate on next step
+	void spectral_radius(real_t rho) { spectral_radius_ = rho; coeffs_step_size_ = 0.0; }
+	real_t spectral_radius() const { return spectral_radius_; }
+
+	// bound for the neglected Bessel coefficients
+	void tolerance(real_t tol) { tolerance_ = tol; coeffs_step_size_ = 0.0; }
+	real_t tolerance() const { return tolerance_; }
+
+	// number of ODE evaluations per step for the current step size
+	size_t order() const { return ode_coeffs_.size(); }
+
+	// cost and memory model of step() for the current order(), see stepper_cost.hpp
+	// NOTE: the spectral radius estimation on the first step is not included
+	stepper_cost cost(size_t buffer_size_byte) const;
+
+private:
+	void update_coefficients(real_t step_size);
+
+	cl::Buffer& tmp_buffer(size_t i) { return tmp_buffers_[i % 3]; }
+
+	ODE_T& ode_;
+
+	state_kernels state_;
+
+	real_t spectral_radius_ = 0.0;
+	real_t tolerance_ = std::numeric_limits<real_t>::epsilon();
+
+	// power iteration settings, the estimate is enlarged by the safety factor since it converges from below
+	const size_t power_iterations_ = 12;
+	const real_t spectral_radius_safety_ = 1.1;
+
+	// accumulation coefficients for the ODE evaluations of the current step size
+	std::vector<real_t> ode_coeffs_;
+	real_t coeffs_step_size_ = 0.0; // 0.0 means none
+
+	// OpenCL buffers
+	spare_buffer spare_; // y_(n+1) of the in-place step(), copied back into d_mem
+	cl::Buffer tmp_buffers_[3];
+
+	static const std::string embedded_ocl_source_;
+};
+
+template<typename ODE_T>
+const std::string chebyshev_stepper<ODE_T>::embedded_ocl_source_ {
+#include "chebyshev.cl.hpp"  // NOTE: generated by CMake
+};
+
+template<typename ODE_T>
+chebyshev_stepper<ODE_T>::chebyshev_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, embedded_ocl_source_, "chebyshev_recurrence", source_header, ocl_compile_options, range), ode_(ode),
+	  state_(ocl, source_header, ocl_compile_options, range)
+{
+	if (pool)
+		pool->begin_group();
+
+	for (auto& buffer : tmp_buffers_)
+		buffer = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+}
+
+template<typename ODE_T>
+void chebyshev_stepper<ODE_T>::ode_compile_options(std::ostream& os)
+{
+	os << "#define NOMA_NUM_ODE_ACCUMULATE" << "\n";
+}
+
+template<typename ODE_T>
+stepper_cost chebyshev_stepper<ODE_T>::cost(size_t buffer_size_byte) const
+{
+	const size_t n = order();
+
+	stepper_cost c;
+	c.ode_evaluations = n;
+	// every ODE evaluation reads P_k and writes S_k, and accumulates into d_mem_out,
+	// which is initialised from the input by the first evaluation
+	c.read_byte = n * buffer_size_byte + (n > 0 ? n - 1 : 0) * buffer_size_byte;
+	c.written_byte = 2 * n * buffer_size_byte;
+	// every chebyshev_recurrence launch reads S_(k-1) and P_(k-2), and writes P_k
+	c.weighted_add_launches = (n > 0 ? n - 1 : 0);
+	c.read_byte += c.weighted_add_launches * 2 * buffer_size_byte;
+	c.written_byte += c.weighted_add_launches * buffer_size_byte;
+
+	c.temporary_buffers = 3;
+	c.temporary_byte = 3 * buffer_size_byte;
+	c.spare_byte = buffer_size_byte;
+	return c;
+}
+
+template<typename ODE_T>
+void chebyshev_stepper<ODE_T>::update_coefficients(real_t step_size)
+{
+	const long_real_t z = step_size * spectral_radius_;
+
+	// J_k(z) decays super-exponentially for k > z
+	const size_t max_order = static_cast<size_t>(std::ceil(1.5 * z)) + 32;
+	const std::vector<long_real_t> bessel = bessel_j_sequence(z, max_order);
+
+	// highest order with a non-negligible coefficient
+	size_t order = max_order;
+	while (order > 1 && std::abs(bessel[order]) < tolerance_)
+		--order;
+
+	// expansion coefficients c_k for P_k(L / rho)
+	std::vector<long_real_t> c(order + 1);
+	c[0] = bessel[0];
+	for (size_t k = 1; k <= order; ++k)
+		c[k] = 2.0 * bessel[k];
+
+	// NOTE:
+	// with S_j = L * P_j, the recurrence reads P_1 = S_0 / rho, P_(k+1) = 2 / rho * S_k + P_(k-1),
+	// so sum(k) c_k P_k = e * P_0 + sum(j < order) d_j S_j,
+	// with d_j = alpha_j * (c_(j+1) + c_(j+3) + ...), alpha_0 = 1 / rho, alpha_j = 2 / rho,
+	// and e = c_0 + c_2 + c_4 + ... = 1 - 2 * (J_(order+1 or +2) + ...), i.e. 1 up to the tolerance,
+	// which matches initialising the accumulation with P_0 = y_n
+	ode_coeffs_.resize(order);
+	for (size_t j = 0; j < order; ++j) {
+		long_real_t sum = 0.0;
+		for (size_t k = j + 1; k <= order; k += 2)
+			sum += c[k];
+		const long_real_t alpha = (j == 0 ? 1.0 : 2.0) / spectral_radius_;
+		ode_coeffs_[j] = static_cast<real_t>(alpha * sum);
+	}
+
+	coeffs_step_size_ = step_size;
+}
+
+template<typename ODE_T>
+real_t chebyshev_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	if (spectral_radius_ <= 0.0) {
+		// NOTE: accumulation into tmp_buffer(2) with coefficient 0.0 is a no-op, needed for the ODE interface
+		auto apply = [&](cl::Buffer& in, cl::Buffer& out) { ode_.solve(time, 1.0, in, out, tmp_buffer(2), 0.0, false); };
+		spectral_radius_ = spectral_radius_safety_ * estimate_spectral_radius(apply, state_, d_mem_in, tmp_buffer(0), tmp_buffer(1), power_iterations_);
+		coeffs_step_size_ = 0.0;
+	}
+
+	if (step_size != coeffs_step_size_)
+		update_coefficients(step_size);
+
+	const real_t rho = spectral_radius_;
+
+	// S_0 = L * y_n into tmp_buffer(0), initialise d_mem_out with y_n and accumulate d_0 * S_0
+	// NOTE: time step of 1.0 as in taylor_stepper, L is assumed constant during the step
+	ode_.solve(time, 1.0, d_mem_in, tmp_buffer(0), d_mem_out, ode_coeffs_[0], true);
+
+	for (size_t k = 1; k < ode_coeffs_.size(); ++k)
+	{
+		// tmp_buffer(k - 1) holds S_(k-1), turn it into P_k in place
+		// P_(k-2) is y_n for k <= 2, and in tmp_buffer(k - 3) otherwise, which is the next ODE output
+		const bool first = (k == 1);
+		cl_int err = 0;
+		err = kernel_.setArg(0, tmp_buffer(k - 1));
+		ocl::error_handler(err, "clSetKernelArg(0)");
+		err = kernel_.setArg(1, static_cast<real_t>(first ? 1.0 / rho : 2.0 / rho));
+		ocl::error_handler(err, "clSetKernelArg(1)");
+		err = kernel_.setArg(2, static_cast<real_t>(first ? 0.0 : 1.0));
+		ocl::error_handler(err, "clSetKernelArg(2)");
+		err = kernel_.setArg(3, k <= 2 ? d_mem_in : tmp_buffer(k - 3));
+		ocl::error_handler(err, "clSetKernelArg(3)");
+		run_kernel();
+
+		// S_k = L * P_k, accumulate d_k * S_k
+		ode_.solve(time, 1.0, tmp_buffer(k - 1), tmp_buffer(k), d_mem_out, ode_coeffs_[k], false);
+	}
+
+	return 0.0;
+}
+
+template<typename ODE_T>
+real_t chebyshev_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_chebyshev_stepper_hpp
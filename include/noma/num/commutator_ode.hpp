@@ -0,0 +1,115 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_commutator_ode_hpp
+#define noma_num_commutator_ode_hpp
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/stage_input.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+enum class commutator_variant {
+	commutator,    // f(sigma) = alpha * (h * sigma - sigma * h)
+	anticommutator // f(sigma) = alpha * (h * sigma + sigma * h)
+};
+
+/**
+ * Ready-to-use ODE for the steppers: the von Neumann equation
+ *
+ * d/dt sigma = -i [h, sigma]
+ *
+ * for NUM_MATRICES density matrices sigma and one Hamiltonian h, i.e. the
+ * usual hand-written right-hand side kernel, or its anticommutator variant.
+ *
+ * The kernel is compiled for the passed accumulate method, which must be the
+ * acc_method of the stepper that uses this ODE, i.e. the corresponding defines
+ * of ode_compile_options() are added here.
+ *
+ * If packed is set, the states are expected in the interleaved layout of
+ * complex_matrix_commutator_packed() (see complex_matrix.cl), which is
+ * vectorised over VEC_LENGTH matrices, and range must cover
+ * NUM_MATRICES / VEC_LENGTH work-items.
+ * NOTE: Only steppers that treat the state element-wise support this layout,
+ *       i.e. rk_stepper and taylor_stepper.
+ * NOTE: accumulate_method::fused is supported for the unpacked layout only.
+ *
+ * Optionally, an element-wise decay, e.g. dephasing, can be added as split
+ * implicit part for imex_stepper (see decay()), i.e.
+ *
+ * d/dt sigma = -i [h, sigma] - rates * sigma (element-wise)
+ */
+class commutator_ode
+{
+public:
+	commutator_ode(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+	               size_t num_matrices, const std::vector<complex_t>& hamiltonian, accumulate_method acc_method,
+	               commutator_variant variant = commutator_variant::commutator, complex_t alpha = complex_t(0.0, -1.0), bool packed = false);
+
+	size_t buffer_size_byte() const { return num_matrices_ * num_states_ * num_states_ * sizeof(complex_t); }
+
+	// replaces h, must be num_states x num_states, row-major
+	void hamiltonian(const std::vector<complex_t>& h);
+
+	// sets the decay rates of solve_implicit(), must be num_states x num_states, row-major, unpacked layout only
+	// NOTE: solve() is unaffected, i.e. only imex_stepper takes the decay into account
+	// NOTE: imex_stepper assembles its operator on the first step, i.e. rates set afterwards are ignored
+	void decay(const std::vector<complex_t>& rates);
+
+	// accumulate_method::separated: out = f(in)
+	void solve(real_t time, real_t time_step, cl::Buffer& in, cl::Buffer& out, real_t coeff);
+	// accumulate_method::integrated, and the last stage of ::subdiagonal:
+	// out = f(in), acc = (init ? in : acc) + acc_coeff * f(in)
+	void solve(real_t time, real_t time_step, cl::Buffer& in, cl::Buffer& out, cl::Buffer& acc, real_t acc_coeff, bool init);
+	// accumulate_method::subdiagonal: out = y_n + next_coeff * f(in), acc as above, y_n is the input of the init call
+	void solve(real_t time, real_t time_step, cl::Buffer& in, cl::Buffer& out, real_t next_coeff, cl::Buffer& acc, real_t acc_coeff, bool init);
+	// accumulate_method::fused: as ::integrated, for in = y_n + h * sum(l)(stage_coeffs[l] * ks[l]), formed by the kernel (see stage_input.hpp)
+	void solve(real_t time, real_t time_step, cl::Buffer& y_n, real_t h, const std::vector<real_t>& stage_coeffs, std::vector<cl::Buffer>& ks,
+	           cl::Buffer& out, cl::Buffer& acc, real_t acc_coeff, bool init);
+
+	// split implicit part for imex_stepper: out = -rates * in, element-wise, see decay()
+	void solve_implicit(real_t time, real_t time_step, cl::Buffer& in, cl::Buffer& out);
+
+private:
+	static std::string accumulate_defines(accumulate_method acc_method);
+
+	ocl::helper& ocl_;
+
+	const accumulate_method acc_method_;
+	kernel_function kernel_;
+
+	const size_t num_matrices_;
+	const size_t num_states_;
+
+	const complex_t alpha_;
+	const real_t sign_;
+
+	// for creating decay_kernel_ on the first call of decay()
+	const std::string source_header_;
+	const std::string ocl_compile_options_;
+	const ocl::nd_range range_;
+	const bool packed_;
+
+	std::unique_ptr<kernel_function> decay_kernel_;
+
+	cl::Buffer h_buffer_;
+	cl::Buffer y_n_; // input of the last init call, for ::subdiagonal
+	cl::Buffer rates_buffer_;
+
+	static const std::string embedded_ocl_source_;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_commutator_ode_hpp
@@ -0,0 +1,42 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_complex_matrix_kernels_hpp
+#define noma_num_complex_matrix_kernels_hpp
+
+#include <string>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Batched linear algebra on NUM_MATRICES small complex NUM_STATES x NUM_STATES
+ * matrices, in the same layout as the ODE states, i.e. one matrix per
+ * work-item of the passed range.
+ *
+ * See complex_matrix.cl for the compile-time tuning parameters.
+ */
+class complex_matrix_kernels
+{
+public:
+	complex_matrix_kernels(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range);
+
+	// c = alpha * a * b + beta * c, for each matrix; c is not read if beta is zero
+	void gemm(cl::Buffer& c, complex_t alpha, cl::Buffer& a, cl::Buffer& b, complex_t beta = complex_t(0.0, 0.0));
+
+private:
+	kernel_function gemm_kernel_;
+
+	static const std::string embedded_ocl_source_;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_complex_matrix_kernels_hpp
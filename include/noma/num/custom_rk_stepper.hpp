@@ -0,0 +1,299 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_custom_rk_stepper_hpp
+#define noma_num_custom_rk_stepper_hpp
+
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/butcher_tableau.hpp"
+#include "noma/num/k_storage.hpp"
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/stage_input.hpp"
+#include "noma/num/stepper_cost.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * What custom_rk_stepper does per step for a tableau and accumulate_method.
+ *
+ * Unused stages (see tableau_structure) are not evaluated, stages with a zero
+ * row of a read y_n directly, and the k buffers are shared between stages
+ * whose k's are not needed at the same time.
+ */
+struct custom_rk_plan
+{
+	accumulate_method acc_method = accumulate_method::separated;
+	std::vector<size_t> stages; // evaluated stages in order
+	std::vector<size_t> k_buffer; // per stage of the tableau, index of its k buffer (stage input buffer for subdiagonal)
+	size_t num_k_buffers = 0;
+	bool stage_inputs = false; // some stage needs a weighted add, i.e. a stage input buffer, unless fused
+};
+
+/**
+ * True iff acc_method can be used with b_tab and k storage, fused_ode tells
+ * whether the ODE supports accumulate_method::fused (see has_fused_solve).
+ * NOTE: unlike rk_stepper, there is no fallback from fused to integrated
+ */
+bool is_applicable(const butcher_tableau& b_tab, accumulate_method acc_method, k_storage storage, bool fused_ode);
+
+// throws std::runtime_error if b_tab is invalid, or acc_method is not applicable to its structure
+custom_rk_plan make_custom_rk_plan(const butcher_tableau& b_tab, accumulate_method acc_method);
+
+// the cost model of rk_stepper::cost() applied to plan
+stepper_cost custom_rk_cost(const butcher_tableau& b_tab, const custom_rk_plan& plan, size_t buffer_size_byte, size_t k_buffer_size_byte);
+
+/**
+ * The applicable accumulate_method with the least memory traffic per step,
+ * followed by the least memory, according to custom_rk_cost().
+ * NOTE: independent of the buffer size, since the cost model is linear in it
+ */
+accumulate_method cheapest_accumulate_method(const butcher_tableau& b_tab, k_storage storage, bool fused_ode);
+
+// OpenCL source of the weighted add kernels of plan, see cl/custom_rk.cl
+std::string custom_rk_kernel_source(const butcher_tableau& b_tab, const custom_rk_plan& plan);
+
+/**
+ * Explicit Runge-Kutta stepper for a Butcher tableau given at runtime, e.g.
+ * read from a config file (see operator>>() in butcher_tableau.hpp), instead
+ * of an rk_method_t.
+ *
+ * The tableau is validated and analysed on construction, see
+ * tableau_structure. The OpenCL weighted add kernels are generated for it,
+ * with the non-zero coefficients as constants, and only the used k's as
+ * arguments, i.e. there is no limit on their number, apart from
+ * accumulate_method::fused, where each stage input is limited to
+ * stage_input::max_ks k's.
+ *
+ * As the ODE is compiled for the accumulate_method, it has to be chosen
+ * before the ODE is constructed, e.g. by select_accumulate_method():
+ *
+ * accumulate_method acc = custom_rk_stepper<ODE>::select_accumulate_method(b_tab);
+ * custom_rk_stepper<ODE>::ode_compile_options(acc, header);
+ * ODE ode(..., header.str(), ..., acc);
+ * custom_rk_stepper<ODE> stepper(ocl, header.str(), ..., ode, b_tab, acc);
+ *
+ * NOTE: The constructor does not fit the stepper concept of rk_stepper, hence
+ *       custom_rk_stepper is not part of stepper_type_t.
+ */
+template<typename ODE_T, k_storage K_STORAGE = k_storage::full>
+class custom_rk_stepper
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr k_storage k_storage_format = K_STORAGE;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	// NOTE: acc_method must be the one the ODE was compiled for
+	custom_rk_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode,
+	                  const butcher_tableau& b_tab, accumulate_method acc_method, buffer_pool* pool = nullptr);
+
+	// NOTE: d_mem_in and d_mem_out may be the same buffer for accumulate_method::separated
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards
+	// NOTE: separated works in place, the other methods write into a spare buffer, and copy it back into d_mem (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+	// cheapest applicable accumulate_method for b_tab, ODE_T, and K_STORAGE
+	static accumulate_method select_accumulate_method(const butcher_tableau& b_tab)
+	{
+		return cheapest_accumulate_method(b_tab, K_STORAGE, has_fused_solve<ODE_T>::value);
+	}
+
+	// generate OpenCL compile options for the ODE implementation
+	static void ode_compile_options(accumulate_method acc_method, std::ostream& os)
+	{
+		accumulate_compile_options(acc_method, os);
+		k_storage_compile_options(K_STORAGE, os);
+	}
+
+	// cost and memory model of step(), see stepper_cost.hpp
+	stepper_cost cost(size_t buffer_size_byte) const;
+
+	// order of b, see tableau_order()
+	size_t order() const { return structure_.order; }
+
+	accumulate_method acc_method() const { return plan_.acc_method; }
+	const butcher_tableau& tableau() const { return b_tab_; }
+	const tableau_structure& structure() const { return structure_; }
+	const custom_rk_plan& plan() const { return plan_; }
+
+private:
+	void step_subdiagonal(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+	void step_fused(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out, std::true_type);
+	void step_fused(real_t, real_t, cl::Buffer&, cl::Buffer&, std::false_type) { }
+
+	static size_t k_buffer_size_byte(size_t buffer_size_byte) { return buffer_size_byte / sizeof(real_t) * k_storage_element_size_byte(K_STORAGE); }
+
+	ocl::helper& ocl_;
+
+	const butcher_tableau b_tab_;
+	const tableau_structure structure_;
+	const custom_rk_plan plan_;
+
+	ODE_T& ode_;
+
+	// generated kernels, per stage with a weighted add, nullptr otherwise
+	std::vector<std::unique_ptr<kernel_function>> stage_kernels_;
+	std::unique_ptr<kernel_function> result_kernel_; // only for separated
+
+	// per stage, the non-zero coefficients of a and their k buffers, and the same for b
+	std::vector<std::vector<real_t>> stage_coeffs_;
+	std::vector<std::vector<cl::Buffer>> stage_ks_;
+	std::vector<cl::Buffer> result_ks_;
+
+	// OpenCL buffers
+	std::vector<cl::Buffer> k_buffers_;
+	cl::Buffer tmp_buffer_; // for integrated accumulation
+	spare_buffer spare_; // stage inputs of in-place separated steps, or y_(n+1) of the in-place step() otherwise, copied back into d_mem
+};
+
+template<typename ODE_T, k_storage K_STORAGE>
+custom_rk_stepper<ODE_T, K_STORAGE>::custom_rk_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode,
+                                                       const butcher_tableau& b_tab, accumulate_method acc_method, buffer_pool* pool)
+	: ocl_(ocl), b_tab_(b_tab), structure_(analyse_butcher_tableau(b_tab)), plan_(make_custom_rk_plan(b_tab, acc_method)), ode_(ode),
+	  stage_kernels_(structure_.stages), stage_coeffs_(structure_.stages), stage_ks_(structure_.stages)
+{
+	if (!is_applicable(b_tab_, acc_method, K_STORAGE, has_fused_solve<ODE_T>::value))
+		throw std::runtime_error("custom_rk_stepper::custom_rk_stepper(): error: accumulate_method is not applicable to the tableau, the k storage, or the ODE.");
+
+	if (pool)
+		pool->begin_group();
+
+	// NOTE: subdiagonal always uses full storage, see is_applicable()
+	const size_t k_size_byte = (acc_method == accumulate_method::subdiagonal) ? ode_.buffer_size_byte() : k_buffer_size_byte(ode_.buffer_size_byte());
+	for (size_t l = 0; l < plan_.num_k_buffers; ++l)
+		k_buffers_.push_back(create_temporary_buffer(ocl_, pool, k_size_byte));
+
+	if (acc_method == accumulate_method::integrated && plan_.stage_inputs)
+		tmp_buffer_ = create_temporary_buffer(ocl_, pool, ode_.buffer_size_byte());
+
+	if (acc_method == accumulate_method::subdiagonal)
+		return;
+
+	for (size_t i : plan_.stages)
+		for (size_t j = 0; j < i; ++j)
+			if (b_tab_.a[i][j] != 0.0) {
+				stage_coeffs_[i].push_back(b_tab_.a[i][j]);
+				stage_ks_[i].push_back(k_buffers_[plan_.k_buffer[j]]);
+			}
+	for (size_t j = 0; j < structure_.stages; ++j)
+		if (b_tab_.b[j] != 0.0)
+			result_ks_.push_back(k_buffers_[plan_.k_buffer[j]]);
+
+	// the stage inputs are formed by the ODE for fused accumulation
+	if (acc_method == accumulate_method::fused)
+		return;
+
+	const std::string kernel_source = custom_rk_kernel_source(b_tab_, plan_);
+	const std::string kernel_source_header = weighted_add_source_header(source_header, K_STORAGE); // see rk_stepper
+	for (size_t i : plan_.stages)
+		if (!stage_coeffs_[i].empty())
+			stage_kernels_[i].reset(new kernel_function(ocl_, kernel_source, "custom_rk_stage_" + std::to_string(i), kernel_source_header, ocl_compile_options, range));
+
+	if (acc_method == accumulate_method::separated)
+		result_kernel_.reset(new kernel_function(ocl_, kernel_source, "custom_rk_result", kernel_source_header, ocl_compile_options, range));
+}
+
+template<typename ODE_T, k_storage K_STORAGE>
+stepper_cost custom_rk_stepper<ODE_T, K_STORAGE>::cost(size_t buffer_size_byte) const
+{
+	const size_t k_size_byte = (plan_.acc_method == accumulate_method::subdiagonal) ? buffer_size_byte : k_buffer_size_byte(buffer_size_byte);
+	return custom_rk_cost(b_tab_, plan_, buffer_size_byte, k_size_byte);
+}
+
+/* performs a single integration step */
+template<typename ODE_T, k_storage K_STORAGE>
+real_t custom_rk_stepper<ODE_T, K_STORAGE>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	const accumulate_method acc_method = plan_.acc_method;
+
+	if (acc_method != accumulate_method::separated && d_mem_in() == d_mem_out())
+		throw std::runtime_error("custom_rk_stepper::step(): error: d_mem_in and d_mem_out must differ for integrated, subdiagonal, and fused accumulation, use the in-place step()");
+
+	if (acc_method == accumulate_method::subdiagonal) {
+		step_subdiagonal(time, step_size, d_mem_in, d_mem_out);
+		return 0.0;
+	}
+
+	if (acc_method == accumulate_method::fused) {
+		step_fused(time, step_size, d_mem_in, d_mem_out, std::integral_constant<bool, has_fused_solve<ODE_T>::value>());
+		return 0.0;
+	}
+
+	// separated: the stage inputs go into d_mem_out, unless it is d_mem_in, which is still needed
+	// integrated: d_mem_out accumulates the result, so the stage inputs go into tmp_buffer_
+	cl::Buffer* stage_buffer = &tmp_buffer_;
+	if (acc_method == accumulate_method::separated)
+		stage_buffer = (d_mem_in() == d_mem_out() && plan_.stage_inputs) ? &spare_.get(ocl_, ode_.buffer_size_byte()) : &d_mem_out;
+
+	for (size_t i : plan_.stages) {
+		// stages with a zero row of a read y_n
+		cl::Buffer* stage_input = &d_mem_in;
+		if (stage_kernels_[i]) {
+			stage_kernels_[i]->run_with_trailing(stage_ks_[i], step_size, *stage_buffer, d_mem_in);
+			stage_input = stage_buffer;
+		}
+
+		cl::Buffer& k = k_buffers_[plan_.k_buffer[i]];
+		if (acc_method == accumulate_method::separated)
+			ode_.solve(time, b_tab_.c[i] * step_size, *stage_input, k, b_tab_.b[i] * step_size);
+		else // integrated, d_mem_out is initialised by the first stage, which reads y_n
+			ode_.solve(time, b_tab_.c[i] * step_size, *stage_input, k, d_mem_out, b_tab_.b[i] * step_size, i == plan_.stages.front());
+	}
+
+	// y_(n+1) = y_n + h * sum(j)(b_j * k_j)
+	// NOTE: element-wise, i.e. also correct in place
+	if (acc_method == accumulate_method::separated)
+		result_kernel_->run_with_trailing(result_ks_, step_size, d_mem_out, d_mem_in);
+
+	return 0.0;
+}
+
+template<typename ODE_T, k_storage K_STORAGE>
+void custom_rk_stepper<ODE_T, K_STORAGE>::step_subdiagonal(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	// as in rk_stepper, the two k buffers alternately hold the next stage input, computed by the ODE
+	const size_t stages = structure_.stages;
+	ode_.solve(time, b_tab_.c[0] * step_size, d_mem_in, k_buffers_[plan_.k_buffer[1]], b_tab_.a[1][0] * step_size, d_mem_out, b_tab_.b[0] * step_size, true);
+	for (size_t i = 1; i < stages - 1; ++i)
+		ode_.solve(time, b_tab_.c[i] * step_size, k_buffers_[plan_.k_buffer[i]], k_buffers_[plan_.k_buffer[i + 1]], b_tab_.a[i + 1][i] * step_size, d_mem_out, b_tab_.b[i] * step_size, false);
+	ode_.solve(time, b_tab_.c[stages - 1] * step_size, k_buffers_[plan_.k_buffer[stages - 1]], k_buffers_[plan_.k_buffer[stages - 2]], d_mem_out, b_tab_.b[stages - 1] * step_size, false);
+}
+
+template<typename ODE_T, k_storage K_STORAGE>
+void custom_rk_stepper<ODE_T, K_STORAGE>::step_fused(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out, std::true_type)
+{
+	// every ODE evaluation forms its stage input from y_n and the non-zero terms of its row of a, see rk_stepper::step_fused()
+	for (size_t i : plan_.stages)
+		ode_.solve(time, b_tab_.c[i] * step_size, d_mem_in, step_size, stage_coeffs_[i], stage_ks_[i], k_buffers_[plan_.k_buffer[i]], d_mem_out, b_tab_.b[i] * step_size, i == plan_.stages.front());
+}
+
+template<typename ODE_T, k_storage K_STORAGE>
+real_t custom_rk_stepper<ODE_T, K_STORAGE>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	if (plan_.acc_method == accumulate_method::separated)
+		return step(time, step_size, d_mem, d_mem);
+
+	// the ODE reads y_n while accumulating y_(n+1), so write into the spare buffer and copy back
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_custom_rk_stepper_hpp
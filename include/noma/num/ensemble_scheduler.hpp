@@ -0,0 +1,111 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_ensemble_scheduler_hpp
+#define noma_num_ensemble_scheduler_hpp
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/streaming_integrator.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * An independent integration problem for ensemble_scheduler.
+ */
+struct integration_job
+{
+	size_t id = 0; // user-defined, e.g. to identify the result in the completion callback
+	std::vector<complex_t> state; // initial state, replaced by the result
+	real_t time = 0.0;
+	real_t step_size = 0.0;
+	size_t num_steps = 0;
+	// optional, called on the worker before integrating, e.g. to set the job's parameters on the worker's ODE
+	std::function<void(chunk_stepper& stepper)> configure;
+};
+
+/**
+ * Schedules independent integration jobs over a pool of workers, each an
+ * ocl::helper, i.e. a command queue, with its own ODE, stepper, temporaries,
+ * and one host thread.
+ *
+ * Every worker owns a job deque: submit() distributes jobs round-robin, a
+ * worker takes jobs from the front of its own deque, and steals from the back
+ * of the others' when it runs out, such that jobs of different lengths
+ * balance out.
+ *
+ * Results are passed to the completion callback, which is called from the
+ * worker threads, i.e. it must be thread-safe.
+ *
+ * NOTE: Steppers are not thread-safe, hence one stepper per worker. Each of
+ *       them compiles its own programs, as ocl::kernel_wrapper does not
+ *       support sharing a cl::Program between instances.
+ */
+class ensemble_scheduler
+{
+public:
+	using completion_callback = std::function<void(integration_job& job)>;
+
+	// the factory is called once per worker, with num_matrices, the state size of all jobs
+	ensemble_scheduler(const std::vector<ocl::helper*>& ocls, chunk_stepper_factory factory, size_t num_matrices, completion_callback on_completion);
+	~ensemble_scheduler();
+
+	ensemble_scheduler(const ensemble_scheduler&) = delete;
+	ensemble_scheduler& operator=(const ensemble_scheduler&) = delete;
+
+	void submit(integration_job job);
+
+	// blocks until all submitted jobs are completed, rethrows the first error of a job or callback
+	void wait();
+
+	size_t num_workers() const { return workers_.size(); }
+	size_t num_completed() const; // since construction
+	size_t num_stolen() const; // jobs executed by another worker than they were submitted to
+
+private:
+	struct worker {
+		ocl::helper* ocl;
+		chunk_stepper stepper;
+		cl::Buffer state; // integrated by the in-place step()
+		size_t size_byte = 0; // of state
+
+		std::mutex mutex; // protects jobs
+		std::deque<integration_job> jobs;
+		std::thread thread;
+	};
+
+	void run_worker(size_t w);
+	bool take_job(size_t w, integration_job& job);
+	void integrate(worker& w, integration_job& job);
+
+	std::vector<std::unique_ptr<worker>> workers_;
+	completion_callback on_completion_;
+
+	// scheduler state, protected by mutex_
+	mutable std::mutex mutex_;
+	std::condition_variable work_available_;
+	std::condition_variable all_done_;
+	size_t pending_ = 0; // submitted, but not completed jobs
+	size_t completed_ = 0;
+	size_t stolen_ = 0;
+	size_t next_worker_ = 0;
+	bool stop_ = false;
+	std::exception_ptr error_;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_ensemble_scheduler_hpp
@@ -0,0 +1,144 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_event_detector_hpp
+#define noma_num_event_detector_hpp
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+// sign changes of an event function that trigger the event
+enum class event_direction {
+	both,
+	rising, // from negative to zero or positive
+	falling // from positive to zero or negative
+};
+
+const std::map<event_direction, std::string> event_direction_names {
+	{ event_direction::both, "both" },
+	{ event_direction::rising, "rising" },
+	{ event_direction::falling, "falling" }
+};
+
+std::ostream& operator<<(std::ostream& out, const event_direction& direction);
+std::istream& operator>>(std::istream& in, event_direction& direction);
+
+struct event_spec
+{
+	event_direction direction = event_direction::both;
+	bool terminal = false; // freezes the system at the event
+};
+
+// an event located during a step
+struct event_record
+{
+	size_t system = 0; // matrix index, i.e. 0 to NUM_MATRICES - 1
+	size_t event = 0;
+	real_t time = 0.0;
+	bool terminal = false;
+};
+
+std::ostream& operator<<(std::ostream& out, const event_record& record);
+
+/**
+ * Event detection for batched integrations, i.e. independently for each of
+ * the NUM_MATRICES systems.
+ *
+ * The event functions g_event(t, y) are user OpenCL code, passed as a macro
+ * in the source header, which reads the state via NOMA_NUM_EVENT_STATE(e),
+ * the complex element e (row-major) of the system's state, e.g. a population
+ * crossing a threshold:
+ *
+ * #define NOMA_NUM_EVENTS 2
+ * #define NOMA_NUM_EVENT_FUNCTION(event, t) ((event) == 0 ? NOMA_NUM_EVENT_STATE(0).x - 0.5 : (t) - 10.0)
+ *
+ * After every step, the event functions are evaluated on the device, and
+ * sign changes are located inside the step by the Illinois method on the
+ * linear interpolant of y_n and y_(n+1), i.e. the event time is as accurate
+ * as the interpolant, and never before the actual sign change. The located
+ * events are compacted on the device, such that only the records of the
+ * flagged systems are read back.
+ *
+ * A terminal event sets the system's state to the interpolated state at the
+ * event, and freezes it, i.e. after_step() undoes all further steps of that
+ * system, until initialise() is called again. Events of the same step after
+ * the earliest terminal one are not reported.
+ *
+ * NOTE: the stepper still integrates frozen systems, if all systems are
+ *       frozen (all_frozen()), the integration can stop
+ */
+class event_detector
+{
+public:
+	// NOTE: events must match NOMA_NUM_EVENTS in source_header
+	event_detector(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, size_t buffer_size_byte,
+	               const std::vector<event_spec>& events);
+
+	size_t num_matrices() const { return num_matrices_; }
+	size_t num_events() const { return events_.size(); }
+
+	size_t num_frozen() const { return num_frozen_; }
+	bool all_frozen() const { return num_frozen_ == num_matrices_; }
+
+	// evaluates the event functions for the state d_mem at time, and unfreezes all systems, must be called before the first step
+	void initialise(real_t time, cl::Buffer& d_mem);
+
+	// keeps a copy of y_n for the after_step() of in-place steps
+	void before_step(cl::Buffer& d_mem);
+
+	// returns the events of the step from y_n at time to y_np1 at time + step_size, may modify y_np1 (see above)
+	std::vector<event_record> after_step(real_t time, real_t step_size, cl::Buffer& y_n, cl::Buffer& y_np1);
+
+	// as above, for in-place steps, with y_n from before_step()
+	std::vector<event_record> after_step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+private:
+	ocl::helper& ocl_;
+	const size_t buffer_size_byte_;
+	const std::vector<event_spec> events_;
+
+	kernel_function dimensions_kernel_;
+	kernel_function initialise_kernel_;
+	kernel_function detect_kernel_;
+
+	size_t num_matrices_ = 0;
+	size_t num_frozen_ = 0;
+
+	cl::Buffer y_n_buffer_; // for in-place steps
+	cl::Buffer g_buffer_;
+	cl::Buffer frozen_buffer_;
+	cl::Buffer config_buffer_;
+	cl::Buffer count_buffer_;
+	cl::Buffer record_id_buffer_;
+	cl::Buffer record_theta_buffer_;
+
+	static const std::string embedded_ocl_source_;
+};
+
+/**
+ * In-place step of any stepper with event detection, i.e. stepper.step()
+ * between detector.before_step() and detector.after_step().
+ */
+template<typename STEPPER>
+std::vector<event_record> step_with_events(STEPPER& stepper, event_detector& detector, real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	detector.before_step(d_mem);
+	stepper.step(time, step_size, d_mem);
+	return detector.after_step(time, step_size, d_mem);
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_event_detector_hpp
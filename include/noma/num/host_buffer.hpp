@@ -0,0 +1,117 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_host_buffer_hpp
+#define noma_num_host_buffer_hpp
+
+#include <memory>
+
+#include <noma/ocl/helper.hpp>
+
+namespace noma {
+namespace num {
+
+/**
+ * Allocation strategies for buffers the host accesses directly.
+ * - device: plain device allocation, mapping implies a copy on most devices
+ * - alloc_host_ptr: the OpenCL runtime allocates host-accessible memory
+ * - use_host_ptr: page-aligned host memory owned by host_buffer, zero-copy
+ *   on CPU devices and devices with host unified memory
+ */
+enum class host_buffer_mode {
+	device,
+	alloc_host_ptr,
+	use_host_ptr
+};
+
+// true for CPU devices and devices reporting CL_DEVICE_HOST_UNIFIED_MEMORY
+bool is_host_unified(ocl::helper& ocl);
+
+// use_host_ptr if is_host_unified(ocl), device otherwise
+host_buffer_mode default_host_buffer_mode(ocl::helper& ocl);
+
+/**
+ * RAII mapping of (a part of) a buffer into host memory, unmapped on
+ * destruction. The map is blocking, the unmap is enqueued, i.e. subsequent
+ * commands on the same in-order queue see the host's changes.
+ */
+class buffer_mapping
+{
+public:
+	buffer_mapping(cl::CommandQueue& queue, cl::Buffer& buffer, cl_map_flags flags, size_t size_byte, size_t offset_byte = 0);
+	buffer_mapping(buffer_mapping&& other);
+	buffer_mapping(const buffer_mapping&) = delete;
+	buffer_mapping& operator=(const buffer_mapping&) = delete;
+	~buffer_mapping();
+
+	void* data() { return data_; }
+	template<typename T>
+	T* data_as() { return static_cast<T*>(data_); }
+
+	size_t size_byte() const { return size_byte_; }
+
+	// unmaps before destruction, data() is invalid afterwards
+	void unmap();
+
+private:
+	cl::CommandQueue* queue_;
+	cl::Buffer buffer_;
+	void* data_ = nullptr;
+	size_t size_byte_ = 0;
+};
+
+/**
+ * Buffer for ODE states that the host reads and writes directly, e.g. for
+ * initial conditions, observers, and checkpoints. It can be passed to any
+ * stepper's step() like a buffer from ocl::helper::create_buffer().
+ *
+ * For host_buffer_mode::use_host_ptr, the host memory is aligned to the page
+ * size, and padded to a multiple of the cache line size, as required for
+ * zero-copy by CPU implementations.
+ * NOTE: the host memory is freed on destruction, copies of buffer() must not
+ *       outlive this object.
+ * NOTE: the in-place step() of all steppers keeps the passed buffer, i.e.
+ *       buffer() still refers to the host memory afterwards (see spare_buffer).
+ */
+class host_buffer
+{
+public:
+	host_buffer(ocl::helper& ocl, size_t size_byte); // uses default_host_buffer_mode(ocl)
+	host_buffer(ocl::helper& ocl, size_t size_byte, host_buffer_mode mode);
+	host_buffer(const host_buffer&) = delete;
+	host_buffer& operator=(const host_buffer&) = delete;
+
+	cl::Buffer& buffer() { return buffer_; }
+	size_t size_byte() const { return size_byte_; }
+	host_buffer_mode mode() const { return mode_; }
+
+	// maps the whole buffer on ocl's command queue
+	buffer_mapping map(cl_map_flags flags);
+
+	// copy the whole buffer from or to host memory, through a mapping
+	// NOTE: convenience only, use map() to access the state without copies
+	void write(const void* src);
+	void read(void* dst);
+
+	static constexpr size_t cache_line_size = 64;
+
+private:
+	struct aligned_deleter {
+		void operator()(void* ptr) const;
+	};
+
+	static size_t page_size();
+
+	ocl::helper& ocl_;
+	const size_t size_byte_;
+	const host_buffer_mode mode_;
+
+	std::unique_ptr<void, aligned_deleter> host_memory_; // for use_host_ptr only
+	cl::Buffer buffer_; // NOTE: declared after host_memory_, i.e. released before it
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_host_buffer_hpp
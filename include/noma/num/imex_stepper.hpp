@@ -0,0 +1,456 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_imex_stepper_hpp
+#define noma_num_imex_stepper_hpp
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/butcher_tableau.hpp"
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/matrix_exp.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/state_kernels.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+enum class imex_method_t {
+	ark324l2sa,
+	ark436l2sa
+};
+
+const std::map<imex_method_t, std::string> imex_method_names {
+	{ imex_method_t::ark324l2sa, "ark324l2sa" },
+	{ imex_method_t::ark436l2sa, "ark436l2sa" }
+};
+
+const std::map<imex_method_t, size_t> imex_method_orders {
+	{ imex_method_t::ark324l2sa, 3 },
+	{ imex_method_t::ark436l2sa, 4 }
+};
+
+std::ostream& operator<<(std::ostream& out, const imex_method_t& m);
+std::istream& operator>>(std::istream& in, imex_method_t& m);
+
+/**
+ * Pair of Butcher tableaus of an additive Runge-Kutta method, with common b
+ * and c: an explicit one for the non-stiff part, and an ESDIRK one for the
+ * stiff part, i.e. an explicit first stage, and the constant diagonal gamma.
+ */
+struct imex_tableau
+{
+	butcher_tableau::a_coeffs_t a_explicit; // strictly lower triangular
+	butcher_tableau::a_coeffs_t a_implicit; // lower triangular, a_implicit[i][i] = gamma for i > 0
+	butcher_tableau::b_coeffs_t b;
+	butcher_tableau::b_coeffs_t b_cmp; // embedded solution, currently unused, see rk_stepper
+	butcher_tableau::c_coeffs_t c;
+	real_t gamma;
+};
+
+/**
+ * Returns the imex_tableau of an IMEX method (imex_method_t).
+ */
+const imex_tableau& get_imex_tableau(const imex_method_t m);
+
+// C.A. Kennedy, M.H. Carpenter, Additive Runge-Kutta schemes for convection-diffusion-reaction equations, Appl. Numer. Math. 44 (2003)
+const imex_tableau ark324l2sa_tableau {
+		// explicit a coefficients
+		{ {                                  0.0,                                   0.0,                                    0.0, 0.0 },
+		  { 1767732205903.0 /  2027836641118.0,                                   0.0,                                    0.0, 0.0 },
+		  { 5535828885825.0 / 10492691773637.0,   788022342437.0 / 10882634858940.0,                                    0.0, 0.0 },
+		  { 6485989280629.0 / 16251701735622.0, -4246266847089.0 /  9704473918619.0, 10755448449292.0 / 10357097424841.0, 0.0 } },
+		// implicit a coefficients
+		{ {                                  0.0,                                   0.0,                                    0.0,                                 0.0 },
+		  { 1767732205903.0 /  4055673282236.0,  1767732205903.0 /  4055673282236.0,                                    0.0,                                 0.0 },
+		  { 2746238789719.0 / 10658868560708.0,  -640167445237.0 /  6845629431997.0,  1767732205903.0 /  4055673282236.0,                                 0.0 },
+		  { 1471266399579.0 /  7840856788654.0, -4482444167858.0 /  7529755066697.0, 11266239266428.0 / 11593286722821.0, 1767732205903.0 / 4055673282236.0 } },
+		// b coefficients, 3rd order solution
+		{   1471266399579.0 /  7840856788654.0, -4482444167858.0 /  7529755066697.0, 11266239266428.0 / 11593286722821.0, 1767732205903.0 / 4055673282236.0 },
+		// b_cmp coefficients, 2nd order solution
+		{   2756255671327.0 / 12835298489170.0, -10771552573575.0 / 22201958757719.0, 9247589265047.0 / 10645013368117.0, 2193209047091.0 / 5459859503100.0 },
+		// c coefficients
+		{                                  0.0,  1767732205903.0 /  2027836641118.0,                               3.0/5.0,                                 1.0 },
+		// gamma
+		1767732205903.0 / 4055673282236.0
+	};
+
+// C.A. Kennedy, M.H. Carpenter, Additive Runge-Kutta schemes for convection-diffusion-reaction equations, Appl. Numer. Math. 44 (2003)
+const imex_tableau ark436l2sa_tableau {
+		// explicit a coefficients
+		{ {                                 0.0,                                  0.0,                                  0.0,                                 0.0,           0.0, 0.0 },
+		  {                             1.0/2.0,                                  0.0,                                  0.0,                                 0.0,           0.0, 0.0 },
+		  {                     13861.0/62500.0,                       6889.0/62500.0,                                  0.0,                                 0.0,           0.0, 0.0 },
+		  { -116923316275.0 /  2393684061468.0, -2731218467317.0 / 15368042101831.0,  9408046702089.0 / 11113171139209.0,                                 0.0,           0.0, 0.0 },
+		  { -451086348788.0 /  2902428689909.0, -2682348792572.0 /  7519795681897.0, 12662868775082.0 / 11960479115383.0, 3355817975965.0 / 11060851509271.0,           0.0, 0.0 },
+		  {  647845179188.0 /  3216320057751.0,    73281519250.0 /  8382639484533.0,   552539513391.0 /  3454668386233.0, 3354512671639.0 /  8306763924573.0, 4040.0/17871.0, 0.0 } },
+		// implicit a coefficients
+		{ {                         0.0,                    0.0,                         0.0,                     0.0,             0.0,     0.0 },
+		  {                     1.0/4.0,                1.0/4.0,                         0.0,                     0.0,             0.0,     0.0 },
+		  {             8611.0/62500.0,        -1743.0/31250.0,                     1.0/4.0,                     0.0,             0.0,     0.0 },
+		  {          5012029.0/34652500.0,      -654441.0/2922500.0,        174375.0/388108.0,                 1.0/4.0,             0.0,     0.0 },
+		  { 15267082809.0/155376265600.0,  -71443401.0/120774400.0,  730878875.0/902184768.0,    2285395.0/8070912.0,         1.0/4.0,     0.0 },
+		  {            82889.0/524892.0,                    0.0,          15625.0/83664.0,       69875.0/102672.0,   -2260.0/8211.0, 1.0/4.0 } },
+		// b coefficients, 4th order solution
+		{              82889.0/524892.0,                    0.0,          15625.0/83664.0,       69875.0/102672.0,   -2260.0/8211.0, 1.0/4.0 },
+		// b_cmp coefficients, 3rd order solution
+		{  4586570599.0/29645900160.0,                    0.0,  178811875.0/945068544.0, 814220225.0/1159782912.0, -3700637.0/11593932.0, 61727.0/225920.0 },
+		// c coefficients
+		{                         0.0,                1.0/2.0,                83.0/250.0,                31.0/50.0,      17.0/20.0,     1.0 },
+		// gamma
+		1.0/4.0
+	};
+
+/**
+ * This class template performs a single step of an additive, implicit-explicit
+ * (IMEX) Runge-Kutta method, for ODEs with a stiff linear part, e.g. decay or
+ * dissipation, and a non-stiff, possibly nonlinear part:
+ *
+ * dy/dt = f(t, y) + L * y
+ *
+ * f is treated explicitly, and L implicitly by an ESDIRK method (see
+ * imex_tableau). The ODE implements the separated solve() for f, and:
+ *
+ * void solve_implicit(real_t time, real_t dt, cl::Buffer& in, cl::Buffer& out); // out = L * in
+ *
+ * WARNING: L must be complex-linear in the state, and must not depend on
+ * time, e.g. a Lindblad dissipator with constant rates, see propagator_stepper.
+ *
+ * On the first step, L is assembled per matrix as explicit NUM_STATES^2 x
+ * NUM_STATES^2 complex matrix by applying solve_implicit() to all unit basis
+ * states, as in propagator_stepper. If L is diagonal for every matrix, the
+ * stage solves are element-wise, with one work-item per complex element, as
+ * is the final combination of the stages. Otherwise, the stage solves use one
+ * work-item per matrix, and the inverse of I - gamma * h * L is computed on
+ * the host (see matrix_solve() in matrix_exp.hpp), which needs NUM_STATES^2
+ * times the memory of a state, hence dense L is intended for small
+ * NUM_STATES. The operator is cached on the device, and recomputed whenever
+ * step_size changes.
+ *
+ * Since L is linear, every implicit stage is a single direct solve, fused
+ * with forming its right-hand side into one stage kernel launch, without
+ * Newton iterations. L * Y_i is recovered from the solve, i.e. the only
+ * evaluation of solve_implicit() per step is for the explicit first stage.
+ *
+ * NOTE: ark324l2sa and ark436l2sa are stiffly accurate in the implicit part,
+ *       the result is formed from the last stage value, without reading the
+ *       implicit derivatives again
+ * NOTE: d_mem_in and d_mem_out may be the same buffer
+ */
+template<typename ODE_T, imex_method_t METHOD>
+class imex_stepper : public ocl::kernel_wrapper
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::separated;
+
+	// must match NOMA_NUM_IMEX_MAX_STAGES in imex.cl
+	static constexpr size_t max_stages = 6;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	imex_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	// to fullfill the same 'concept' as rk_stepper.hpp, the passed kernel is ignored
+	imex_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+	             const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: imex_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+	imex_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+	             const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: imex_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem) { return step(time, step_size, d_mem, d_mem); }
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os) { accumulate_compile_options(acc_method, os); } // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	static size_t order() { return imex_method_orders.at(METHOD); }
+
+	// true iff L is diagonal, known after the first step
+	bool diagonal() const { return solve_ == solve_t::diagonal; }
+
+	// cost and memory model of step(), see stepper_cost.hpp
+	// NOTE: the one-time assembly of L, and the operator updates on step size changes are not included
+	stepper_cost cost(size_t buffer_size_byte) const;
+
+private:
+	// must match NOMA_NUM_IMEX_SOLVE_* in imex.cl
+	enum class solve_t : int_t { none = 0, diagonal = 1, dense = 2 };
+
+	void assemble_generator(real_t time);
+	void update_operator(real_t step_size);
+
+	// y_out = op * (y + sum(j)(ce[j] * k_e[j] + ci[j] * k_i[j])), see cl/imex.cl, unused coefficients are zero
+	void stage(cl::Buffer& y_out, cl::Buffer& k_i_out, cl::Buffer& y, const std::vector<real_t>& ce, const std::vector<real_t>& ci, solve_t solve, real_t gamma_h);
+
+	// sets an argument of the stage kernel used for solve, i.e. imex_stage for dense, imex_stage_elementwise otherwise
+	template<typename ARG>
+	void set_stage_arg(solve_t solve, cl_uint index, const ARG& arg);
+
+	const imex_tableau& tab_;
+	const size_t stages_;
+
+	ODE_T& ode_;
+	buffer_pool* pool_;
+
+	state_kernels state_;
+
+	const size_t num_matrices_;
+	const size_t state_dim_; // NUM_STATES^2
+
+	kernel_function elementwise_kernel_; // imex_stage_elementwise, global range num_matrices_ * state_dim_
+
+	// host-side operator L, one state_dim_ x state_dim_ matrix per state
+	std::vector<std::vector<complex_t>> generator_;
+	solve_t solve_ = solve_t::dense; // set by assemble_generator()
+
+	// OpenCL buffers
+	cl::Buffer operator_buffer_; // (I - gamma * h * L)^-1, or its diagonal
+	real_t operator_step_size_ = 0.0; // step size of the cached operator, 0.0 means none
+	std::vector<cl::Buffer> k_explicit_buffers_;
+	std::vector<cl::Buffer> k_implicit_buffers_;
+	cl::Buffer stage_buffer_; // Y_i
+
+	static const std::string embedded_ocl_source_;
+};
+
+template<typename ODE_T, imex_method_t METHOD>
+const std::string imex_stepper<ODE_T, METHOD>::embedded_ocl_source_ {
+#include "imex.cl.hpp"  // NOTE: generated by CMake
+};
+
+template<typename ODE_T, imex_method_t METHOD>
+imex_stepper<ODE_T, METHOD>::imex_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, embedded_ocl_source_, "imex_stage", source_header, ocl_compile_options, range),
+	  tab_(get_imex_tableau(METHOD)), stages_(tab_.b.size()), ode_(ode), pool_(pool),
+	  state_(ocl, source_header, ocl_compile_options, range), num_matrices_(state_.num_matrices()), state_dim_(state_.state_dim()),
+	  elementwise_kernel_(ocl, embedded_ocl_source_, "imex_stage_elementwise", source_header, ocl_compile_options, ocl::nd_range(cl::NDRange(num_matrices_ * state_dim_), cl::NullRange))
+{
+	assert(stages_ <= max_stages);
+	assert(ode_.buffer_size_byte() == num_matrices_ * state_dim_ * sizeof(complex_t));
+
+	if (pool)
+		pool->begin_group();
+
+	for (size_t i = 0; i < stages_; ++i) {
+		k_explicit_buffers_.push_back(create_temporary_buffer(ocl_, pool, ode.buffer_size_byte()));
+		k_implicit_buffers_.push_back(create_temporary_buffer(ocl_, pool, ode.buffer_size_byte()));
+	}
+	stage_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+}
+
+template<typename ODE_T, imex_method_t METHOD>
+stepper_cost imex_stepper<ODE_T, METHOD>::cost(size_t buffer_size_byte) const
+{
+	const size_t s = stages_;
+	auto terms = [](const std::vector<real_t>& coeffs) { return static_cast<size_t>(std::count_if(coeffs.begin(), coeffs.end(), [](real_t coeff) { return coeff != 0.0; })); };
+
+	stepper_cost c;
+	// s explicit evaluations, and one implicit for the first stage, each reads one state and writes one
+	c.ode_evaluations = s + 1;
+	c.read_byte = (s + 1) * buffer_size_byte;
+	c.written_byte = (s + 1) * buffer_size_byte;
+
+	// every implicit stage reads y_n, the k's with non-zero coefficients, and the operator, and writes Y_i and L * Y_i
+	const size_t operator_byte = (solve_ == solve_t::diagonal) ? buffer_size_byte : state_dim_ * buffer_size_byte;
+	for (size_t i = 1; i < s; ++i) {
+		++c.weighted_add_launches;
+		const std::vector<real_t> row_implicit(tab_.a_implicit[i].begin(), tab_.a_implicit[i].begin() + i); // without the diagonal
+		c.read_byte += buffer_size_byte + (terms(tab_.a_explicit[i]) + terms(row_implicit)) * buffer_size_byte + operator_byte;
+		c.written_byte += 2 * buffer_size_byte;
+	}
+
+	// the result reads Y_s and the k's whose b differs from the last row, see step()
+	std::vector<real_t> ce(s), ci(s);
+	for (size_t j = 0; j < s; ++j) {
+		ce[j] = tab_.b[j] - tab_.a_explicit[s - 1][j];
+		ci[j] = tab_.b[j] - tab_.a_implicit[s - 1][j];
+	}
+	++c.weighted_add_launches;
+	c.read_byte += (1 + terms(ce) + terms(ci)) * buffer_size_byte;
+	c.written_byte += buffer_size_byte;
+
+	c.temporary_buffers = 2 * s + 2;
+	c.temporary_byte = (2 * s + 1) * buffer_size_byte + operator_byte;
+	return c;
+}
+
+template<typename ODE_T, imex_method_t METHOD>
+void imex_stepper<ODE_T, METHOD>::assemble_generator(real_t time)
+{
+	if (pool_)
+		pool_->begin_group();
+
+	cl::Buffer basis_buffer = create_temporary_buffer(ocl_, pool_, ode_.buffer_size_byte());
+	cl::Buffer column_buffer = create_temporary_buffer(ocl_, pool_, ode_.buffer_size_byte());
+
+	generator_.assign(num_matrices_, std::vector<complex_t>(state_dim_ * state_dim_));
+	std::vector<complex_t> column(num_matrices_ * state_dim_);
+
+	for (size_t c = 0; c < state_dim_; ++c) {
+		// column c of L is L applied to the c-th unit basis state
+		state_.set_basis(basis_buffer, c);
+		ode_.solve_implicit(time, 0.0, basis_buffer, column_buffer);
+
+		cl_int err = ocl_.command_queue().enqueueReadBuffer(column_buffer, CL_TRUE, 0, column.size() * sizeof(complex_t), column.data());
+		ocl::error_handler(err, "clEnqueueReadBuffer(column_buffer)");
+
+		for (size_t m = 0; m < num_matrices_; ++m)
+			for (size_t r = 0; r < state_dim_; ++r)
+				generator_[m][r * state_dim_ + c] = column[m * state_dim_ + r];
+	}
+
+	// element-wise solves, if there is no coupling in any matrix
+	solve_ = solve_t::diagonal;
+	for (size_t m = 0; m < num_matrices_ && solve_ == solve_t::diagonal; ++m)
+		for (size_t r = 0; r < state_dim_; ++r)
+			for (size_t c = 0; c < state_dim_; ++c)
+				if (r != c && generator_[m][r * state_dim_ + c] != complex_t(0.0, 0.0))
+					solve_ = solve_t::dense;
+
+	const size_t operator_size = (solve_ == solve_t::diagonal) ? num_matrices_ * state_dim_ : num_matrices_ * state_dim_ * state_dim_;
+	operator_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, operator_size * sizeof(complex_t), nullptr);
+}
+
+template<typename ODE_T, imex_method_t METHOD>
+void imex_stepper<ODE_T, METHOD>::update_operator(real_t step_size)
+{
+	const real_t gamma_h = tab_.gamma * step_size;
+	std::vector<complex_t> op;
+
+	if (solve_ == solve_t::diagonal) {
+		op.resize(num_matrices_ * state_dim_);
+		for (size_t m = 0; m < num_matrices_; ++m)
+			for (size_t r = 0; r < state_dim_; ++r) {
+				const complex_t d = complex_t(1.0, 0.0) - gamma_h * generator_[m][r * state_dim_ + r];
+				if (d == complex_t(0.0, 0.0))
+					throw std::runtime_error("imex_stepper::update_operator(): error: singular stage operator, i.e. 1 / (gamma * step_size) is an eigenvalue of L.");
+				op[m * state_dim_ + r] = complex_t(1.0, 0.0) / d;
+			}
+	} else {
+		op.resize(num_matrices_ * state_dim_ * state_dim_);
+		std::vector<complex_t> a(state_dim_ * state_dim_);
+		std::vector<complex_t> inverse(state_dim_ * state_dim_);
+		for (size_t m = 0; m < num_matrices_; ++m) {
+			// solve (I - gamma * h * L) * X = I
+			for (size_t i = 0; i < a.size(); ++i)
+				a[i] = -gamma_h * generator_[m][i];
+			std::fill(inverse.begin(), inverse.end(), complex_t(0.0, 0.0));
+			for (size_t r = 0; r < state_dim_; ++r) {
+				a[r * state_dim_ + r] += 1.0;
+				inverse[r * state_dim_ + r] = 1.0;
+			}
+			matrix_solve(a, inverse, state_dim_, state_dim_);
+			std::copy(inverse.begin(), inverse.end(), op.begin() + m * state_dim_ * state_dim_);
+		}
+	}
+
+	cl_int err = ocl_.command_queue().enqueueWriteBuffer(operator_buffer_, CL_TRUE, 0, op.size() * sizeof(complex_t), op.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(operator_buffer_)");
+
+	operator_step_size_ = step_size;
+}
+
+template<typename ODE_T, imex_method_t METHOD>
+template<typename ARG>
+void imex_stepper<ODE_T, METHOD>::set_stage_arg(solve_t solve, cl_uint index, const ARG& arg)
+{
+	if (solve == solve_t::dense) {
+		cl_int err = kernel_.setArg(index, arg);
+		ocl::error_handler(err, "clSetKernelArg(" + std::to_string(index) + ")");
+	} else {
+		elementwise_kernel_.set_arg(index, arg);
+	}
+}
+
+template<typename ODE_T, imex_method_t METHOD>
+void imex_stepper<ODE_T, METHOD>::stage(cl::Buffer& y_out, cl::Buffer& k_i_out, cl::Buffer& y, const std::vector<real_t>& ce, const std::vector<real_t>& ci, solve_t solve, real_t gamma_h)
+{
+	set_stage_arg(solve, 0, y_out);
+	set_stage_arg(solve, 1, k_i_out);
+	set_stage_arg(solve, 2, y);
+
+	// coefficient and k buffer pairs, padded with zero coefficients and y, which is then not read
+	const cl_uint offset = 3;
+	const real_t null_coeff = 0.0;
+	for (cl_uint j = 0; j < max_stages; ++j) {
+		const bool used_e = j < ce.size() && ce[j] != 0.0;
+		set_stage_arg(solve, offset + 2 * j, used_e ? ce[j] : null_coeff);
+		set_stage_arg(solve, offset + 2 * j + 1, used_e ? k_explicit_buffers_[j] : y);
+
+		const bool used_i = j < ci.size() && ci[j] != 0.0;
+		set_stage_arg(solve, offset + 2 * (max_stages + j), used_i ? ci[j] : null_coeff);
+		set_stage_arg(solve, offset + 2 * (max_stages + j) + 1, used_i ? k_implicit_buffers_[j] : y);
+	}
+
+	const cl_uint op_arg = offset + 4 * max_stages;
+	set_stage_arg(solve, op_arg, operator_buffer_);
+	set_stage_arg(solve, op_arg + 1, gamma_h);
+
+	if (solve == solve_t::dense) {
+		run_kernel();
+	} else {
+		elementwise_kernel_.set_arg(op_arg + 2, static_cast<int_t>(solve));
+		elementwise_kernel_.run();
+	}
+}
+
+template<typename ODE_T, imex_method_t METHOD>
+real_t imex_stepper<ODE_T, METHOD>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	if (generator_.empty())
+		assemble_generator(time);
+
+	// rebuild cache if step_size changed
+	if (step_size != operator_step_size_)
+		update_operator(step_size);
+
+	const size_t s = stages_;
+	const real_t h = step_size;
+	std::vector<real_t> ce(s), ci(s);
+
+	// explicit first stage, Y_1 = y_n
+	ode_.solve(time, 0.0, d_mem_in, k_explicit_buffers_[0], tab_.b[0] * h);
+	ode_.solve_implicit(time, 0.0, d_mem_in, k_implicit_buffers_[0]);
+
+	for (size_t i = 1; i < s; ++i) {
+		// Y_i = (I - gamma * h * L)^-1 * (y_n + h * sum(j < i)(a_explicit[i][j] * k_explicit[j] + a_implicit[i][j] * k_implicit[j]))
+		for (size_t j = 0; j < s; ++j) {
+			ce[j] = (j < i) ? h * tab_.a_explicit[i][j] : 0.0;
+			ci[j] = (j < i) ? h * tab_.a_implicit[i][j] : 0.0;
+		}
+		stage(stage_buffer_, k_implicit_buffers_[i], d_mem_in, ce, ci, solve_, tab_.gamma * h);
+
+		ode_.solve(time, tab_.c[i] * h, stage_buffer_, k_explicit_buffers_[i], tab_.b[i] * h);
+	}
+
+	// y_(n+1) = y_n + h * sum(j)(b[j] * (k_explicit[j] + k_implicit[j])) = Y_s + h * sum(j)((b[j] - a[s][j]) * k[j]) for both parts,
+	// i.e. without implicit terms for stiffly accurate methods, NOTE: d_mem_in is no longer read
+	for (size_t j = 0; j < s; ++j) {
+		ce[j] = h * (tab_.b[j] - tab_.a_explicit[s - 1][j]);
+		ci[j] = h * (tab_.b[j] - tab_.a_implicit[s - 1][j]);
+	}
+	stage(d_mem_out, k_implicit_buffers_[0], stage_buffer_, ce, ci, solve_t::none, 0.0);
+
+	// TODO(adaptive time step): use b_cmp, as for rk_stepper
+	return 0.0;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_imex_stepper_hpp
@@ -0,0 +1,67 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_k_storage_hpp
+#define noma_num_k_storage_hpp
+
+#include <iostream>
+#include <map>
+
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Storage formats for the stage derivatives (k buffers) of rk_stepper.
+ * - full: real_t
+ * - half: IEEE 754 binary16, i.e. 11 bit mantissa, limited range (6.1e-5 to 65504 for normal numbers)
+ * - bf16: bfloat16, i.e. 8 bit mantissa, float's range
+ *
+ * The k's enter the state multiplied by h * a_ij, such that their relative
+ * error is damped by the step size. Compressed storage halves (float) or
+ * quarters (double) the k memory and the bandwidth of every weighted add.
+ * The conversion happens in the ODE kernel's stores and the weighted add's
+ * loads, see NOMA_NUM_STORE_K() and NOMA_NUM_LOAD_K() in types.cl.
+ *
+ * NOTE: Use validate_k_storage() (k_storage_validation.hpp) to check whether
+ *       a format is accurate enough for an ODE, step size and tolerance.
+ */
+enum class k_storage {
+	full,
+	half,
+	bf16
+};
+
+const std::map<k_storage, std::string> k_storage_names {
+	{ k_storage::full, "full" },
+	{ k_storage::half, "half" },
+	{ k_storage::bf16, "bf16" }
+};
+
+std::ostream& operator<<(std::ostream& out, const k_storage& s);
+std::istream& operator>>(std::istream& in, k_storage& s);
+
+// bytes per real element of a k buffer
+size_t k_storage_element_size_byte(k_storage storage);
+
+// writes the OpenCL defines the ODE and weighted add kernels need for storage, i.e. NOMA_NUM_K_STORAGE_HALF or NOMA_NUM_K_STORAGE_BF16
+void k_storage_compile_options(k_storage storage, std::ostream& os);
+
+/**
+ * Outcome of validate_k_storage().
+ */
+struct k_storage_report
+{
+	real_t max_abs_error = 0.0; // max. absolute difference to the full storage result over all elements
+	real_t max_rel_error = 0.0; // max_abs_error relative to the max. norm of the full storage result
+	size_t bytes_per_k_element = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const k_storage_report& report);
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_k_storage_hpp
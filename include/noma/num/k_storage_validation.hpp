@@ -0,0 +1,98 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_k_storage_validation_hpp
+#define noma_num_k_storage_validation_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/autotuner.hpp"
+#include "noma/num/k_storage.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+namespace detail {
+
+// integrates state in place with rk_stepper<ODE, RKM, ACC_METHOD, K_STORAGE>, built on a fresh ODE from factory
+template<typename ODE, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE>
+void k_storage_integrate(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+                         const ode_factory<ODE>& factory, std::vector<complex_t>& state, real_t time, real_t step_size, size_t num_steps)
+{
+	using stepper_type = rk_stepper<ODE, RKM, ACC_METHOD, K_STORAGE>;
+
+	std::stringstream header;
+	stepper_type::ode_compile_options(header);
+	header << source_header;
+
+	std::unique_ptr<ODE> ode = factory(header.str(), range);
+	stepper_type stepper(ocl, header.str(), ocl_compile_options, range, *ode);
+
+	const size_t size_byte = state.size() * sizeof(complex_t);
+	if (size_byte != ode->buffer_size_byte())
+		throw std::runtime_error("validate_k_storage(): error: state size does not match the ODE's buffer size");
+
+	cl::Buffer in = ocl.create_buffer(CL_MEM_READ_WRITE, size_byte, nullptr);
+	cl::Buffer out = ocl.create_buffer(CL_MEM_READ_WRITE, size_byte, nullptr);
+	cl_int err = ocl.command_queue().enqueueWriteBuffer(in, CL_FALSE, 0, size_byte, state.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(in)");
+
+	for (size_t i = 0; i < num_steps; ++i) {
+		stepper.step(time + static_cast<real_t>(i) * step_size, step_size, in, out);
+		std::swap(in, out);
+	}
+
+	err = ocl.command_queue().enqueueReadBuffer(in, CL_TRUE, 0, size_byte, state.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(in)");
+}
+
+} // namespace detail
+
+/**
+ * Accuracy validation for compressed k storage: integrates initial_state over
+ * num_steps steps, once with full and once with K_STORAGE k buffers, and
+ * compares the results. The difference is the error added by the compression,
+ * on top of the method's own error, and should stay well below the tolerance
+ * of the application, e.g. max_rel_error < 0.1 * tolerance.
+ *
+ * The factory is called with the complete source header, i.e. including the
+ * stepper's ODE compile options, see autotuner.hpp.
+ */
+template<typename ODE, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE>
+k_storage_report validate_k_storage(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+                                    const ode_factory<ODE>& factory, const std::vector<complex_t>& initial_state,
+                                    real_t time, real_t step_size, size_t num_steps)
+{
+	std::vector<complex_t> reference(initial_state);
+	detail::k_storage_integrate<ODE, RKM, ACC_METHOD, k_storage::full>(ocl, source_header, ocl_compile_options, range, factory, reference, time, step_size, num_steps);
+
+	std::vector<complex_t> compressed(initial_state);
+	detail::k_storage_integrate<ODE, RKM, ACC_METHOD, K_STORAGE>(ocl, source_header, ocl_compile_options, range, factory, compressed, time, step_size, num_steps);
+
+	k_storage_report report;
+	real_t reference_norm = 0.0;
+	for (size_t i = 0; i < reference.size(); ++i) {
+		report.max_abs_error = std::max(report.max_abs_error, static_cast<real_t>(std::abs(compressed[i] - reference[i])));
+		reference_norm = std::max(reference_norm, static_cast<real_t>(std::abs(reference[i])));
+	}
+	report.max_rel_error = reference_norm > 0.0 ? report.max_abs_error / reference_norm : report.max_abs_error;
+	report.bytes_per_k_element = k_storage_element_size_byte(K_STORAGE);
+
+	return report;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_k_storage_validation_hpp
@@ -0,0 +1,72 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_kernel_function_hpp
+#define noma_num_kernel_function_hpp
+
+#include <string>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+namespace noma {
+namespace num {
+
+/**
+ * Wraps a single OpenCL kernel that is called like a function, i.e. all
+ * kernel arguments are set in order, and the kernel is run, by operator().
+ *
+ * Intended for steppers that need more kernels than the one of their
+ * kernel_wrapper super class.
+ *
+ * NOTE: argument types must match the kernel signature exactly, e.g. int_t
+ *       for int and real_t for real_t arguments.
+ */
+class kernel_function : public ocl::kernel_wrapper
+{
+public:
+	kernel_function(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+	                const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range)
+		: ocl::kernel_wrapper(ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range)
+	{ }
+
+	template<typename... ARGS>
+	void operator()(const ARGS&... args)
+	{
+		set_args(0, args...);
+		run_kernel();
+	}
+
+	// as operator(), followed by a runtime number of arguments of the same type, e.g. the k buffers of a generated kernel
+	template<typename ARG, typename... ARGS>
+	void run_with_trailing(const std::vector<ARG>& trailing_args, const ARGS&... args)
+	{
+		set_args(0, args...);
+		for (size_t l = 0; l < trailing_args.size(); ++l)
+			set_args(static_cast<cl_uint>(sizeof...(ARGS) + l), trailing_args[l]);
+		run_kernel();
+	}
+
+	// as operator(), for argument lists assembled at runtime: set_arg() for every argument, followed by run()
+	template<typename ARG>
+	void set_arg(cl_uint index, const ARG& arg) { set_args(index, arg); }
+	void run() { run_kernel(); }
+
+private:
+	void set_args(cl_uint) { }
+
+	template<typename ARG, typename... ARGS>
+	void set_args(cl_uint index, const ARG& arg, const ARGS&... args)
+	{
+		cl_int err = kernel_.setArg(index, arg);
+		ocl::error_handler(err, "clSetKernelArg(" + std::to_string(index) + ")");
+		set_args(index + 1, args...);
+	}
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_kernel_function_hpp
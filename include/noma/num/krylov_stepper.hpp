@@ -0,0 +1,328 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_krylov_stepper_hpp
+#define noma_num_krylov_stepper_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/matrix_exp.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/state_kernels.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * This class template performs a single integration step by projecting the
+ * propagator exp(h * L) onto a Krylov subspace of dimension m <= MAX_DIM:
+ *
+ * exp(h * L) * y_n ~ beta * V_m * exp(h * H_m) * e_1, with beta = ||y_n||
+ *
+ * V_m is the orthonormal basis of span(y_n, L * y_n, ..., L^(m-1) * y_n),
+ * built by Arnoldi iteration with one evaluation of ODE_T per dimension, and
+ * classical Gram-Schmidt with reorthogonalisation on the device. H_m is the
+ * small m x m upper Hessenberg matrix, exp(h * H_m) is computed on the host
+ * per matrix (see matrix_exp.hpp).
+ *
+ * WARNING: This is mathematically correct iff ODE_T is linear and L does not
+ * depend on time during a step.
+ *
+ * The dimension adapts per step: the subspace is extended until the
+ * a-posteriori error estimate beta * h_(m+1,m) * |e_m^T exp(h * H_m) e_1|
+ * is below tolerance * beta for all matrices, or MAX_DIM is reached.
+ *
+ * MAX_DIM + 1 temporary state buffers are required.
+ */
+template<typename ODE_T, size_t MAX_DIM = 30>
+class krylov_stepper : public ocl::kernel_wrapper // NOTE: this class does not wrap a kernel itself, but uses several kernel_function members
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::separated;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	krylov_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	// to fullfill the same 'concept' as rk_stepper.hpp, the passed kernel is ignored
+	krylov_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+	               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: krylov_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+	krylov_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+	               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: krylov_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards, through a spare buffer (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	// relative error bound for the a-posteriori estimate
+	void tolerance(real_t tol) { tolerance_ = tol; }
+	real_t tolerance() const { return tolerance_; }
+
+	// Krylov dimension used by the last step, i.e. number of ODE evaluations
+	size_t dimension() const { return dimension_; }
+
+	// cost and memory model of step() for the dimension() of the last step, or MAX_DIM before the first one, see stepper_cost.hpp
+	stepper_cost cost(size_t buffer_size_byte) const;
+
+private:
+	void orthogonalise(size_t j);
+	void read_coeffs(std::vector<complex_t>& coeffs);
+	bool converged(real_t step_size, size_t m);
+
+	cl::Buffer& basis_vector(size_t first, size_t l) { return first + l < basis_.size() ? basis_[first + l] : basis_[0]; }
+
+	ODE_T& ode_;
+
+	state_kernels state_;
+	kernel_function dot_kernel_;
+	kernel_function combine_kernel_;
+	kernel_function normalise_kernel_;
+
+	const size_t num_matrices_;
+	static constexpr size_t stride_ = MAX_DIM + 1; // per-matrix coefficients in coeffs_buffer_
+
+	real_t tolerance_ = 1.0e3 * std::numeric_limits<real_t>::epsilon();
+	const size_t min_dim_ = 4; // first dimension for which convergence is checked
+	size_t dimension_ = 0;
+
+	// host-side data, per matrix
+	std::vector<real_t> beta_;
+	std::vector<std::vector<complex_t>> hessenberg_; // stride_ x stride_, row-major
+	std::vector<std::vector<complex_t>> exp_hessenberg_; // of the last convergence check
+
+	// OpenCL buffers
+	spare_buffer spare_; // y_(n+1) of the in-place step(), copied back into d_mem
+	std::vector<cl::Buffer> basis_;
+	cl::Buffer coeffs_buffer_;
+	cl::Buffer norms_buffer_;
+
+	// constants derived from the OpenCL implementation
+	// NOTE: must be consistent with NOMA_NUM_KRYLOV_VECTORS in krylov.cl
+	static constexpr size_t max_vectors_in_kernel_ = 8;
+
+	static const std::string embedded_ocl_source_;
+};
+
+template<typename ODE_T, size_t MAX_DIM>
+const std::string krylov_stepper<ODE_T, MAX_DIM>::embedded_ocl_source_ {
+#include "krylov.cl.hpp"  // NOTE: generated by CMake
+};
+
+template<typename ODE_T, size_t MAX_DIM>
+krylov_stepper<ODE_T, MAX_DIM>::krylov_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: kernel_wrapper(ocl), ode_(ode), // NOTE: dummy initialisation of kernel_wrapper
+	  state_(ocl, source_header, ocl_compile_options, range),
+	  dot_kernel_(ocl, embedded_ocl_source_, "krylov_dot", source_header, ocl_compile_options, range),
+	  combine_kernel_(ocl, embedded_ocl_source_, "krylov_combine", source_header, ocl_compile_options, range),
+	  normalise_kernel_(ocl, embedded_ocl_source_, "krylov_normalise", source_header, ocl_compile_options, range),
+	  num_matrices_(state_.num_matrices())
+{
+	static_assert(MAX_DIM >= 1, "krylov_stepper: MAX_DIM must be at least 1");
+
+	if (pool)
+		pool->begin_group();
+
+	for (size_t i = 0; i < MAX_DIM + 1; ++i)
+		basis_.push_back(create_temporary_buffer(ocl_, pool, ode.buffer_size_byte()));
+
+	coeffs_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, num_matrices_ * stride_ * sizeof(complex_t), nullptr);
+	norms_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, num_matrices_ * sizeof(real_t), nullptr);
+
+	beta_.resize(num_matrices_);
+	hessenberg_.resize(num_matrices_, std::vector<complex_t>(stride_ * stride_));
+	exp_hessenberg_.resize(num_matrices_);
+}
+
+template<typename ODE_T, size_t MAX_DIM>
+void krylov_stepper<ODE_T, MAX_DIM>::ode_compile_options(std::ostream&)
+{
+	// NOTE: plain ODE evaluation, nothing to define
+}
+
+template<typename ODE_T, size_t MAX_DIM>
+stepper_cost krylov_stepper<ODE_T, MAX_DIM>::cost(size_t buffer_size_byte) const
+{
+	const size_t m = (dimension_ > 0) ? dimension_ : MAX_DIM;
+	auto chunks = [](size_t vectors) { return (vectors + max_vectors_in_kernel_ - 1) / max_vectors_in_kernel_; };
+
+	stepper_cost c;
+	// v_0 = y_n / beta
+	c.weighted_add_launches = 1;
+	c.read_byte = buffer_size_byte;
+	c.written_byte = buffer_size_byte;
+
+	for (size_t j = 0; j < m; ++j) {
+		// w = L * v_j
+		++c.ode_evaluations;
+		c.read_byte += buffer_size_byte;
+		c.written_byte += buffer_size_byte;
+
+		// two passes of dot products and updates, each krylov_dot and krylov_combine launch reads w and up to max_vectors_in_kernel_ basis vectors
+		const size_t n = chunks(j + 1);
+		c.weighted_add_launches += 2 * 2 * n;
+		c.read_byte += 2 * 2 * (j + 1 + n) * buffer_size_byte;
+		c.written_byte += 2 * n * buffer_size_byte;
+
+		// normalisation in place
+		++c.weighted_add_launches;
+		c.read_byte += buffer_size_byte;
+		c.written_byte += buffer_size_byte;
+	}
+
+	// y_(n+1) = beta * V_m * exp(h * H_m) * e_1, all but the first launch accumulate into d_mem_out
+	const size_t n = chunks(m);
+	c.weighted_add_launches += n;
+	c.read_byte += (m + n - 1) * buffer_size_byte;
+	c.written_byte += n * buffer_size_byte;
+
+	c.temporary_buffers = MAX_DIM + 1;
+	c.temporary_byte = (MAX_DIM + 1) * buffer_size_byte;
+	c.spare_byte = buffer_size_byte;
+	return c;
+}
+
+template<typename ODE_T, size_t MAX_DIM>
+void krylov_stepper<ODE_T, MAX_DIM>::read_coeffs(std::vector<complex_t>& coeffs)
+{
+	coeffs.resize(num_matrices_ * stride_);
+	cl_int err = ocl_.command_queue().enqueueReadBuffer(coeffs_buffer_, CL_TRUE, 0, coeffs.size() * sizeof(complex_t), coeffs.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(coeffs_buffer_)");
+}
+
+template<typename ODE_T, size_t MAX_DIM>
+void krylov_stepper<ODE_T, MAX_DIM>::orthogonalise(size_t j)
+{
+	// orthogonalise basis_[j + 1] against basis_[0..j], twice for numerical stability (CGS2)
+	cl::Buffer& w = basis_[j + 1];
+	std::vector<complex_t> coeffs;
+
+	for (size_t pass = 0; pass < 2; ++pass) {
+		for (size_t first = 0; first <= j; first += max_vectors_in_kernel_) {
+			const size_t n = std::min(max_vectors_in_kernel_, j + 1 - first);
+			dot_kernel_(coeffs_buffer_, static_cast<int_t>(stride_), static_cast<int_t>(first), static_cast<int_t>(n), w,
+			            basis_vector(first, 0), basis_vector(first, 1), basis_vector(first, 2), basis_vector(first, 3),
+			            basis_vector(first, 4), basis_vector(first, 5), basis_vector(first, 6), basis_vector(first, 7));
+		}
+		// NOTE: all dot products are computed before updating w, i.e. classical Gram-Schmidt
+		for (size_t first = 0; first <= j; first += max_vectors_in_kernel_) {
+			const size_t n = std::min(max_vectors_in_kernel_, j + 1 - first);
+			combine_kernel_(w, static_cast<int_t>(0), static_cast<real_t>(-1.0), coeffs_buffer_, static_cast<int_t>(stride_), static_cast<int_t>(first), static_cast<int_t>(n),
+			                basis_vector(first, 0), basis_vector(first, 1), basis_vector(first, 2), basis_vector(first, 3),
+			                basis_vector(first, 4), basis_vector(first, 5), basis_vector(first, 6), basis_vector(first, 7));
+		}
+
+		read_coeffs(coeffs);
+		for (size_t m = 0; m < num_matrices_; ++m)
+			for (size_t i = 0; i <= j; ++i)
+				hessenberg_[m][i * stride_ + j] += coeffs[m * stride_ + i];
+	}
+}
+
+template<typename ODE_T, size_t MAX_DIM>
+bool krylov_stepper<ODE_T, MAX_DIM>::converged(real_t step_size, size_t m)
+{
+	bool result = true;
+	std::vector<complex_t> h_m(m * m);
+
+	for (size_t s = 0; s < num_matrices_; ++s) {
+		for (size_t i = 0; i < m; ++i)
+			for (size_t j = 0; j < m; ++j)
+				h_m[i * m + j] = step_size * hessenberg_[s][i * stride_ + j];
+
+		exp_hessenberg_[s] = matrix_exp(h_m, m);
+
+		// a-posteriori estimate, relative to beta
+		const real_t h_next = std::abs(hessenberg_[s][m * stride_ + (m - 1)]);
+		const real_t estimate = h_next * std::abs(exp_hessenberg_[s][(m - 1) * m + 0]);
+		if (estimate > tolerance_)
+			result = false;
+	}
+
+	return result;
+}
+
+template<typename ODE_T, size_t MAX_DIM>
+real_t krylov_stepper<ODE_T, MAX_DIM>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	for (auto& h : hessenberg_)
+		std::fill(h.begin(), h.end(), complex_t(0.0));
+
+	cl_int err = 0;
+
+	// v_0 = y_n / beta
+	normalise_kernel_(basis_[0], norms_buffer_, d_mem_in);
+	err = ocl_.command_queue().enqueueReadBuffer(norms_buffer_, CL_TRUE, 0, beta_.size() * sizeof(real_t), beta_.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(norms_buffer_)");
+
+	std::vector<real_t> norms(num_matrices_);
+	size_t m = 0;
+	bool done = false;
+	while (!done) {
+		// w = L * v_m, written to the next basis vector
+		// NOTE: time step of 1.0, and accumulation coefficient 1.0 as in taylor_stepper, L is assumed constant during the step
+		ode_.solve(time, 1.0, basis_[m], basis_[m + 1], 1.0);
+
+		orthogonalise(m);
+
+		// h_(m+1,m) = ||w||, v_(m+1) = w / h_(m+1,m)
+		normalise_kernel_(basis_[m + 1], norms_buffer_, basis_[m + 1]);
+		err = ocl_.command_queue().enqueueReadBuffer(norms_buffer_, CL_TRUE, 0, norms.size() * sizeof(real_t), norms.data());
+		ocl::error_handler(err, "clEnqueueReadBuffer(norms_buffer_)");
+		for (size_t s = 0; s < num_matrices_; ++s)
+			hessenberg_[s][(m + 1) * stride_ + m] = norms[s];
+
+		++m;
+
+		const bool check = (m >= min_dim_) || (m == MAX_DIM);
+		done = (check && converged(step_size, m)) || (m == MAX_DIM);
+	}
+	// NOTE: the last iteration always checks, i.e. exp_hessenberg_ is for m
+
+	dimension_ = m;
+
+	// y_(n+1) = beta * V_m * exp(h * H_m) * e_1
+	std::vector<complex_t> coeffs(num_matrices_ * stride_, complex_t(0.0));
+	for (size_t s = 0; s < num_matrices_; ++s)
+		for (size_t i = 0; i < m; ++i)
+			coeffs[s * stride_ + i] = beta_[s] * exp_hessenberg_[s][i * m + 0];
+	err = ocl_.command_queue().enqueueWriteBuffer(coeffs_buffer_, CL_TRUE, 0, coeffs.size() * sizeof(complex_t), coeffs.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(coeffs_buffer_)");
+
+	for (size_t first = 0; first < m; first += max_vectors_in_kernel_) {
+		const size_t n = std::min(max_vectors_in_kernel_, m - first);
+		combine_kernel_(d_mem_out, static_cast<int_t>(first == 0), static_cast<real_t>(1.0), coeffs_buffer_, static_cast<int_t>(stride_), static_cast<int_t>(first), static_cast<int_t>(n),
+		                basis_vector(first, 0), basis_vector(first, 1), basis_vector(first, 2), basis_vector(first, 3),
+		                basis_vector(first, 4), basis_vector(first, 5), basis_vector(first, 6), basis_vector(first, 7));
+	}
+
+	return 0.0;
+}
+
+template<typename ODE_T, size_t MAX_DIM>
+real_t krylov_stepper<ODE_T, MAX_DIM>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_krylov_stepper_hpp
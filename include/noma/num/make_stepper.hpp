@@ -9,6 +9,7 @@
 
 #include <memory>
 
+#include "noma/num/buffer_pool.hpp"
 #include "noma/num/meta_stepper.hpp"
 #include "noma/num/polymorphic_stepper.hpp"
 #include "noma/num/rk_stepper.hpp"
@@ -35,10 +36,10 @@ namespace num {
  */
 template<typename ODE, typename STEPPER>
 typename std::enable_if<!std::is_same<STEPPER, num::meta_stepper>::value, STEPPER>::type // return type is not meta_stepper
-make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
+make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
 {
 	// NOTE: stepper type is ignored
-	return STEPPER(ocl, source_header, ocl_compile_options, range, ode);
+	return STEPPER(ocl, source_header, ocl_compile_options, range, ode, pool);
 }
 
 /**
@@ -48,10 +49,10 @@ make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const st
  */
 template<typename ODE, typename STEPPER>
 typename std::enable_if<std::is_same<STEPPER, num::meta_stepper>::value, STEPPER>::type // return type is meta_stepper
-make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
+make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
 {
 	// NOTE: stepper type is passed
-	return STEPPER(stepper_type, ocl, source_header, ocl_compile_options, range, ode);
+	return STEPPER(stepper_type, ocl, source_header, ocl_compile_options, range, ode, pool);
 }
 
 /**
@@ -61,10 +62,10 @@ make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const st
  */
 template<typename ODE, typename STEPPER>
 typename std::enable_if<!std::is_same<STEPPER, num::meta_stepper>::value, STEPPER>::type // return type is not meta_stepper
-make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
+make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
 {
 	// NOTE: stepper type is ignored
-	return STEPPER(ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode);
+	return STEPPER(ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode, pool);
 }
 
 /**
@@ -74,10 +75,10 @@ make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const st
  */
 template<typename ODE, typename STEPPER>
 typename std::enable_if<std::is_same<STEPPER, num::meta_stepper>::value, STEPPER>::type // return type is meta_stepper
-make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
+make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
 {
 	// NOTE: stepper type is passed
-	return STEPPER(stepper_type, ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode);
+	return STEPPER(stepper_type, ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode, pool);
 }
 
 /**
@@ -87,10 +88,10 @@ make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const st
  */
 template<typename ODE, typename STEPPER>
 typename std::enable_if<!std::is_same<STEPPER, num::meta_stepper>::value, STEPPER>::type // return type is not meta_stepper
-make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
+make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
 {
 	// NOTE: stepper type is ignored
-	return STEPPER(ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode);
+	return STEPPER(ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode, pool);
 }
 
 /**
@@ -100,10 +101,10 @@ make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const bo
  */
 template<typename ODE, typename STEPPER>
 typename std::enable_if<std::is_same<STEPPER, num::meta_stepper>::value, STEPPER>::type // return type is meta_stepper
-make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
+make_stepper(const num::stepper_type_t& stepper_type, ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
 {
 	// NOTE: stepper type is passed
-	return STEPPER(stepper_type, ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode);
+	return STEPPER(stepper_type, ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode, pool);
 }
 
 
@@ -125,59 +126,103 @@ void make_stepper_ode_compile_option(const num::stepper_type_t& stepper_type, st
 {
 	// NOTE: this switch is the ugly but necessary way to get from the runtime stepper_type value, to an actual compile-time stepper type
 	switch (stepper_type) {
-		case stepper_type_t::rk_euler:
-			stepper_type_to_type<ODE, stepper_type_t::rk_euler>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::rk_midpoint:
-			stepper_type_to_type<ODE, stepper_type_t::rk_midpoint>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::rk_rk4:
-			stepper_type_to_type<ODE, stepper_type_t::rk_rk4>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::rk_fehlberg54:
-			stepper_type_to_type<ODE, stepper_type_t::rk_fehlberg54>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::rk_dopri54:
-			stepper_type_to_type<ODE, stepper_type_t::rk_dopri54>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::rk_cashkarp54:
-			stepper_type_to_type<ODE, stepper_type_t::rk_cashkarp54>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::rk_bosha32:
-			stepper_type_to_type<ODE, stepper_type_t::rk_bosha32>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_1:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_1>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_2:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_2>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_3:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_3>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_4:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_4>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_5:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_5>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_6:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_6>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_7:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_7>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_8:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_8>::type::ode_compile_options(os);
-			break;
-		case stepper_type_t::taylor_9:
-			stepper_type_to_type<ODE, stepper_type_t::taylor_9>::type::ode_compile_options(os);
+#define NOMA_NUM_STEPPER_TYPE_CASE(name, ...) \
+		case stepper_type_t::name: \
+			stepper_type_to_type<ODE, stepper_type_t::name>::type::ode_compile_options(os); \
 			break;
+		NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_CASE)
+#undef NOMA_NUM_STEPPER_TYPE_CASE
 		default:
 			throw std::runtime_error("make_stepper_ode_compile_option(): error: called with unhandled stepper_type.");
 	}
 }
 
+/**
+ * Generator function for the cost and memory model (see stepper_cost.hpp),
+ * for all stepper types but meta_stepper, i.e. before creating a stepper.
+ */
+template<typename ODE, typename STEPPER, typename std::enable_if<!std::is_same<STEPPER, num::meta_stepper>::value, int>::type = 0> // type is not meta_stepper
+stepper_cost make_stepper_cost(const num::stepper_type_t& stepper_type, size_t buffer_size_byte)
+{
+	// NOTE: stepper type is ignored, we call static member function of stepper
+	return STEPPER::cost(buffer_size_byte);
+}
+
+/**
+ * Generator function for the cost and memory model (see stepper_cost.hpp),
+ * for meta_stepper, i.e. before creating a stepper.
+ */
+template<typename ODE, typename STEPPER, typename std::enable_if<std::is_same<STEPPER, num::meta_stepper>::value, int>::type = 0> //  type is meta_stepper
+stepper_cost make_stepper_cost(const num::stepper_type_t& stepper_type, size_t buffer_size_byte)
+{
+	// NOTE: this switch is the ugly but necessary way to get from the runtime stepper_type value, to an actual compile-time stepper type
+	switch (stepper_type) {
+#define NOMA_NUM_STEPPER_TYPE_CASE(name, ...) \
+		case stepper_type_t::name: \
+			return stepper_type_to_type<ODE, stepper_type_t::name>::type::cost(buffer_size_byte);
+		NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_CASE)
+#undef NOMA_NUM_STEPPER_TYPE_CASE
+		default:
+			throw std::runtime_error("make_stepper_cost(): error: called with unhandled stepper_type.");
+	}
+}
+
+/**
+ * Generator function for the nominal order of the method, for all stepper types but meta_stepper.
+ */
+template<typename ODE, typename STEPPER, typename std::enable_if<!std::is_same<STEPPER, num::meta_stepper>::value, int>::type = 0> // type is not meta_stepper
+size_t make_stepper_order(const num::stepper_type_t& stepper_type)
+{
+	// NOTE: stepper type is ignored, we call static member function of stepper
+	return STEPPER::order();
+}
+
+/**
+ * Generator function for the nominal order of the method, for meta_stepper.
+ */
+template<typename ODE, typename STEPPER, typename std::enable_if<std::is_same<STEPPER, num::meta_stepper>::value, int>::type = 0> //  type is meta_stepper
+size_t make_stepper_order(const num::stepper_type_t& stepper_type)
+{
+	// NOTE: this switch is the ugly but necessary way to get from the runtime stepper_type value, to an actual compile-time stepper type
+	switch (stepper_type) {
+#define NOMA_NUM_STEPPER_TYPE_CASE(name, ...) \
+		case stepper_type_t::name: \
+			return stepper_type_to_type<ODE, stepper_type_t::name>::type::order();
+		NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_CASE)
+#undef NOMA_NUM_STEPPER_TYPE_CASE
+		default:
+			throw std::runtime_error("make_stepper_order(): error: called with unhandled stepper_type.");
+	}
+}
+
+/**
+ * Generator function for the accumulate method, i.e. the one the ODE must be created for, for all stepper types but meta_stepper.
+ */
+template<typename ODE, typename STEPPER, typename std::enable_if<!std::is_same<STEPPER, num::meta_stepper>::value, int>::type = 0> // type is not meta_stepper
+accumulate_method make_stepper_acc_method(const num::stepper_type_t& stepper_type)
+{
+	// NOTE: stepper type is ignored
+	return STEPPER::acc_method;
+}
+
+/**
+ * Generator function for the accumulate method, i.e. the one the ODE must be created for, for meta_stepper.
+ */
+template<typename ODE, typename STEPPER, typename std::enable_if<std::is_same<STEPPER, num::meta_stepper>::value, int>::type = 0> //  type is meta_stepper
+accumulate_method make_stepper_acc_method(const num::stepper_type_t& stepper_type)
+{
+	// NOTE: this switch is the ugly but necessary way to get from the runtime stepper_type value, to an actual compile-time stepper type
+	switch (stepper_type) {
+#define NOMA_NUM_STEPPER_TYPE_CASE(name, ...) \
+		case stepper_type_t::name: \
+			return stepper_type_to_type<ODE, stepper_type_t::name>::type::acc_method;
+		NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_CASE)
+#undef NOMA_NUM_STEPPER_TYPE_CASE
+		default:
+			throw std::runtime_error("make_stepper_acc_method(): error: called with unhandled stepper_type.");
+	}
+}
+
 } // namespace num
 } // namespace noma
 
@@ -0,0 +1,39 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_matrix_exp_hpp
+#define noma_num_matrix_exp_hpp
+
+#include <cstddef>
+#include <vector>
+
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Host-side exponential of a small, dense, complex n x n matrix, stored
+ * row-major in a vector of size n*n.
+ *
+ * Uses scaling and squaring with a diagonal (6,6) Pade approximant, which is
+ * accurate to double precision for the scaled matrix (1-norm <= 1/2).
+ *
+ * Instantiated for complex_t and long_complex_t.
+ */
+template<typename COMPLEX_T>
+std::vector<COMPLEX_T> matrix_exp(const std::vector<COMPLEX_T>& a, size_t n);
+
+/**
+ * Solves a * x = b for x, with a: n x n and b, x: n x m, all row-major, by
+ * Gaussian elimination with partial pivoting. Both arguments are overwritten,
+ * the solution is returned in b.
+ */
+template<typename COMPLEX_T>
+void matrix_solve(std::vector<COMPLEX_T>& a, std::vector<COMPLEX_T>& b, size_t n, size_t m);
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_matrix_exp_hpp
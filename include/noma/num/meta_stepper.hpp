@@ -8,6 +8,7 @@
 #include <memory>
 #include <noma/ocl/helper.hpp>
 
+#include "noma/num/buffer_pool.hpp"
 #include "noma/num/polymorphic_stepper.hpp"
 
 namespace noma {
@@ -23,20 +24,20 @@ class meta_stepper {
 public:
 
 	template<typename ODE>
-	meta_stepper(const stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
-		: poly_stepper_(make_unique_polymorphic_stepper<ODE>(stepper_type, ocl, source_header, ocl_compile_options, range, ode)) // NOTE: all but first are ctor arguments
+	meta_stepper(const stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
+		: poly_stepper_(make_unique_polymorphic_stepper<ODE>(stepper_type, ocl, source_header, ocl_compile_options, range, ode, pool)) // NOTE: all but first are ctor arguments
 	{ }
 
 	template<typename ODE>
 	meta_stepper(const stepper_type_t& stepper_type, ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
-	             const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
-		: poly_stepper_(make_unique_polymorphic_stepper<ODE>(stepper_type, ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode)) // NOTE: all but first are ctor arguments
+	             const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
+		: poly_stepper_(make_unique_polymorphic_stepper<ODE>(stepper_type, ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode, pool)) // NOTE: all but first are ctor arguments
 	{ }
 
 	template<typename ODE>
 	meta_stepper(const stepper_type_t& stepper_type, ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
-	             const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode)
-		: poly_stepper_(make_unique_polymorphic_stepper<ODE>(stepper_type, ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode)) // NOTE: all but first are ctor arguments
+	             const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE& ode, buffer_pool* pool = nullptr)
+		: poly_stepper_(make_unique_polymorphic_stepper<ODE>(stepper_type, ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode, pool)) // NOTE: all but first are ctor arguments
 	{ }
 
 
@@ -46,6 +47,16 @@ public:
 		return poly_stepper_->step(time, step_size, d_mem_in, d_mem_out);
 	}
 
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem)
+	{
+		return poly_stepper_->step(time, step_size, d_mem);
+	}
+
+	stepper_cost cost(size_t buffer_size_byte) const
+	{
+		return poly_stepper_->cost(buffer_size_byte);
+	}
+
 	// public kernel wrapper interface (expected super class of stepper)
 	ocl::helper& ocl_helper()
 	{
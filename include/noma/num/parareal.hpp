@@ -0,0 +1,86 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_parareal_hpp
+#define noma_num_parareal_hpp
+
+#include <iostream>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/streaming_integrator.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Outcome of parareal::run().
+ */
+struct parareal_report
+{
+	size_t iterations = 0; // Parareal iterations, i.e. parallel fine sweeps
+	real_t correction = 0.0; // max. norm of the last update of the slice boundaries, relative to the state
+	bool converged = false;
+	double wall_time = 0.0; // seconds
+	double fine_slice_time = 0.0; // mean seconds per fine propagation of one slice
+	double serial_time = 0.0; // estimated seconds of a sequential fine integration, i.e. num_slices * fine_slice_time
+	double speedup = 0.0; // serial_time / wall_time
+};
+
+std::ostream& operator<<(std::ostream& out, const parareal_report& report);
+
+/**
+ * Parareal parallel-in-time integration:
+ *
+ * U_(n+1)^(k+1) = G(U_n^(k+1)) + F(U_n^k) - G(U_n^k)
+ *
+ * G is a cheap coarse stepper, F an accurate fine stepper, both applied over
+ * one of num_slices time slices. The fine propagations of all slices of an
+ * iteration are independent, and are distributed round-robin over the fine
+ * workers, one host thread each. A worker is an ocl::helper, i.e. a device,
+ * sub-device, or just another command queue, with its own ODE and fine
+ * stepper created by the fine factory.
+ *
+ * States are staged through host memory between the coarse and the fine
+ * workers, as these may live in different contexts. After k iterations, the
+ * first k slices equal the sequential fine solution, and are not recomputed.
+ */
+class parareal
+{
+public:
+	// the factories are called with num_matrices, e.g. make_stepper() of rk_euler and rk_dopri54 with the matching ODE
+	parareal(ocl::helper& coarse_ocl, chunk_stepper_factory coarse_factory,
+	         const std::vector<ocl::helper*>& fine_ocls, chunk_stepper_factory fine_factory,
+	         size_t num_matrices);
+
+	/**
+	 * Integrates state from t_begin to t_end, in place.
+	 * Stops after max_iterations, or when the relative correction is below tolerance.
+	 */
+	parareal_report run(std::vector<complex_t>& state, real_t t_begin, real_t t_end, size_t num_slices,
+	                    size_t coarse_steps_per_slice, size_t fine_steps_per_slice,
+	                    real_t tolerance, size_t max_iterations);
+
+private:
+	struct worker {
+		ocl::helper* ocl;
+		chunk_stepper stepper;
+		cl::Buffer state; // integrated by the in-place step()
+		size_t size_byte = 0; // of state
+	};
+
+	// integrates state over num_steps steps in place, on w's device
+	static void propagate(worker& w, std::vector<complex_t>& state, real_t time, real_t step_size, size_t num_steps);
+	void allocate(worker& w, size_t size_byte);
+
+	worker coarse_;
+	std::vector<worker> fine_;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_parareal_hpp
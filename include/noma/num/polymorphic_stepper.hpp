@@ -8,7 +8,9 @@
 #include <memory>
 #include <noma/ocl/helper.hpp>
 
+#include "noma/num/buffer_pool.hpp"
 #include "noma/num/rk_stepper.hpp"
+#include "noma/num/stepper_cost.hpp"
 #include "noma/num/stepper_type.hpp"
 #include "noma/num/taylor_stepper.hpp"
 
@@ -22,6 +24,10 @@ class polymorphic_stepper {
 public:
 	// public stepper interface
 	virtual real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out) = 0;
+	// in-place step, d_mem holds y_(n+1) afterwards, and may refer to another buffer than before, see the steppers
+	virtual real_t step(real_t time, real_t step_size, cl::Buffer& d_mem) = 0;
+	// cost and memory model of step(), see stepper_cost.hpp
+	virtual stepper_cost cost(size_t buffer_size_byte) const = 0;
 
 	// public kernel wrapper interface (expected super class of stepper)
 	virtual ocl::helper& ocl_helper() = 0;
@@ -38,18 +44,18 @@ template<typename STEPPER>
 class polymorphic_stepper_adapter : private STEPPER, public polymorphic_stepper
 {
 public:
-	polymorphic_stepper_adapter(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, typename STEPPER::ode_type& ode)
-		: STEPPER(ocl, source_header, ocl_compile_options, range, ode)
+	polymorphic_stepper_adapter(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, typename STEPPER::ode_type& ode, buffer_pool* pool = nullptr)
+		: STEPPER(ocl, source_header, ocl_compile_options, range, ode, pool)
 	{ }
 
 	polymorphic_stepper_adapter(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
-	                            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, typename STEPPER::ode_type& ode)
-		: STEPPER(ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode)
+	                            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, typename STEPPER::ode_type& ode, buffer_pool* pool = nullptr)
+		: STEPPER(ocl, kernel_source, kernel_name, source_header, ocl_compile_options, range, ode, pool)
 	{ }
 
 	polymorphic_stepper_adapter(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
-	                            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, typename STEPPER::ode_type& ode)
-		: STEPPER(ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode)
+	                            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, typename STEPPER::ode_type& ode, buffer_pool* pool = nullptr)
+		: STEPPER(ocl, file_name, kernel_name, source_header, ocl_compile_options, range, ode, pool)
 	{ }
 
 	polymorphic_stepper_adapter()
@@ -62,6 +68,16 @@ public:
 		return STEPPER::step(time, step_size, d_mem_in, d_mem_out);
 	}
 
+	virtual real_t step(real_t time, real_t step_size, cl::Buffer& d_mem)
+	{
+		return STEPPER::step(time, step_size, d_mem);
+	}
+
+	virtual stepper_cost cost(size_t buffer_size_byte) const
+	{
+		return STEPPER::cost(buffer_size_byte);
+	}
+
 	virtual ocl::helper& ocl_helper()
 	{
 		return STEPPER::ocl_helper();
@@ -96,38 +112,11 @@ std::unique_ptr<polymorphic_stepper> make_unique_polymorphic_stepper(const stepp
 {
 	// NOTE: this switch is the ugly but necessary way to get from the runtime stepper_type value, to an actual compile-time stepper type
 	switch (stepper_type) {
-		case stepper_type_t::rk_euler:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::rk_euler>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::rk_midpoint:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::rk_midpoint>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::rk_rk4:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::rk_rk4>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::rk_fehlberg54:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::rk_fehlberg54>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::rk_dopri54:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::rk_dopri54>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::rk_cashkarp54:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::rk_cashkarp54>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::rk_bosha32:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::rk_bosha32>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_1:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_1>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_2:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_2>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_3:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_3>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_4:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_4>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_5:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_5>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_6:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_6>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_7:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_7>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_8:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_8>::type>(std::forward<Args>(args)...));
-		case stepper_type_t::taylor_9:
-			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::taylor_9>::type>(std::forward<Args>(args)...));
+#define NOMA_NUM_STEPPER_TYPE_CASE(name, ...) \
+		case stepper_type_t::name: \
+			return std::unique_ptr<polymorphic_stepper>(new polymorphic_stepper_adapter<typename stepper_type_to_type<ODE, stepper_type_t::name>::type>(std::forward<Args>(args)...));
+		NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_CASE)
+#undef NOMA_NUM_STEPPER_TYPE_CASE
 		default:
 			throw std::runtime_error("make_unique_polymorphic_stepper(): error: called with unhandled stepper_type.");
 	}
@@ -0,0 +1,212 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_propagator_stepper_hpp
+#define noma_num_propagator_stepper_hpp
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/matrix_exp.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/state_kernels.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * This class template performs integration steps for linear, time-invariant
+ * ODEs, dy/dt = L * y, by applying the exact step propagator exp(h * L).
+ *
+ * WARNING: This is mathematically correct iff ODE_T is complex-linear in the
+ * state and does not depend on time, e.g. the von Neumann equation with a
+ * constant Hamiltonian.
+ *
+ * On the first step, L is assembled per matrix as explicit NUM_STATES^2 x
+ * NUM_STATES^2 complex matrix by applying ODE_T to all unit basis states, i.e.
+ * NUM_STATES^2 evaluations of ODE_T. exp(h * L) is computed on the host (see
+ * matrix_exp.hpp), cached on the device, and recomputed whenever step_size
+ * changes. Each step is a single batched matrix-vector product.
+ *
+ * The cached propagator needs NUM_STATES^2 times the memory of a state,
+ * hence this stepper is intended for small NUM_STATES.
+ */
+template<typename ODE_T>
+class propagator_stepper : public ocl::kernel_wrapper
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::separated;
+
+	// NOTE: if pool is set, the temporary buffers for assembling L are taken from it (see buffer_pool.hpp)
+	propagator_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	// to fullfill the same 'concept' as rk_stepper.hpp, the passed kernel is ignored
+	propagator_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+	                   const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: propagator_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+	propagator_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+	                   const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: propagator_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards, through a spare buffer (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	// cost and memory model of step(), see stepper_cost.hpp
+	// NOTE: the one-time assembly of L, and the propagator updates on step size changes are not included
+	stepper_cost cost(size_t buffer_size_byte) const;
+
+private:
+	void assemble_generator(real_t time);
+	void update_propagator(real_t step_size);
+
+	ODE_T& ode_;
+	buffer_pool* pool_;
+
+	state_kernels state_;
+
+	const size_t num_matrices_;
+	const size_t state_dim_; // NUM_STATES^2
+
+	// host-side generator L, one state_dim_ x state_dim_ matrix per state
+	std::vector<std::vector<complex_t>> generator_;
+
+	// OpenCL buffers
+	spare_buffer spare_; // y_(n+1) of the in-place step(), copied back into d_mem
+	cl::Buffer propagator_buffer_;
+	real_t propagator_step_size_ = 0.0; // step size of the cached propagator, 0.0 means none
+
+	static const std::string embedded_ocl_source_;
+};
+
+template<typename ODE_T>
+const std::string propagator_stepper<ODE_T>::embedded_ocl_source_ {
+#include "propagator.cl.hpp"  // NOTE: generated by CMake
+};
+
+template<typename ODE_T>
+propagator_stepper<ODE_T>::propagator_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, embedded_ocl_source_, "propagator_apply", source_header, ocl_compile_options, range), ode_(ode), pool_(pool),
+	  state_(ocl, source_header, ocl_compile_options, range), num_matrices_(state_.num_matrices()), state_dim_(state_.state_dim())
+{
+	assert(ode_.buffer_size_byte() == num_matrices_ * state_dim_ * sizeof(complex_t));
+
+	propagator_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, num_matrices_ * state_dim_ * state_dim_ * sizeof(complex_t), nullptr);
+}
+
+template<typename ODE_T>
+void propagator_stepper<ODE_T>::ode_compile_options(std::ostream&)
+{
+	// NOTE: plain ODE evaluation, nothing to define
+}
+
+template<typename ODE_T>
+stepper_cost propagator_stepper<ODE_T>::cost(size_t buffer_size_byte) const
+{
+	// the propagator holds a state_dim_ x state_dim_ matrix per state, i.e. state_dim_ times the state size
+	const size_t propagator_byte = state_dim_ * buffer_size_byte;
+
+	stepper_cost c;
+	c.weighted_add_launches = 1; // propagator_apply
+	c.read_byte = buffer_size_byte + propagator_byte;
+	c.written_byte = buffer_size_byte;
+	c.temporary_buffers = 1;
+	c.temporary_byte = propagator_byte;
+	c.spare_byte = buffer_size_byte;
+	return c;
+}
+
+template<typename ODE_T>
+void propagator_stepper<ODE_T>::assemble_generator(real_t time)
+{
+	if (pool_)
+		pool_->begin_group();
+
+	cl::Buffer basis_buffer = create_temporary_buffer(ocl_, pool_, ode_.buffer_size_byte());
+	cl::Buffer column_buffer = create_temporary_buffer(ocl_, pool_, ode_.buffer_size_byte());
+
+	generator_.assign(num_matrices_, std::vector<complex_t>(state_dim_ * state_dim_));
+	std::vector<complex_t> column(num_matrices_ * state_dim_);
+
+	for (size_t c = 0; c < state_dim_; ++c) {
+		// column c of L is L applied to the c-th unit basis state
+		state_.set_basis(basis_buffer, c);
+		// NOTE: time step of 1.0, and accumulation coefficient 1.0 as in taylor_stepper, L is assumed constant
+		ode_.solve(time, 1.0, basis_buffer, column_buffer, 1.0);
+
+		cl_int err = ocl_.command_queue().enqueueReadBuffer(column_buffer, CL_TRUE, 0, column.size() * sizeof(complex_t), column.data());
+		ocl::error_handler(err, "clEnqueueReadBuffer(column_buffer)");
+
+		for (size_t m = 0; m < num_matrices_; ++m)
+			for (size_t r = 0; r < state_dim_; ++r)
+				generator_[m][r * state_dim_ + c] = column[m * state_dim_ + r];
+	}
+}
+
+template<typename ODE_T>
+void propagator_stepper<ODE_T>::update_propagator(real_t step_size)
+{
+	std::vector<complex_t> propagator(num_matrices_ * state_dim_ * state_dim_);
+	std::vector<complex_t> scaled(state_dim_ * state_dim_);
+
+	for (size_t m = 0; m < num_matrices_; ++m) {
+		for (size_t i = 0; i < scaled.size(); ++i)
+			scaled[i] = step_size * generator_[m][i];
+		const std::vector<complex_t> p = matrix_exp(scaled, state_dim_);
+		std::copy(p.begin(), p.end(), propagator.begin() + m * state_dim_ * state_dim_);
+	}
+
+	cl_int err = ocl_.command_queue().enqueueWriteBuffer(propagator_buffer_, CL_TRUE, 0, propagator.size() * sizeof(complex_t), propagator.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(propagator_buffer_)");
+
+	propagator_step_size_ = step_size;
+}
+
+template<typename ODE_T>
+real_t propagator_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	if (generator_.empty())
+		assemble_generator(time);
+
+	// rebuild cache if step_size changed
+	if (step_size != propagator_step_size_)
+		update_propagator(step_size);
+
+	// d_mem_out = exp(h * L) * d_mem_in
+	cl_int err = 0;
+	err = kernel_.setArg(0, d_mem_out);
+	ocl::error_handler(err, "clSetKernelArg(0)");
+	err = kernel_.setArg(1, propagator_buffer_);
+	ocl::error_handler(err, "clSetKernelArg(1)");
+	err = kernel_.setArg(2, d_mem_in);
+	ocl::error_handler(err, "clSetKernelArg(2)");
+	run_kernel();
+
+	return 0.0;
+}
+
+template<typename ODE_T>
+real_t propagator_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_propagator_stepper_hpp
@@ -31,6 +31,17 @@ const std::map<rk_method_t, std::string> rk_method_names {
 	{ rk_method_t::bosha32, "bosha32" }
 };
 
+// nominal order of the solution computed with the b coefficients of the method's Butcher tableau
+const std::map<rk_method_t, size_t> rk_method_orders {
+	{ rk_method_t::euler, 1 },
+	{ rk_method_t::midpoint, 2 },
+	{ rk_method_t::rk4, 4 },
+	{ rk_method_t::fehlberg54, 5 },
+	{ rk_method_t::dopri54, 5 },
+	{ rk_method_t::cashkarp54, 5 },
+	{ rk_method_t::bosha32, 3 }
+};
+
 std::ostream& operator<<(std::ostream& out, const rk_method_t& m);
 std::istream& operator>>(std::istream& in, rk_method_t& m);
 
@@ -5,12 +5,22 @@
 #ifndef noma_num_rk_stepper_hpp
 #define noma_num_rk_stepper_hpp
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
 
 #include <noma/ocl/helper.hpp>
 #include <noma/ocl/kernel_wrapper.hpp>
 
+#include "noma/num/buffer_pool.hpp"
 #include "noma/num/butcher_tableau.hpp"
+#include "noma/num/k_storage.hpp"
+#include "noma/num/stage_input.hpp"
+#include "noma/num/status_monitor.hpp"
+#include "noma/num/stepper_cost.hpp"
 
 namespace noma {
 namespace num {
@@ -25,36 +35,88 @@ namespace num {
  * - subdiagonal: Assumes a subdiagonal structure for the butcher tableau
  *   (classic RK4). Needs only two temporary buffers and no weighted add
  *   kernel calls at all.
+ * - fused: As integrated, but the ODE kernel forms each stage input from y_n
+ *   and the k's while loading it, i.e. no weighted add kernel calls and no
+ *   additional buffer, for any tableau. Requires the extended ODE interface
+ *   (see stage_input.hpp), falls back to integrated otherwise.
  */
 enum class accumulate_method {
 	separated,
 	integrated,
-	subdiagonal // implies integrated
+	subdiagonal, // implies integrated
+	fused // implies integrated
 };
 
+// writes the OpenCL defines an ODE kernel needs for acc_method, i.e. NOMA_NUM_ODE_ACCUMULATE, NOMA_NUM_SUBDIAGONAL, and NOMA_NUM_ODE_FUSED
+void accumulate_compile_options(accumulate_method acc_method, std::ostream& os);
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD = accumulate_method::separated>
+// source_header followed by the defines of a stepper's own weighted add kernel for storage and track_status (NOMA_NUM_STATUS), which replace those of a shared header
+// NOTE: the header may be shared with ODE kernels and other steppers, i.e. it may lack these defines, or have different ones
+std::string weighted_add_source_header(const std::string& source_header, k_storage storage, bool track_status = false);
+
+// NOTE: K_STORAGE sets the format of the k buffers, see k_storage.hpp
+// NOTE: TRACK_STATUS enables NaN/Inf and blow-up detection, see status_monitor.hpp and monitor()
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD = accumulate_method::separated, k_storage K_STORAGE = k_storage::full, bool TRACK_STATUS = false>
 class rk_stepper : public ocl::kernel_wrapper
 {
+	// NOTE: with subdiagonal accumulation, the k buffers hold stage inputs, i.e. states
+	static_assert(ACC_METHOD != accumulate_method::subdiagonal || K_STORAGE == k_storage::full, "rk_stepper: compressed k storage requires accumulate_method::separated, integrated, or fused");
+	static_assert(ACC_METHOD != accumulate_method::subdiagonal || is_subdiagonal(RKM), "rk_stepper: accumulate_method::subdiagonal requires a subdiagonal Butcher tableau, see is_subdiagonal()");
+
 public:
 	using ode_type = ODE_T;
 
 	static constexpr accumulate_method acc_method = ACC_METHOD;
+	static constexpr k_storage k_storage_format = K_STORAGE;
+	static constexpr bool track_status = TRACK_STATUS;
 
-	rk_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode);
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	rk_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
 	rk_stepper(ocl::helper& ocl, const std::string& rk_weighted_add_kernel_source, const std::string& rk_weighted_add_kernel_name,
-	           const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode);
+	           const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
 	rk_stepper(ocl::helper& ocl, const boost::filesystem::path& rk_weighted_add_file_name, const std::string& rk_weighted_add_kernel_name,
-	           const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode);
+	           const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
 
+	// NOTE: d_mem_in and d_mem_out may be the same buffer for accumulate_method::separated
 	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
 
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards
+	// NOTE: separated works in place, the other methods write into a spare buffer, and copy it back into d_mem (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
 	// generate OpenCL compile options
 	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which happens before stepper construction
 
+	// cost and memory model of step(), see stepper_cost.hpp
+	static stepper_cost cost(size_t buffer_size_byte);
+
+	// nominal order of the method
+	static size_t order() { return rk_method_orders.at(RKM); }
+
+	/**
+	 * NaN/Inf and blow-up detection of TRACK_STATUS, configure it before the
+	 * first step, step() throws status_error, see status_monitor.hpp
+	 *
+	 * separated: the status is computed by rk_weighted_add, i.e. fused for all
+	 *            stage inputs and the result
+	 * integrated: fused for the stage inputs, the result, which is
+	 *             accumulated by the ODE, is scanned once per poll interval
+	 * subdiagonal, fused: no weighted adds, the result is scanned once per
+	 *                    poll interval
+	 *
+	 * NOTE: the in-place step() restores a rolled back state into d_mem
+	 */
+	status_monitor& monitor();
+
 private:
-	void initialise();
+	// accumulate_method::fused with an ODE that supports it, integrated accumulation otherwise
+	static constexpr bool fused_stage_input = (ACC_METHOD == accumulate_method::fused) && has_fused_solve<ODE_T>::value;
+	static constexpr bool integrated_accumulation = (ACC_METHOD == accumulate_method::integrated) || (ACC_METHOD == accumulate_method::fused && !fused_stage_input);
+
+	void initialise(buffer_pool* pool);
 	void set_dynamic_args(real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out, const std::vector<double>& coeffs);
+	void step_fused(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out, std::true_type);
+	void step_fused(real_t, real_t, cl::Buffer&, cl::Buffer&, std::false_type) { }
 
 	// method specification
 	const butcher_tableau b_tab;
@@ -63,79 +125,165 @@ private:
 
 	// OpenCL buffers
 	std::vector<cl::Buffer> k_buffers;
-	cl::Buffer tmp_buffer; // for integrated accumulation
+	cl::Buffer tmp_buffer; // for integrated accumulation, not needed by fused_stage_input
+	spare_buffer spare; // stage inputs of in-place separated steps, or y_(n+1) of the in-place step() otherwise, copied back into d_mem
+
+	std::unique_ptr<status_monitor> monitor_; // only for TRACK_STATUS
 
 	// constants derived from the OpenCL implementation
 	// NOTE: must be consistent with number of buffer arguments in rk_weighted_add OpenCL kernel
 	const size_t max_buffers_in_kernel = 7;
 	const size_t first_buffer_kernel_arg = 4;
+	const size_t status_kernel_arg = first_buffer_kernel_arg + 2 * max_buffers_in_kernel; // with TRACK_STATUS, followed by the local memory argument
 
 	static const std::string embedded_ocl_source_;
 	static const std::string embedded_ocl_kernel_name_;
 };
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-const std::string rk_stepper<ODE_T, RKM, ACC_METHOD>::embedded_ocl_source_ {
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+const std::string rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::embedded_ocl_source_ {
 #include "rk_weighted_add.cl.hpp"  // NOTE: generated by CMake
 };
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-const std::string rk_stepper<ODE_T, RKM, ACC_METHOD>::embedded_ocl_kernel_name_ { "rk_weighted_add" };
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+const std::string rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::embedded_ocl_kernel_name_ { "rk_weighted_add" };
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-rk_stepper<ODE_T, RKM, ACC_METHOD>::rk_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode)
-	: ocl::kernel_wrapper(ocl, embedded_ocl_source_, embedded_ocl_kernel_name_, source_header, ocl_compile_options, range), b_tab(get_butcher_tableau(RKM)), ode(ode)
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::rk_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, embedded_ocl_source_, embedded_ocl_kernel_name_, weighted_add_source_header(source_header, K_STORAGE, TRACK_STATUS), ocl_compile_options, range), b_tab(get_butcher_tableau(RKM)), ode(ode)
 {
-	initialise();
+	if (TRACK_STATUS)
+		monitor_.reset(new status_monitor(ocl, source_header, ocl_compile_options, range, ode.buffer_size_byte()));
+	initialise(pool);
 }
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-rk_stepper<ODE_T, RKM, ACC_METHOD>::rk_stepper(ocl::helper& ocl, const std::string& rk_weighted_add_kernel_source, const std::string& rk_weighted_add_kernel_name,
-                                               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode)
-	: ocl::kernel_wrapper(ocl, rk_weighted_add_kernel_source, rk_weighted_add_kernel_name, source_header, ocl_compile_options, range), b_tab(get_butcher_tableau(RKM)), ode(ode)
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::rk_stepper(ocl::helper& ocl, const std::string& rk_weighted_add_kernel_source, const std::string& rk_weighted_add_kernel_name,
+                                               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, rk_weighted_add_kernel_source, rk_weighted_add_kernel_name, weighted_add_source_header(source_header, K_STORAGE, TRACK_STATUS), ocl_compile_options, range), b_tab(get_butcher_tableau(RKM)), ode(ode)
 {
-	initialise();
+	if (TRACK_STATUS)
+		monitor_.reset(new status_monitor(ocl, source_header, ocl_compile_options, range, ode.buffer_size_byte()));
+	initialise(pool);
 }
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-rk_stepper<ODE_T, RKM, ACC_METHOD>::rk_stepper(ocl::helper& ocl, const boost::filesystem::path& rk_weighted_add_file_name, const std::string& rk_weighted_add_kernel_name,
-                                               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode)
-	: ocl::kernel_wrapper(ocl, rk_weighted_add_file_name, rk_weighted_add_kernel_name, source_header, ocl_compile_options, range), b_tab(get_butcher_tableau(RKM)), ode(ode)
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::rk_stepper(ocl::helper& ocl, const boost::filesystem::path& rk_weighted_add_file_name, const std::string& rk_weighted_add_kernel_name,
+                                               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, rk_weighted_add_file_name, rk_weighted_add_kernel_name, weighted_add_source_header(source_header, K_STORAGE, TRACK_STATUS), ocl_compile_options, range), b_tab(get_butcher_tableau(RKM)), ode(ode)
 {
-	initialise();
+	if (TRACK_STATUS)
+		monitor_.reset(new status_monitor(ocl, source_header, ocl_compile_options, range, ode.buffer_size_byte()));
+	initialise(pool);
 }
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-void rk_stepper<ODE_T, RKM, ACC_METHOD>::initialise()
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+void rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::initialise(buffer_pool* pool)
 {
+	// NOTE: the static_assert above relies on is_subdiagonal(RKM) matching the tableau
+	assert(ACC_METHOD != accumulate_method::subdiagonal || is_subdiagonal(b_tab));
+
+	if (pool)
+		pool->begin_group();
+
 	// create buffers for k_1 to k_n
 	size_t num_buffs = b_tab.a.size(); // default: one buffer per row in butcher tableau's a matrix
 
 	if (ACC_METHOD == accumulate_method::subdiagonal)
 		num_buffs = 2; // only two buffers needed if butcher tableau has subdiagonal structure
 
+	// NOTE: subdiagonal always uses full storage, see static_assert above
+	const size_t k_buffer_size_byte = ode.buffer_size_byte() / sizeof(real_t) * k_storage_element_size_byte(K_STORAGE);
 	for (size_t i = 0; i < num_buffs; ++i)
-		k_buffers.push_back(ocl_.create_buffer(CL_MEM_READ_WRITE, ode.buffer_size_byte(), nullptr));
+		k_buffers.push_back(create_temporary_buffer(ocl_, pool, k_buffer_size_byte));
 
 	// one additional buffer for integrated accumulation, since the weighted add for the next ode evaluation and the final result are needed at the same time
-	if (ACC_METHOD == accumulate_method::integrated)
-		tmp_buffer = ocl_.create_buffer(CL_MEM_READ_WRITE, ode.buffer_size_byte(), nullptr);
+	if (integrated_accumulation)
+		tmp_buffer = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
 };
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-void rk_stepper<ODE_T, RKM, ACC_METHOD>::ode_compile_options(std::ostream& os)
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+void rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::ode_compile_options(std::ostream& os)
 {
-	if (acc_method == accumulate_method::integrated ||
-	    acc_method == accumulate_method::subdiagonal) {
-		os << "#define NOMA_NUM_ODE_ACCUMULATE" << "\n";
-	}
+	accumulate_compile_options(acc_method, os);
+	k_storage_compile_options(K_STORAGE, os);
+	if (TRACK_STATUS)
+		status_compile_options(os);
+}
+
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+status_monitor& rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::monitor()
+{
+	if (!monitor_)
+		throw std::runtime_error("rk_stepper::monitor(): error: status tracking requires TRACK_STATUS.");
+	return *monitor_;
+}
+
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+stepper_cost rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::cost(size_t buffer_size_byte)
+{
+	const butcher_tableau b_tab = get_butcher_tableau(RKM);
+	const size_t stages = b_tab.a.size();
+	const size_t k_buffer_size_byte = buffer_size_byte / sizeof(real_t) * k_storage_element_size_byte(K_STORAGE);
+
+	// rk_weighted_add reads y_n and the k's with non-zero coefficients, and writes one state
+	auto weighted_add = [&](stepper_cost& c, const std::vector<double>& coeffs) {
+		const size_t ks = std::count_if(coeffs.begin(), coeffs.end(), [](double coeff) { return coeff != 0.0; });
+		++c.weighted_add_launches;
+		c.read_byte += buffer_size_byte + ks * k_buffer_size_byte;
+		c.written_byte += buffer_size_byte;
+	};
 
-	if (acc_method == accumulate_method::subdiagonal) {
-		os<< "#define NOMA_NUM_SUBDIAGONAL" << "\n";
+	stepper_cost c;
+	c.ode_evaluations = stages;
+
+	if (ACC_METHOD == accumulate_method::separated) {
+		// every ODE evaluation reads its stage input and writes a k
+		c.read_byte = stages * buffer_size_byte;
+		c.written_byte = stages * k_buffer_size_byte;
+		for (size_t i = 1; i < stages; ++i)
+			weighted_add(c, b_tab.a[i]);
+		weighted_add(c, b_tab.b);
+
+		c.temporary_buffers = stages;
+		c.temporary_byte = stages * k_buffer_size_byte;
+		c.spare_byte = (stages > 1) ? buffer_size_byte : 0; // stage inputs of in-place steps
+	} else if (integrated_accumulation) {
+		// as above, plus accumulation into d_mem_out, which is initialised from the input by the first evaluation
+		c.read_byte = stages * buffer_size_byte + (stages - 1) * buffer_size_byte;
+		c.written_byte = stages * k_buffer_size_byte + stages * buffer_size_byte;
+		for (size_t i = 1; i < stages; ++i)
+			weighted_add(c, b_tab.a[i]);
+
+		c.temporary_buffers = stages + 1;
+		c.temporary_byte = stages * k_buffer_size_byte + buffer_size_byte;
+		c.spare_byte = buffer_size_byte;
+	} else if (ACC_METHOD == accumulate_method::subdiagonal) {
+		// every ODE evaluation reads its input and writes the next stage input (or the last k), plus the accumulation,
+		// all but the first and last evaluation also read y_n for the next stage input
+		c.read_byte = stages * buffer_size_byte + (stages > 2 ? stages - 2 : 0) * buffer_size_byte + (stages - 1) * buffer_size_byte;
+		c.written_byte = 2 * stages * buffer_size_byte;
+
+		c.temporary_buffers = 2;
+		c.temporary_byte = 2 * buffer_size_byte;
+		c.spare_byte = buffer_size_byte;
+	} else if (fused_stage_input) {
+		// every ODE evaluation reads y_n and the k's of its stage input once per element (the kernel keeps the formed input
+		// in private memory, see stage_input.cl), writes a k, and accumulates into d_mem_out
+		c.read_byte = stages * buffer_size_byte + (stages - 1) * buffer_size_byte;
+		c.written_byte = stages * k_buffer_size_byte + stages * buffer_size_byte;
+		for (size_t i = 1; i < stages; ++i)
+			c.read_byte += std::count_if(b_tab.a[i].begin(), b_tab.a[i].end(), [](double coeff) { return coeff != 0.0; }) * k_buffer_size_byte;
+
+		c.temporary_buffers = stages;
+		c.temporary_byte = stages * k_buffer_size_byte;
+		c.spare_byte = buffer_size_byte;
 	}
+
+	return c;
 }
 
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-void rk_stepper<ODE_T, RKM, ACC_METHOD>::set_dynamic_args(real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out, const std::vector<double>& coeffs)
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+void rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::set_dynamic_args(real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out, const std::vector<double>& coeffs)
 {
 	cl_int err = 0;
 	err = kernel_.setArg(0, static_cast<int>(coeffs.size()));
@@ -169,13 +317,23 @@ void rk_stepper<ODE_T, RKM, ACC_METHOD>::set_dynamic_args(real_t step_size, cl::
 		err = kernel_.setArg(2*i + offset + 1, k_buffers[0]);
 		ocl::error_handler(err, "kernel_.setArg(2*i + offset + 1, k_buffers[0])");
 	}
+
+	if (TRACK_STATUS) {
+		err = kernel_.setArg(status_kernel_arg, monitor_->status_buffer());
+		ocl::error_handler(err, "kernel_.setArg(status_kernel_arg, monitor_->status_buffer())");
+		err = kernel_.setArg(status_kernel_arg + 1, monitor_->status_local());
+		ocl::error_handler(err, "kernel_.setArg(status_kernel_arg + 1, monitor_->status_local())");
+	}
 }
 
 /* performs a single integration step */
-template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD>
-real_t rk_stepper<ODE_T, RKM, ACC_METHOD>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+real_t rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
 {
 	if (ACC_METHOD == accumulate_method::separated) {
+		// the stage inputs go into d_mem_out, unless it is d_mem_in, which is still needed
+		cl::Buffer& stage_buffer = (d_mem_in() == d_mem_out() && b_tab.a.size() > 1) ? spare.get(ocl_, ode.buffer_size_byte()) : d_mem_out;
+
 		// compute k1
 		// h = step_size
 		// k1 = f(t_n, y_n), t_n not relevant, implicit via y_n = y(t_n)
@@ -186,18 +344,21 @@ real_t rk_stepper<ODE_T, RKM, ACC_METHOD>::step(real_t time, real_t step_size, c
 		for (size_t i = 1; i < b_tab.a.size(); ++i) {
 			// weighted sum:
 			// reads from d_mem_in, writes_to d_mem_out
-			set_dynamic_args(step_size, d_mem_in, d_mem_out, b_tab.a[i]); // write sum into tmp
+			set_dynamic_args(step_size, d_mem_in, stage_buffer, b_tab.a[i]); // write sum into tmp
 			run_kernel();
 
 			// reads from d_mem_out, where the weighted sum of the ks is, and writes the next k_n
-			ode.solve(time, step_size * b_tab.c[i], d_mem_out, k_buffers[i], b_tab.b[0] * step_size);
+			ode.solve(time, step_size * b_tab.c[i], stage_buffer, k_buffers[i], b_tab.b[0] * step_size);
 		}
 
 		// compute results
 		set_dynamic_args(step_size, d_mem_in, d_mem_out, b_tab.b); // TODO(adaptive time step): loop over b, or hardcode for 2 possible results
 		// y_n+1 = y_n + 1/6 k1 + 1/3 k2 + 1/3 k3 + 1/6 k4
+		// NOTE: element-wise, i.e. also correct in place
 		run_kernel(); // call wrapped weighted add kernel
-	} else if (ACC_METHOD == accumulate_method::integrated) {
+	} else if (d_mem_in() == d_mem_out()) {
+		throw std::runtime_error("rk_stepper::step(): error: d_mem_in and d_mem_out must differ for integrated and subdiagonal accumulation, use the in-place step()");
+	} else if (integrated_accumulation) {
 		// compute k1
 		// h = step_size
 		// k1 = f(t_n, y_n), t_n not relevant, implicit via y_n = y(t_n)
@@ -239,6 +400,8 @@ real_t rk_stepper<ODE_T, RKM, ACC_METHOD>::step(real_t time, real_t step_size, c
 			ode.solve(time, b_tab.c[i] * step_size, get_in_buf(), get_out_buf(), b_tab.a[i+1][i] * step_size, d_mem_out, b_tab.b[i] * step_size, false);
 		}
 		ode.solve(time, b_tab.c[i] * step_size,  get_in_buf(), get_out_buf(), d_mem_out, b_tab.b[i] * step_size, false);
+	} else if (fused_stage_input) {
+		step_fused(time, step_size, d_mem_in, d_mem_out, std::integral_constant<bool, fused_stage_input>());
 	}
 
 	// compute comparison results if b_cmp is set
@@ -249,10 +412,40 @@ real_t rk_stepper<ODE_T, RKM, ACC_METHOD>::step(real_t time, real_t step_size, c
 //		run_kernel(); // call wrapped weighted add kernel
 //	}
 
+	if (TRACK_STATUS)
+		monitor_->after_step(time + step_size, d_mem_out, ACC_METHOD == accumulate_method::separated);
+
 	// TODO(adaptive time step): return some error metric, or maybe current step_size, depending on where the error norm is evaluated and the time step is set
 	return 0.0;
 }
 
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+void rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::step_fused(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out, std::true_type)
+{
+	// every ODE evaluation reads y_n from d_mem_in, forms its stage input from y_n and the k's of the previous stages on the fly,
+	// writes its k, and accumulates weighted (b_tab.b[i]) into d_mem_out, which is initialised from y_n by the first one
+	for (size_t i = 0; i < b_tab.a.size(); ++i)
+		ode.solve(time, b_tab.c[i] * step_size, d_mem_in, step_size, b_tab.a[i], k_buffers, k_buffers[i], d_mem_out, b_tab.b[i] * step_size, i == 0);
+}
+
+template<typename ODE_T, rk_method_t RKM, accumulate_method ACC_METHOD, k_storage K_STORAGE, bool TRACK_STATUS>
+real_t rk_stepper<ODE_T, RKM, ACC_METHOD, K_STORAGE, TRACK_STATUS>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	if (ACC_METHOD == accumulate_method::separated)
+		return step(time, step_size, d_mem, d_mem);
+
+	// the ODE reads y_n while accumulating y_(n+1), so write into the spare buffer and copy back
+	real_t result = 0.0;
+	try {
+		result = step(time, step_size, d_mem, spare.get(ocl_, ode.buffer_size_byte()));
+	} catch (const status_error&) {
+		spare.copy_to(ocl_, d_mem); // a rollback is restored into the spare buffer
+		throw;
+	}
+	spare.copy_to(ocl_, d_mem);
+	return result;
+}
+
 } // namespace num
 } // namespace noma
 
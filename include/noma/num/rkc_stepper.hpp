@@ -0,0 +1,308 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_rkc_stepper_hpp
+#define noma_num_rkc_stepper_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/spectral_radius.hpp"
+#include "noma/num/state_kernels.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Coefficients of the damped, second order Runge-Kutta-Chebyshev method with
+ * s stages, see rkc_stepper, indexed by the stage j = 0 to s.
+ *
+ * B.P. Sommeijer, L.F. Shampine, J.G. Verwer, RKC: An explicit solver for
+ * parabolic PDEs, J. Comput. Appl. Math. 88 (1998)
+ */
+struct rkc_coefficients
+{
+	rkc_coefficients() = default;
+	rkc_coefficients(size_t stages, real_t damping);
+
+	size_t stages = 0;
+	std::vector<real_t> mu, nu, mu_tilde, gamma_tilde; // for j >= 1, mu and nu are zero for j = 1
+	std::vector<real_t> c; // stage j is at time t_n + c_j * h, c_s = 1
+};
+
+// default damping of rkc_stepper, as in RKC
+const real_t rkc_default_damping = 2.0 / 13.0;
+
+// length beta of the real stability interval [-beta, 0] of h * lambda for s stages, approximately (2 - 4 / 3 * damping) * s^2
+real_t rkc_stability_bound(size_t stages, real_t damping);
+
+// number of stages, at least two, that is stable for step_size * spectral_radius, i.e. 1 + sqrt(1 + 1.54 * h * rho) for the default damping, as in RKC
+size_t rkc_stages(real_t step_size, real_t spectral_radius, real_t damping = rkc_default_damping);
+
+/**
+ * This class template performs a single step of a stabilised explicit
+ * Runge-Kutta-Chebyshev (RKC) method of second order, for mildly stiff ODEs,
+ * like diffusion-dominated problems, whose Jacobian has a spectrum close to
+ * the negative real axis.
+ *
+ * The s stages are a three-term recurrence of shifted Chebyshev
+ * polynomials:
+ *
+ * Y_0 = y_n
+ * Y_1 = Y_0 + mu~_1 * h * F_0
+ * Y_j = (1 - mu_j - nu_j) * Y_0 + mu_j * Y_(j-1) + nu_j * Y_(j-2) + mu~_j * h * F_(j-1) + gamma~_j * h * F_0
+ * y_(n+1) = Y_s
+ *
+ * with F_j = f(t_n + c_j * h, Y_j), see rkc_coefficients. The stability
+ * interval grows quadratically with s, while the cost grows linearly, and s
+ * is chosen per step from h * rho, where rho bounds the spectral radius of
+ * the Jacobian. Independent of s, four temporary state buffers are needed.
+ *
+ * rho can be set by the user, otherwise it is estimated by power iteration
+ * on the difference quotient (f(y_n + delta * v) - f(y_n)) / delta, starting
+ * from f(y_n), on the first step, and again every estimate_interval() steps.
+ *
+ * NOTE: the method is stable for real negative eigenvalues with |lambda| <= rho,
+ *       it is not suited for oscillatory problems, e.g. with purely imaginary
+ *       spectrum, see chebyshev_stepper for those
+ * NOTE: ROCK2, with its precomputed orthogonal polynomials, has a larger
+ *       stability interval of about 0.81 * s^2, RKC needs no tables
+ */
+template<typename ODE_T>
+class rkc_stepper : public ocl::kernel_wrapper
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::separated;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	rkc_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	// to fullfill the same 'concept' as rk_stepper.hpp, the passed kernel is ignored
+	rkc_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
+	            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: rkc_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+	rkc_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+	            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: rkc_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+
+	// NOTE: d_mem_in and d_mem_out must differ
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards, through a spare buffer (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os) { accumulate_compile_options(acc_method, os); } // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	// upper bound for the spectral radius of the Jacobian, a value <= 0.0 means estimate on the next step, and every estimate_interval() steps
+	void spectral_radius(real_t rho) { spectral_radius_ = rho; estimate_ = (rho <= 0.0); }
+	real_t spectral_radius() const { return spectral_radius_; }
+
+	// steps between estimates of the spectral radius, for ODEs with a varying Jacobian, 0 means only on the first step
+	void estimate_interval(size_t steps) { estimate_interval_ = steps; }
+	size_t estimate_interval() const { return estimate_interval_; }
+
+	// damping parameter epsilon, larger values shrink the stability interval, but damp stiff components stronger
+	void damping(real_t epsilon) { damping_ = epsilon; coeffs_ = rkc_coefficients(); }
+	real_t damping() const { return damping_; }
+
+	// number of stages, i.e. ODE evaluations per step, for the last step size
+	size_t stages() const { return coeffs_.stages; }
+
+	static size_t order() { return 2; }
+
+	// cost and memory model of step() for the current stages()
+	// NOTE: the spectral radius estimation is not included
+	stepper_cost cost(size_t buffer_size_byte) const;
+
+private:
+	void estimate_spectral_radius(real_t time, cl::Buffer& y_n, cl::Buffer& scratch);
+
+	// out = c0 * y_0 + c1 * y_jm1 + c2 * y_jm2 + c3 * f_jm1 + c4 * f_0, see cl/rkc.cl
+	void stage(cl::Buffer& out, real_t c0, cl::Buffer& y_0, real_t c1, cl::Buffer& y_jm1, real_t c2, cl::Buffer& y_jm2, real_t c3, cl::Buffer& f_jm1, real_t c4, cl::Buffer& f_0);
+
+	// Y_j for j >= 1, alternating, such that Y_j overwrites Y_(j-2)
+	cl::Buffer& y_buffer(size_t j) { return y_buffers_[j % 2]; }
+
+	ODE_T& ode_;
+
+	state_kernels state_;
+
+	real_t spectral_radius_ = 0.0;
+	bool estimate_ = true;
+	size_t estimate_interval_ = 25;
+	size_t steps_since_estimate_ = 0;
+
+	// power iteration settings, the estimate is enlarged by the safety factor since it converges from below
+	const size_t power_iterations_ = 20;
+	const real_t spectral_radius_safety_ = 1.2;
+
+	real_t damping_ = rkc_default_damping;
+	rkc_coefficients coeffs_; // for coeffs_.stages, none initially
+
+	// OpenCL buffers
+	spare_buffer spare_; // y_(n+1) of the in-place step(), copied back into d_mem
+	cl::Buffer f_0_buffer_;
+	cl::Buffer f_buffer_; // F_(j-1)
+	cl::Buffer y_buffers_[2];
+
+	static const std::string embedded_ocl_source_;
+};
+
+template<typename ODE_T>
+const std::string rkc_stepper<ODE_T>::embedded_ocl_source_ {
+#include "rkc.cl.hpp"  // NOTE: generated by CMake
+};
+
+template<typename ODE_T>
+rkc_stepper<ODE_T>::rkc_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, embedded_ocl_source_, "rkc_stage", source_header, ocl_compile_options, range), ode_(ode),
+	  state_(ocl, source_header, ocl_compile_options, range)
+{
+	if (pool)
+		pool->begin_group();
+
+	f_0_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+	f_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+	for (auto& buffer : y_buffers_)
+		buffer = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+}
+
+template<typename ODE_T>
+stepper_cost rkc_stepper<ODE_T>::cost(size_t buffer_size_byte) const
+{
+	const size_t s = stages();
+
+	stepper_cost c;
+	c.ode_evaluations = s;
+	// every ODE evaluation reads Y_j and writes F_j
+	c.read_byte = s * buffer_size_byte;
+	c.written_byte = s * buffer_size_byte;
+	// every rkc_stage launch writes Y_j, Y_1 reads Y_0 and F_0, the others all five inputs
+	c.weighted_add_launches = s;
+	c.read_byte += (s > 0 ? 2 + 5 * (s - 1) : 0) * buffer_size_byte;
+	c.written_byte += s * buffer_size_byte;
+
+	c.temporary_buffers = 4;
+	c.temporary_byte = 4 * buffer_size_byte;
+	c.spare_byte = buffer_size_byte;
+	return c;
+}
+
+template<typename ODE_T>
+void rkc_stepper<ODE_T>::stage(cl::Buffer& out, real_t c0, cl::Buffer& y_0, real_t c1, cl::Buffer& y_jm1, real_t c2, cl::Buffer& y_jm2, real_t c3, cl::Buffer& f_jm1, real_t c4, cl::Buffer& f_0)
+{
+	cl_int err = 0;
+	err = kernel_.setArg(0, out);
+	ocl::error_handler(err, "clSetKernelArg(0)");
+	err = kernel_.setArg(1, c0);
+	ocl::error_handler(err, "clSetKernelArg(1)");
+	err = kernel_.setArg(2, y_0);
+	ocl::error_handler(err, "clSetKernelArg(2)");
+	err = kernel_.setArg(3, c1);
+	ocl::error_handler(err, "clSetKernelArg(3)");
+	err = kernel_.setArg(4, y_jm1);
+	ocl::error_handler(err, "clSetKernelArg(4)");
+	err = kernel_.setArg(5, c2);
+	ocl::error_handler(err, "clSetKernelArg(5)");
+	err = kernel_.setArg(6, y_jm2);
+	ocl::error_handler(err, "clSetKernelArg(6)");
+	err = kernel_.setArg(7, c3);
+	ocl::error_handler(err, "clSetKernelArg(7)");
+	err = kernel_.setArg(8, f_jm1);
+	ocl::error_handler(err, "clSetKernelArg(8)");
+	err = kernel_.setArg(9, c4);
+	ocl::error_handler(err, "clSetKernelArg(9)");
+	err = kernel_.setArg(10, f_0);
+	ocl::error_handler(err, "clSetKernelArg(10)");
+	run_kernel();
+}
+
+template<typename ODE_T>
+void rkc_stepper<ODE_T>::estimate_spectral_radius(real_t time, cl::Buffer& y_n, cl::Buffer& scratch)
+{
+	// the perturbation is relative to the largest state, and scaled by the square root of the machine epsilon
+	const std::vector<real_t> y_norm2 = state_.norm2(y_n);
+	const real_t y_norm = std::sqrt(*std::max_element(y_norm2.begin(), y_norm2.end()));
+	const real_t sqrt_epsilon = std::sqrt(std::numeric_limits<real_t>::epsilon());
+
+	// J * v ~ (f(y_n + delta * v) - f(y_n)) / delta, exact for linear ODEs
+	// NOTE: f_buffer_ holds the perturbed state, the unused inputs of stage() are set to y_n
+	auto apply = [&](cl::Buffer& in, cl::Buffer& out) {
+		const std::vector<real_t> v_norm2 = state_.norm2(in);
+		const real_t v_norm = std::sqrt(*std::max_element(v_norm2.begin(), v_norm2.end()));
+		if (v_norm == 0.0) {
+			state_.scale(out, 0.0, in);
+			return;
+		}
+		const real_t delta = sqrt_epsilon * (1.0 + y_norm) / v_norm;
+		stage(f_buffer_, 1.0, y_n, 0.0, y_n, 0.0, y_n, delta, in, 0.0, y_n);
+		ode_.solve(time, 0.0, f_buffer_, scratch, 0.0);
+		stage(out, 1.0 / delta, scratch, 0.0, y_n, 0.0, y_n, 0.0, y_n, -1.0 / delta, f_0_buffer_);
+	};
+
+	// starting from F_0 = f(y_n), as in RKC, which excites the stiff components more than y_n
+	spectral_radius_ = spectral_radius_safety_ * num::estimate_spectral_radius(apply, state_, f_0_buffer_, y_buffers_[0], y_buffers_[1], power_iterations_);
+	steps_since_estimate_ = 0;
+}
+
+template<typename ODE_T>
+real_t rkc_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	if (d_mem_in() == d_mem_out())
+		throw std::runtime_error("rkc_stepper::step(): error: d_mem_in and d_mem_out must differ, use the in-place step()");
+
+	// F_0 = f(t_n, Y_0)
+	ode_.solve(time, 0.0, d_mem_in, f_0_buffer_, step_size);
+
+	if (estimate_ && (spectral_radius_ <= 0.0 || (estimate_interval_ > 0 && steps_since_estimate_ >= estimate_interval_)))
+		estimate_spectral_radius(time, d_mem_in, d_mem_out); // NOTE: d_mem_out is not needed until the last stage
+	++steps_since_estimate_;
+
+	// the coefficients only depend on the number of stages
+	const size_t s = rkc_stages(step_size, spectral_radius_, damping_);
+	if (s != coeffs_.stages)
+		coeffs_ = rkc_coefficients(s, damping_);
+
+	const rkc_coefficients& co = coeffs_;
+	const real_t h = step_size;
+
+	// Y_1 = Y_0 + mu~_1 * h * F_0, NOTE: s >= 2
+	stage(y_buffer(1), 1.0, d_mem_in, 0.0, d_mem_in, 0.0, d_mem_in, 0.0, f_0_buffer_, co.mu_tilde[1] * h, f_0_buffer_);
+
+	for (size_t j = 2; j <= s; ++j) {
+		// F_(j-1) = f(t_n + c_(j-1) * h, Y_(j-1))
+		ode_.solve(time, co.c[j - 1] * h, y_buffer(j - 1), f_buffer_, step_size);
+
+		// Y_j overwrites Y_(j-2), except for Y_0 = y_n, and Y_s goes to d_mem_out
+		cl::Buffer& y_jm2 = (j == 2) ? d_mem_in : y_buffer(j - 2);
+		cl::Buffer& y_j = (j == s) ? d_mem_out : y_buffer(j);
+		stage(y_j, 1.0 - co.mu[j] - co.nu[j], d_mem_in, co.mu[j], y_buffer(j - 1), co.nu[j], y_jm2, co.mu_tilde[j] * h, f_buffer_, co.gamma_tilde[j] * h, f_0_buffer_);
+	}
+
+	return 0.0;
+}
+
+template<typename ODE_T>
+real_t rkc_stepper<ODE_T>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_rkc_stepper_hpp
@@ -0,0 +1,273 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_sde_stepper_hpp
+#define noma_num_sde_stepper_hpp
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/rk_stepper.hpp"
+
+namespace noma {
+namespace num {
+
+enum class sde_method_t {
+	euler_maruyama,
+	milstein,
+	sra1
+};
+
+const std::map<sde_method_t, std::string> sde_method_names {
+	{ sde_method_t::euler_maruyama, "euler_maruyama" },
+	{ sde_method_t::milstein, "milstein" },
+	{ sde_method_t::sra1, "sra1" }
+};
+
+std::ostream& operator<<(std::ostream& out, const sde_method_t& m);
+std::istream& operator>>(std::istream& in, sde_method_t& m);
+
+/**
+ * Stepper for Ito SDEs with diagonal noise, dY = f(t, Y) dt + g(t, Y) * dW,
+ * where every real state element has its own Wiener process:
+ *
+ * - euler_maruyama: strong order 0.5
+ * - milstein: derivative-free Milstein, strong order 1.0
+ * - sra1: Roessler's SRA1, strong order 1.5 for additive noise, i.e. g must
+ *   not depend on Y or t; g is evaluated once per step at t
+ *
+ * The ODE implements the separated solve() for the drift f, and:
+ *
+ * void solve_diffusion(real_t time, real_t dt, cl::Buffer& in, cl::Buffer& out); // out = g(time + dt, in)
+ *
+ * Wiener increments are generated on the device by a counter-based RNG (see
+ * philox.cl), keyed by (trajectory, step), inside the fused weighted-add
+ * kernel (see sde.cl). No random numbers or RNG states are stored, and the
+ * result only depends on the seed, the trajectory offset, and the step index,
+ * which is incremented by every step().
+ */
+template<typename ODE_T, sde_method_t METHOD>
+class sde_stepper : public ocl::kernel_wrapper // NOTE: this class does not wrap a kernel itself, but uses a kernel_function member
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::separated;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	sde_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+	sde_stepper(ocl::helper& ocl, const std::string& sde_weighted_add_kernel_source, const std::string& sde_weighted_add_kernel_name,
+	            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+	// to fullfill the same 'concept' as rk_stepper.hpp, the passed file is ignored
+	sde_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
+	            const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: sde_stepper(ocl, source_header, ocl_compile_options, range, ode, pool) { };
+
+	// NOTE: d_mem_in and d_mem_out may be the same buffer for euler_maruyama
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards
+	// NOTE: euler_maruyama works in place, the other methods write into a spare buffer, and copy it back into d_mem (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	// cost and memory model of step(), see stepper_cost.hpp
+	static stepper_cost cost(size_t buffer_size_byte);
+
+	// RNG key and counter, i.e. everything the noise depends on
+	void seed(uint32_t seed) { seed_ = seed; }
+	uint32_t seed() const { return seed_; }
+	void trajectory_offset(uint32_t offset) { trajectory_offset_ = offset; } // id of the first matrix of the buffer, e.g. for chunks of a larger ensemble
+	uint32_t trajectory_offset() const { return trajectory_offset_; }
+	void step_index(uint64_t index) { step_index_ = index; } // index of the next step
+	uint64_t step_index() const { return step_index_; }
+
+private:
+	// noise term coefficients of one diffusion evaluation g: sqrt(h) * g * (a * xi + b * zeta + m * (xi^2 - 1) + d)
+	struct noise_coeffs {
+		real_t a, b, m, d;
+	};
+
+	// out = y + h * (c1 * k1 + c2 * k2) + noise terms of g1 and g2
+	void weighted_add(real_t h, cl::Buffer& out, cl::Buffer& y,
+	                  real_t c1, cl::Buffer& k1, real_t c2, cl::Buffer& k2,
+	                  cl::Buffer& g1, const noise_coeffs& w1, cl::Buffer& g2, const noise_coeffs& w2);
+
+	ODE_T& ode_;
+
+	kernel_function weighted_add_kernel_;
+
+	uint32_t seed_ = 0;
+	uint32_t trajectory_offset_ = 0;
+	uint64_t step_index_ = 0;
+
+	// OpenCL buffers
+	spare_buffer spare_; // y_(n+1) of the in-place step(), copied back into d_mem
+	cl::Buffer k1_buffer_; // drift
+	cl::Buffer k2_buffer_; // second drift evaluation, sra1 only
+	cl::Buffer g1_buffer_; // diffusion
+	cl::Buffer g2_buffer_; // diffusion at the support value, milstein only
+
+	static const std::string embedded_ocl_source_;
+	static const std::string embedded_ocl_kernel_name_;
+};
+
+template<typename ODE_T, sde_method_t METHOD>
+const std::string sde_stepper<ODE_T, METHOD>::embedded_ocl_source_ {
+#include "sde.cl.hpp"  // NOTE: generated by CMake
+};
+template<typename ODE_T, sde_method_t METHOD>
+const std::string sde_stepper<ODE_T, METHOD>::embedded_ocl_kernel_name_ { "sde_weighted_add" };
+
+template<typename ODE_T, sde_method_t METHOD>
+sde_stepper<ODE_T, METHOD>::sde_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: sde_stepper(ocl, embedded_ocl_source_, embedded_ocl_kernel_name_, source_header, ocl_compile_options, range, ode, pool)
+{ }
+
+template<typename ODE_T, sde_method_t METHOD>
+sde_stepper<ODE_T, METHOD>::sde_stepper(ocl::helper& ocl, const std::string& sde_weighted_add_kernel_source, const std::string& sde_weighted_add_kernel_name,
+                                        const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: kernel_wrapper(ocl), ode_(ode), // NOTE: dummy initialisation of kernel_wrapper
+	  weighted_add_kernel_(ocl, sde_weighted_add_kernel_source, sde_weighted_add_kernel_name, source_header, ocl_compile_options, range)
+{
+	if (pool)
+		pool->begin_group();
+
+	k1_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+	g1_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+	if (METHOD == sde_method_t::sra1)
+		k2_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+	if (METHOD == sde_method_t::milstein)
+		g2_buffer_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+}
+
+template<typename ODE_T, sde_method_t METHOD>
+void sde_stepper<ODE_T, METHOD>::ode_compile_options(std::ostream& os)
+{
+	accumulate_compile_options(acc_method, os);
+}
+
+template<typename ODE_T, sde_method_t METHOD>
+stepper_cost sde_stepper<ODE_T, METHOD>::cost(size_t buffer_size_byte)
+{
+	// NOTE: drift and diffusion evaluations both count as ODE evaluations, each reads one state and writes one
+	auto evaluations = [&](stepper_cost& c, size_t n) {
+		c.ode_evaluations += n;
+		c.read_byte += n * buffer_size_byte;
+		c.written_byte += n * buffer_size_byte;
+	};
+	// sde_weighted_add reads y and the used k and g buffers, and writes one state
+	auto weighted_add = [&](stepper_cost& c, size_t inputs) {
+		++c.weighted_add_launches;
+		c.read_byte += inputs * buffer_size_byte;
+		c.written_byte += buffer_size_byte;
+	};
+
+	stepper_cost c;
+	evaluations(c, 2); // k1, g1
+	switch (METHOD) {
+		case sde_method_t::euler_maruyama:
+			weighted_add(c, 3); // y_n, k1, g1
+			c.temporary_buffers = 2;
+			break;
+		case sde_method_t::milstein:
+			weighted_add(c, 3); // y_n, k1, g1
+			evaluations(c, 1); // g2
+			weighted_add(c, 4); // y_n, k1, g1, g2
+			c.temporary_buffers = 3;
+			break;
+		case sde_method_t::sra1:
+			weighted_add(c, 3); // y_n, k1, g1
+			evaluations(c, 1); // k2
+			weighted_add(c, 4); // y_n, k1, k2, g1
+			c.temporary_buffers = 3;
+			break;
+	}
+	c.temporary_byte = c.temporary_buffers * buffer_size_byte;
+	c.spare_byte = (METHOD == sde_method_t::euler_maruyama) ? 0 : buffer_size_byte;
+	return c;
+}
+
+template<typename ODE_T, sde_method_t METHOD>
+void sde_stepper<ODE_T, METHOD>::weighted_add(real_t h, cl::Buffer& out, cl::Buffer& y,
+                                              real_t c1, cl::Buffer& k1, real_t c2, cl::Buffer& k2,
+                                              cl::Buffer& g1, const noise_coeffs& w1, cl::Buffer& g2, const noise_coeffs& w2)
+{
+	weighted_add_kernel_(static_cast<int_t>(2), h, out, y, c1, k1, c2, k2,
+	                     g1, w1.a, w1.b, w1.m, w1.d,
+	                     g2, w2.a, w2.b, w2.m, w2.d,
+	                     static_cast<cl_uint>(seed_), static_cast<cl_uint>(trajectory_offset_),
+	                     static_cast<cl_uint>(step_index_ & 0xFFFFFFFFu), static_cast<cl_uint>(step_index_ >> 32));
+}
+
+/* performs a single integration step */
+template<typename ODE_T, sde_method_t METHOD>
+real_t sde_stepper<ODE_T, METHOD>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	const noise_coeffs none { 0.0, 0.0, 0.0, 0.0 };
+	const real_t h = step_size;
+
+	// NOTE: milstein and sra1 write a support value into d_mem_out, while y_n is still needed
+	if (METHOD != sde_method_t::euler_maruyama && d_mem_in() == d_mem_out())
+		throw std::runtime_error("sde_stepper::step(): error: d_mem_in and d_mem_out must differ for this method, use the in-place step()");
+
+	// k1 = f(t_n, y_n), g1 = g(t_n, y_n)
+	ode_.solve(time, 0.0, d_mem_in, k1_buffer_, h);
+	ode_.solve_diffusion(time, 0.0, d_mem_in, g1_buffer_);
+
+	// NOTE: unused buffer arguments are set to k1 and g1 with zero coefficients
+	switch (METHOD) {
+		case sde_method_t::euler_maruyama:
+			// y_n+1 = y_n + h * f + g * dW
+			weighted_add(h, d_mem_out, d_mem_in, 1.0, k1_buffer_, 0.0, k1_buffer_, g1_buffer_, { 1.0, 0.0, 0.0, 0.0 }, g1_buffer_, none);
+			break;
+		case sde_method_t::milstein:
+			// support value: y_s = y_n + h * f + sqrt(h) * g
+			weighted_add(h, d_mem_out, d_mem_in, 1.0, k1_buffer_, 0.0, k1_buffer_, g1_buffer_, { 0.0, 0.0, 0.0, 1.0 }, g1_buffer_, none);
+			ode_.solve_diffusion(time, 0.0, d_mem_out, g2_buffer_);
+			// y_n+1 = y_n + h * f + g * dW + (g(y_s) - g) * (dW^2 - h) / (2 * sqrt(h))
+			weighted_add(h, d_mem_out, d_mem_in, 1.0, k1_buffer_, 0.0, k1_buffer_, g1_buffer_, { 1.0, 0.0, -0.5, 0.0 }, g2_buffer_, { 0.0, 0.0, 0.5, 0.0 });
+			break;
+		case sde_method_t::sra1: {
+			// H_2 = y_n + 3/4 * h * f + 3/2 * g * I_10 / h, with I_10 / h = sqrt(h) / 2 * (xi + zeta / sqrt(3))
+			const real_t zeta_coeff = 0.75 / std::sqrt(3.0);
+			weighted_add(h, d_mem_out, d_mem_in, 0.75, k1_buffer_, 0.0, k1_buffer_, g1_buffer_, { 0.75, zeta_coeff, 0.0, 0.0 }, g1_buffer_, none);
+			ode_.solve(time, 0.75 * h, d_mem_out, k2_buffer_, h);
+			// y_n+1 = y_n + h * (1/3 * f(H_1) + 2/3 * f(H_2)) + g * dW
+			weighted_add(h, d_mem_out, d_mem_in, 1.0 / 3.0, k1_buffer_, 2.0 / 3.0, k2_buffer_, g1_buffer_, { 1.0, 0.0, 0.0, 0.0 }, g1_buffer_, none);
+			break;
+		}
+	}
+
+	++step_index_;
+
+	return 0.0;
+}
+
+template<typename ODE_T, sde_method_t METHOD>
+real_t sde_stepper<ODE_T, METHOD>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	if (METHOD == sde_method_t::euler_maruyama)
+		return step(time, step_size, d_mem, d_mem);
+
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_sde_stepper_hpp
@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_sparse_matrix_hpp
+#define noma_num_sparse_matrix_hpp
+
+#include <vector>
+
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Host-side sparse formats for the square NUM_STATES x NUM_STATES operators of
+ * an ODE right-hand side, see sparse_operator_ode.hpp for their use.
+ *
+ * Column indices are int_t, as they are passed to OpenCL unchanged.
+ */
+
+// compressed sparse row, one operator shared by all matrices
+struct csr_matrix
+{
+	size_t size = 0; // rows and columns
+	std::vector<int_t> row_ptr; // size + 1 entries
+	std::vector<int_t> col_idx;
+	std::vector<complex_t> values;
+
+	size_t non_zeros() const { return values.size(); }
+};
+
+// ELLPACK, one operator shared by all matrices, rows padded to width entries
+// NOTE: padding entries have value zero and repeat a valid column index
+struct ell_matrix
+{
+	size_t size = 0;
+	size_t width = 0; // entries per row
+	std::vector<int_t> col_idx; // size x width, row-major
+	std::vector<complex_t> values; // size x width, row-major
+};
+
+// sliced ELLPACK with a sparsity pattern shared by all matrices, but separate values per matrix,
+// rows are grouped into slices of slice_size rows, each padded to its own width
+struct sliced_ell_matrix
+{
+	size_t size = 0;
+	size_t slice_size = 0;
+	size_t num_systems = 0; // number of value sets, i.e. NUM_MATRICES
+	std::vector<int_t> slice_ptr; // first entry of each slice, num_slices + 1 entries
+	std::vector<int_t> slice_width; // entries per row of each slice
+	std::vector<int_t> col_idx; // entry e of row r in slice s: slice_ptr[s] + e * slice_size + (r - s * slice_size)
+	// values of entry e of system m: values[e * num_systems + m], i.e. adjacent work-items read adjacent values
+	std::vector<complex_t> values;
+
+	size_t num_slices() const { return slice_width.size(); }
+	size_t padded_entries() const { return slice_ptr.empty() ? 0 : static_cast<size_t>(slice_ptr.back()); }
+};
+
+// creates a CSR matrix from a dense, row-major size x size matrix, dropping entries with abs(value) <= threshold
+csr_matrix make_csr_matrix(const std::vector<complex_t>& dense, size_t size, real_t threshold = 0.0);
+
+// transposed matrix, i.e. (a^T)_ij = a_ji, without conjugation
+csr_matrix transpose(const csr_matrix& a);
+
+// converts to ELLPACK, padding all rows to the longest one
+ell_matrix make_ell_matrix(const csr_matrix& a);
+
+// creates a sliced ELLPACK matrix from the shared sparsity pattern of a, with num_systems value sets,
+// values[m] must hold the values of system m in the order of a.values
+sliced_ell_matrix make_sliced_ell_matrix(const csr_matrix& a, const std::vector<std::vector<complex_t>>& values, size_t slice_size = 4);
+
+// transposed matrix with the same slice size, values per system are permuted accordingly
+sliced_ell_matrix transpose(const sliced_ell_matrix& a);
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_sparse_matrix_hpp
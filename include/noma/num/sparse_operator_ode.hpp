@@ -0,0 +1,107 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_sparse_operator_ode_hpp
+#define noma_num_sparse_operator_ode_hpp
+
+#include <string>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/sparse_matrix.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+enum class sparse_format {
+	csr,       // shared operator, compressed rows
+	ell,       // shared operator, padded rows
+	sliced_ell // shared sparsity pattern, values per matrix
+};
+
+/**
+ * Ready-to-use ODE for the steppers with a sparse operator a:
+ *
+ * f(sigma) = alpha * (a * sigma + sign * sigma * a)
+ *
+ * for NUM_MATRICES dense states sigma in the usual layout. With the defaults,
+ * this is the von Neumann equation d/dt sigma = -i [a, sigma]. sign = 0 yields
+ * the plain sparse times dense product, sign = 1 the anticommutator.
+ *
+ * As for commutator_ode, the kernel is compiled for the passed accumulate
+ * method, which must be the acc_method of the stepper using this ODE.
+ *
+ * NOTE: there is no stage-fused solve(), i.e. rk_stepper falls back to
+ *       integrated accumulation for accumulate_method::fused
+ */
+class sparse_operator_ode
+{
+public:
+	// format must be sparse_format::csr or sparse_format::ell, a is converted accordingly
+	sparse_operator_ode(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+	                    size_t num_matrices, const csr_matrix& a, sparse_format format, accumulate_method acc_method,
+	                    real_t sign = -1.0, complex_t alpha = complex_t(0.0, -1.0));
+	// a.num_systems must be num_matrices
+	sparse_operator_ode(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+	                    size_t num_matrices, const sliced_ell_matrix& a, accumulate_method acc_method,
+	                    real_t sign = -1.0, complex_t alpha = complex_t(0.0, -1.0));
+
+	size_t buffer_size_byte() const { return num_matrices_ * num_states_ * num_states_ * sizeof(complex_t); }
+
+	// accumulate_method::separated: out = f(in)
+	void solve(real_t time, real_t time_step, cl::Buffer& in, cl::Buffer& out, real_t coeff);
+	// accumulate_method::integrated, and the last stage of ::subdiagonal:
+	// out = f(in), acc = (init ? in : acc) + acc_coeff * f(in)
+	void solve(real_t time, real_t time_step, cl::Buffer& in, cl::Buffer& out, cl::Buffer& acc, real_t acc_coeff, bool init);
+	// accumulate_method::subdiagonal: out = y_n + next_coeff * f(in), acc as above, y_n is the input of the init call
+	void solve(real_t time, real_t time_step, cl::Buffer& in, cl::Buffer& out, real_t next_coeff, cl::Buffer& acc, real_t acc_coeff, bool init);
+
+private:
+	// device representation of one operator, unused members stay empty
+	struct device_operator {
+		int_t width = 0; // ELL
+		cl::Buffer ptr; // CSR row_ptr, sliced ELL slice_ptr
+		cl::Buffer slice_width; // sliced ELL
+		cl::Buffer col_idx;
+		cl::Buffer values;
+	};
+
+	static std::string accumulate_defines(accumulate_method acc_method);
+	static std::string kernel_name(sparse_format format);
+
+	template<typename T>
+	cl::Buffer upload(const std::vector<T>& data);
+
+	template<typename... ACC_ARGS>
+	void run(cl::Buffer& in, cl::Buffer& out, const ACC_ARGS&... acc_args);
+
+	ocl::helper& ocl_;
+
+	const sparse_format format_;
+	const accumulate_method acc_method_;
+	kernel_function kernel_;
+
+	const size_t num_matrices_;
+	size_t num_states_ = 0;
+	int_t slice_size_ = 0;
+
+	const real_t sign_;
+	const complex_t alpha_;
+
+	device_operator a_;
+	device_operator at_; // transpose of a_
+
+	cl::Buffer y_n_; // input of the last init call, for ::subdiagonal
+
+	static const std::string embedded_ocl_source_;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_sparse_operator_ode_hpp
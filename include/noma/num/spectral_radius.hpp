@@ -0,0 +1,66 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_spectral_radius_hpp
+#define noma_num_spectral_radius_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/state_kernels.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Estimates the spectral radius of a linear operator L by power iteration,
+ * starting from the state in start. The result is the maximum over all
+ * matrices of ||L * v|| / ||v|| after the last iteration.
+ *
+ * apply(in, out) must compute out = L * in, e.g. by an ODE evaluation.
+ * tmp_a and tmp_b are state sized temporaries, start is not modified.
+ *
+ * NOTE: The estimate converges from below. It only covers the part of the
+ *       spectrum excited by start, which is the relevant part for
+ *       propagating start itself.
+ */
+template<typename APPLY_T>
+real_t estimate_spectral_radius(APPLY_T apply, state_kernels& state, cl::Buffer& start, cl::Buffer& tmp_a, cl::Buffer& tmp_b, size_t iterations)
+{
+	state.scale(tmp_a, 1.0, start);
+	std::vector<real_t> norm_in = state.norm2(tmp_a);
+
+	real_t rho = 0.0;
+	for (size_t it = 0; it < iterations; ++it) {
+		apply(tmp_a, tmp_b);
+		std::vector<real_t> norm_out = state.norm2(tmp_b);
+
+		rho = 0.0;
+		real_t max_norm_out = 0.0;
+		for (size_t m = 0; m < norm_out.size(); ++m) {
+			if (norm_in[m] > 0.0)
+				rho = std::max(rho, std::sqrt(norm_out[m] / norm_in[m]));
+			max_norm_out = std::max(max_norm_out, norm_out[m]);
+		}
+
+		if (max_norm_out == 0.0) // L * start = 0
+			break;
+
+		// normalise by a common factor, to keep per-matrix ratios
+		state.scale(tmp_a, 1.0 / std::sqrt(max_norm_out), tmp_b);
+		for (size_t m = 0; m < norm_out.size(); ++m)
+			norm_in[m] = norm_out[m] / max_norm_out;
+	}
+
+	return rho;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_spectral_radius_hpp
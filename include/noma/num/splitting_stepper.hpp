@@ -0,0 +1,200 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_splitting_stepper_hpp
+#define noma_num_splitting_stepper_hpp
+
+#include <algorithm>
+#include <ostream>
+
+#include <noma/ocl/helper.hpp>
+#include <noma/ocl/kernel_wrapper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/rk_stepper.hpp"
+#include "noma/num/splitting_tableau.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Symplectic partitioned stepper for separable Hamiltonian systems
+ * H(q, p) = T(p) + V(q), see splitting_tableau.hpp for the methods.
+ *
+ * The ODE must implement a partitioned interface instead of solve():
+ *
+ * size_t buffer_size_byte() const; // of the whole state, i.e. positions and momenta
+ * void solve_position(real_t time, real_t dt, cl::Buffer& in, cl::Buffer& out); // out = dT/dp(p of in)
+ * void solve_momentum(real_t time, real_t dt, cl::Buffer& in, cl::Buffer& out); // out = -dV/dq(q of in)
+ *
+ * The state buffer holds the positions of all systems in its first and the
+ * momenta in its second half, out has the size of one half, see splitting.cl.
+ * Like for solve(), time + dt is the evaluation time.
+ *
+ * The step is computed in place on d_mem_out after copying d_mem_in, so the
+ * only temporary is one half-size derivative buffer. With d_mem_in equal to
+ * d_mem_out, or the in-place step(), there is no copy, and no second state
+ * buffer is needed at all.
+ */
+template<typename ODE_T, splitting_method_t METHOD>
+class splitting_stepper : public ocl::kernel_wrapper
+{
+public:
+	using ode_type = ODE_T;
+
+	static constexpr accumulate_method acc_method = accumulate_method::separated;
+
+	// NOTE: if pool is set, all temporary buffers are taken from it (see buffer_pool.hpp)
+	splitting_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+	splitting_stepper(ocl::helper& ocl, const std::string& splitting_update_kernel_source, const std::string& splitting_update_kernel_name,
+	                  const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+	splitting_stepper(ocl::helper& ocl, const boost::filesystem::path& splitting_update_file_name, const std::string& splitting_update_kernel_name,
+	                  const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr);
+
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
+
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem) { return step(time, step_size, d_mem, d_mem); }
+
+	// generate OpenCL compile options for ODE implementation
+	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
+
+	// cost and memory model of step(), see stepper_cost.hpp
+	static stepper_cost cost(size_t buffer_size_byte);
+
+private:
+	void initialise(buffer_pool* pool);
+	void update(cl::Buffer& y, int half, real_t h);
+
+	// method specification
+	const splitting_tableau s_tab;
+
+	ODE_T& ode;
+
+	// OpenCL buffers
+	cl::Buffer k_buffer; // derivative of one half
+
+	static const std::string embedded_ocl_source_;
+	static const std::string embedded_ocl_kernel_name_;
+};
+
+template<typename ODE_T, splitting_method_t METHOD>
+const std::string splitting_stepper<ODE_T, METHOD>::embedded_ocl_source_ {
+#include "splitting.cl.hpp"  // NOTE: generated by CMake
+};
+template<typename ODE_T, splitting_method_t METHOD>
+const std::string splitting_stepper<ODE_T, METHOD>::embedded_ocl_kernel_name_ { "splitting_update" };
+
+template<typename ODE_T, splitting_method_t METHOD>
+splitting_stepper<ODE_T, METHOD>::splitting_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, embedded_ocl_source_, embedded_ocl_kernel_name_, source_header, ocl_compile_options, range), s_tab(get_splitting_tableau(METHOD)), ode(ode)
+{
+	initialise(pool);
+}
+
+template<typename ODE_T, splitting_method_t METHOD>
+splitting_stepper<ODE_T, METHOD>::splitting_stepper(ocl::helper& ocl, const std::string& splitting_update_kernel_source, const std::string& splitting_update_kernel_name,
+                                                    const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, splitting_update_kernel_source, splitting_update_kernel_name, source_header, ocl_compile_options, range), s_tab(get_splitting_tableau(METHOD)), ode(ode)
+{
+	initialise(pool);
+}
+
+template<typename ODE_T, splitting_method_t METHOD>
+splitting_stepper<ODE_T, METHOD>::splitting_stepper(ocl::helper& ocl, const boost::filesystem::path& splitting_update_file_name, const std::string& splitting_update_kernel_name,
+                                                    const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool)
+	: ocl::kernel_wrapper(ocl, splitting_update_file_name, splitting_update_kernel_name, source_header, ocl_compile_options, range), s_tab(get_splitting_tableau(METHOD)), ode(ode)
+{
+	initialise(pool);
+}
+
+template<typename ODE_T, splitting_method_t METHOD>
+void splitting_stepper<ODE_T, METHOD>::initialise(buffer_pool* pool)
+{
+	if (pool)
+		pool->begin_group();
+
+	k_buffer = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte() / 2);
+}
+
+template<typename ODE_T, splitting_method_t METHOD>
+void splitting_stepper<ODE_T, METHOD>::ode_compile_options(std::ostream&)
+{
+	// NOTE: the partitioned interface has no accumulation, nothing to define
+}
+
+template<typename ODE_T, splitting_method_t METHOD>
+stepper_cost splitting_stepper<ODE_T, METHOD>::cost(size_t buffer_size_byte)
+{
+	const splitting_tableau s_tab = get_splitting_tableau(METHOD);
+	const size_t half_byte = buffer_size_byte / 2;
+
+	stepper_cost c;
+	// copy of d_mem_in into d_mem_out, NOTE: skipped for in-place steps
+	c.read_byte = buffer_size_byte;
+	c.written_byte = buffer_size_byte;
+
+	// every non-zero coefficient is one ODE evaluation, reading one half and writing k,
+	// and one update, reading one half and k, and writing the half
+	const size_t updates = std::count_if(s_tab.a.begin(), s_tab.a.end(), [](real_t coeff) { return coeff != 0.0; })
+	                     + std::count_if(s_tab.b.begin(), s_tab.b.end(), [](real_t coeff) { return coeff != 0.0; });
+	c.ode_evaluations = updates;
+	c.weighted_add_launches = updates;
+	c.read_byte += updates * 3 * half_byte;
+	c.written_byte += updates * 2 * half_byte;
+
+	c.temporary_buffers = 1;
+	c.temporary_byte = half_byte;
+	return c;
+}
+
+template<typename ODE_T, splitting_method_t METHOD>
+void splitting_stepper<ODE_T, METHOD>::update(cl::Buffer& y, int half, real_t h)
+{
+	cl_int err = 0;
+	err = kernel_.setArg(0, y);
+	ocl::error_handler(err, "clSetKernelArg(0)");
+	err = kernel_.setArg(1, half);
+	ocl::error_handler(err, "clSetKernelArg(1)");
+	err = kernel_.setArg(2, h);
+	ocl::error_handler(err, "clSetKernelArg(2)");
+	err = kernel_.setArg(3, k_buffer);
+	ocl::error_handler(err, "clSetKernelArg(3)");
+	run_kernel();
+}
+
+/* performs a single integration step */
+template<typename ODE_T, splitting_method_t METHOD>
+real_t splitting_stepper<ODE_T, METHOD>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
+{
+	if (d_mem_in() != d_mem_out()) {
+		cl_int err = ocl_.command_queue().enqueueCopyBuffer(d_mem_in, d_mem_out, 0, 0, ode.buffer_size_byte());
+		ocl::error_handler(err, "clEnqueueCopyBuffer(d_mem_out)");
+	}
+
+	// times reached by the position and momentum updates so far, relative to step_size
+	real_t q_time = 0.0;
+	real_t p_time = 0.0;
+	for (size_t i = 0; i < s_tab.a.size(); ++i) {
+		// q = q + a_i * h * dT/dp(p)
+		if (s_tab.a[i] != 0.0) {
+			ode.solve_position(time, p_time * step_size, d_mem_out, k_buffer);
+			update(d_mem_out, 0, s_tab.a[i] * step_size);
+			q_time += s_tab.a[i];
+		}
+		// p = p - b_i * h * dV/dq(q), the sign is part of solve_momentum()
+		if (s_tab.b[i] != 0.0) {
+			ode.solve_momentum(time, q_time * step_size, d_mem_out, k_buffer);
+			update(d_mem_out, 1, s_tab.b[i] * step_size);
+			p_time += s_tab.b[i];
+		}
+	}
+
+	return 0.0;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_splitting_stepper_hpp
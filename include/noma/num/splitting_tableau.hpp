@@ -0,0 +1,67 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_splitting_tableau_hpp
+#define noma_num_splitting_tableau_hpp
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+enum class splitting_method_t {
+	verlet,
+	yoshida4,
+	yoshida6,
+	blanes_moan4
+};
+
+const std::map<splitting_method_t, std::string> splitting_method_names {
+	{ splitting_method_t::verlet, "verlet" },
+	{ splitting_method_t::yoshida4, "yoshida4" },
+	{ splitting_method_t::yoshida6, "yoshida6" },
+	{ splitting_method_t::blanes_moan4, "blanes_moan4" }
+};
+
+std::ostream& operator<<(std::ostream& out, const splitting_method_t& m);
+std::istream& operator>>(std::istream& in, splitting_method_t& m);
+
+/**
+ * Coefficients of a partitioned splitting method for H(q, p) = T(p) + V(q).
+ * Stage i first updates the positions, then the momenta:
+ *
+ * q = q + a_i * h * dT/dp(p)
+ * p = p - b_i * h * dV/dq(q)
+ *
+ * Zero coefficients are skipped, i.e. a leading a_1 = 0 or a trailing b_s = 0
+ * cost no ODE evaluation.
+ */
+struct splitting_tableau
+{
+	using coeffs_t = std::vector<real_t>;
+
+	coeffs_t a; // position coefficients, s entries
+	coeffs_t b; // momentum coefficients, s entries
+	size_t order;
+};
+
+/**
+ * Returns a splitting_tableau for a given splitting method (splitting_method_t).
+ */
+const splitting_tableau& get_splitting_tableau(const splitting_method_t method);
+
+/**
+ * Returns the tableau of the composition of velocity Verlet steps with the
+ * step sizes gamma_k * h, merging adjacent momentum updates.
+ */
+splitting_tableau make_verlet_composition(const std::vector<long_real_t>& gamma, size_t order);
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_splitting_tableau_hpp
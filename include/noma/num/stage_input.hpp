@@ -0,0 +1,78 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_stage_input_hpp
+#define noma_num_stage_input_hpp
+
+#include <array>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Host side of the stage input of accumulate_method::fused, i.e. the
+ * arguments of NOMA_NUM_STAGE_PARAMS (see cl/stage_input.cl):
+ *
+ * in = y_n + h * sum(l)(coeffs[l] * ks[l])
+ *
+ * Trailing zero coefficients are dropped, such that the k written by the
+ * stage itself is never an argument. Unused arguments are padded with a zero
+ * coefficient and the y_n buffer.
+ */
+struct stage_input
+{
+	static constexpr size_t max_ks = 7; // must match NOMA_NUM_STAGE_MAX_KS
+
+	stage_input(real_t h, const std::vector<real_t>& stage_coeffs, std::vector<cl::Buffer>& stage_ks, cl::Buffer& y_n);
+
+	real_t h;
+	int_t n; // number of used coefficients
+	std::array<real_t, max_ks> coeffs;
+	std::array<cl::Buffer, max_ks> ks;
+};
+
+// runs kernel with args, followed by the arguments of NOMA_NUM_STAGE_PARAMS for stage
+template<typename... ARGS>
+void run_with_stage_input(kernel_function& kernel, const stage_input& stage, const ARGS&... args)
+{
+	kernel(args..., stage.h, stage.n,
+	       stage.coeffs[0], stage.ks[0], stage.coeffs[1], stage.ks[1], stage.coeffs[2], stage.ks[2], stage.coeffs[3], stage.ks[3],
+	       stage.coeffs[4], stage.ks[4], stage.coeffs[5], stage.ks[5], stage.coeffs[6], stage.ks[6]);
+}
+
+/**
+ * True iff ODE has the solve() overload of accumulate_method::fused:
+ *
+ * void solve(real_t time, real_t time_step, cl::Buffer& y_n, real_t h, const std::vector<real_t>& stage_coeffs, std::vector<cl::Buffer>& ks,
+ *            cl::Buffer& out, cl::Buffer& acc, real_t acc_coeff, bool init);
+ *
+ * i.e. out = f(y_n + h * sum(l)(stage_coeffs[l] * ks[l])), and acc as for
+ * accumulate_method::integrated. Otherwise, rk_stepper falls back to
+ * integrated accumulation.
+ */
+template<typename ODE>
+struct has_fused_solve
+{
+private:
+	template<typename T>
+	static auto test(T* ode) -> decltype(ode->solve(real_t(), real_t(), std::declval<cl::Buffer&>(), real_t(), std::declval<const std::vector<real_t>&>(), std::declval<std::vector<cl::Buffer>&>(),
+	                                                std::declval<cl::Buffer&>(), std::declval<cl::Buffer&>(), real_t(), bool()), std::true_type());
+	static std::false_type test(...);
+
+public:
+	static constexpr bool value = decltype(test(static_cast<ODE*>(nullptr)))::value;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_stage_input_hpp
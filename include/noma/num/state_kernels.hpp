@@ -0,0 +1,63 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_state_kernels_hpp
+#define noma_num_state_kernels_hpp
+
+#include <string>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * Collection of basic operations on batched ODE states, i.e. NUM_MATRICES
+ * complex NUM_STATES x NUM_STATES matrices, as used by the steppers that need
+ * more than ODE evaluations and weighted sums.
+ *
+ * The problem dimensions are queried from the OpenCL defines on construction.
+ */
+class state_kernels
+{
+public:
+	state_kernels(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range);
+
+	size_t num_matrices() const { return num_matrices_; }
+	size_t num_states() const { return num_states_; }
+	size_t state_dim() const { return num_states_ * num_states_; } // complex elements per matrix
+
+	// sets every state to the j-th unit basis vector
+	void set_basis(cl::Buffer& out, size_t j);
+
+	// out = alpha * in
+	void scale(cl::Buffer& out, real_t alpha, cl::Buffer& in);
+
+	// squared 2-norm of each state, read back to the host
+	std::vector<real_t> norm2(cl::Buffer& in);
+
+private:
+	ocl::helper& ocl_;
+
+	kernel_function dimensions_kernel_;
+	kernel_function set_basis_kernel_;
+	kernel_function scale_kernel_;
+	kernel_function norm2_kernel_;
+
+	size_t num_matrices_ = 0;
+	size_t num_states_ = 0;
+
+	cl::Buffer norm2_buffer_;
+
+	static const std::string embedded_ocl_source_;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_state_kernels_hpp
@@ -0,0 +1,177 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_status_monitor_hpp
+#define noma_num_status_monitor_hpp
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/kernel_function.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * What status_monitor does when a state contains NaN or Inf, or exceeds the
+ * max. norm limit.
+ * - abort: throws status_error, the state is left as it is.
+ * - rollback: restores the last verified checkpoint into the state, and
+ *   throws status_error with its time, such that the caller can continue
+ *   from there, e.g. with a smaller step size.
+ */
+enum class status_action {
+	abort,
+	rollback
+};
+
+const std::map<status_action, std::string> status_action_names {
+	{ status_action::abort, "abort" },
+	{ status_action::rollback, "rollback" }
+};
+
+std::ostream& operator<<(std::ostream& out, const status_action& action);
+std::istream& operator>>(std::istream& in, status_action& action);
+
+// writes the OpenCL define for kernels with a fused status computation, i.e. NOMA_NUM_STATUS
+void status_compile_options(std::ostream& os);
+
+struct state_status
+{
+	real_t max_norm = 0.0; // max. absolute value of all real and imaginary parts, INFINITY if any of them was NaN or Inf
+
+	bool finite() const { return std::isfinite(max_norm); }
+};
+
+/**
+ * Thrown by status_monitor, see status_action.
+ */
+class status_error : public std::runtime_error
+{
+public:
+	status_error(const std::string& what, const state_status& status, real_t time, bool rolled_back, real_t rollback_time)
+		: std::runtime_error(what), status_(status), time_(time), rolled_back_(rolled_back), rollback_time_(rollback_time)
+	{ }
+
+	const state_status& status() const { return status_; }
+	real_t time() const { return time_; } // the failure happened at or before this time, i.e. within the last poll interval
+	bool rolled_back() const { return rolled_back_; } // false for status_action::abort, or if no checkpoint was verified yet
+	real_t rollback_time() const { return rollback_time_; } // time of the restored state
+
+private:
+	state_status status_;
+	real_t time_;
+	bool rolled_back_;
+	real_t rollback_time_;
+};
+
+/**
+ * Detects NaN, Inf, and blow-up of the states during an integration with
+ * almost no additional memory traffic.
+ *
+ * Kernels compiled with NOMA_NUM_STATUS compute the status of every state
+ * element they write on the fly, reduce it per work-group in local memory,
+ * and merge it into one status word per work-group (see cl/status.cl), e.g.
+ * rk_weighted_add for rk_stepper with TRACK_STATUS. Every poll_interval()
+ * steps, the status words are reduced on the device, and read back
+ * asynchronously. The result is evaluated at the next poll, i.e. the host
+ * never waits for it, and a failure is detected at most two poll intervals
+ * after it happened.
+ *
+ * For status_action::rollback, the state is copied into a checkpoint at
+ * every poll, which is verified by the next poll.
+ *
+ * NOTE: needs an explicit work-group size in range, as the number of status
+ *       words is the number of work-groups
+ */
+class status_monitor
+{
+public:
+	status_monitor(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, size_t buffer_size_byte);
+
+	size_t poll_interval() const { return poll_interval_; }
+	void poll_interval(size_t steps);
+
+	status_action action() const { return action_; }
+	void action(status_action action) { action_ = action; }
+
+	// states with a larger max. norm count as blown up, default: only NaN and Inf are detected
+	real_t max_norm() const { return max_norm_; }
+	void max_norm(real_t limit) { max_norm_ = limit; }
+
+	// kernel arguments of kernels with NOMA_NUM_STATUS
+	cl::Buffer& status_buffer() { return status_buffer_; }
+	cl::LocalSpaceArg status_local() const { return cl::Local(local_size_ * sizeof(real_t)); }
+
+	// merges the status of a complete state, for steppers, or parts of them, without a fused status computation
+	void scan(cl::Buffer& in);
+
+	/**
+	 * To be called by the stepper after every step, with its new state at
+	 * time, polls every poll_interval() steps. Throws status_error.
+	 *
+	 * fused: the status words already cover d_mem, otherwise d_mem is
+	 *        scanned at every poll, i.e. once per poll interval
+	 */
+	void after_step(real_t time, cl::Buffer& d_mem, bool fused);
+
+	// blocks until all steps so far are evaluated, throws status_error as after_step()
+	void check(real_t time, cl::Buffer& d_mem, bool fused);
+
+	// status of the last evaluated poll
+	const state_status& last_status() const { return last_status_; }
+
+	// discards the status words, pending polls, and checkpoints, e.g. after the caller set a new state
+	void reset();
+
+private:
+	void poll(real_t time, cl::Buffer& d_mem, bool fused);
+	void evaluate(cl::Buffer& d_mem);
+
+	ocl::helper& ocl_;
+	const size_t buffer_size_byte_;
+
+	kernel_function reduce_kernel_;
+	kernel_function scan_kernel_;
+
+	size_t local_size_ = 0; // work-items per work-group
+	size_t num_groups_ = 0; // status words
+
+	size_t poll_interval_ = 16;
+	status_action action_ = status_action::abort;
+	real_t max_norm_ = std::numeric_limits<real_t>::max();
+
+	cl::Buffer status_buffer_;
+	cl::Buffer result_buffer_;
+
+	size_t steps_ = 0; // since the last poll
+
+	// asynchronously read result of the last poll
+	bool pending_ = false;
+	real_t pending_result_ = 0.0;
+	real_t pending_time_ = 0.0;
+	cl::Event pending_event_;
+	spare_buffer pending_checkpoint_;
+
+	bool verified_ = false;
+	real_t verified_time_ = 0.0;
+	spare_buffer verified_checkpoint_;
+
+	state_status last_status_;
+
+	static const std::string embedded_ocl_source_;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_status_monitor_hpp
@@ -0,0 +1,51 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_stepper_cost_hpp
+#define noma_num_stepper_cost_hpp
+
+#include <cstddef>
+#include <iostream>
+
+namespace noma {
+namespace num {
+
+/**
+ * Cost and memory model of a single step of a stepper, as a function of the
+ * ODE's buffer_size_byte(), see the steppers' cost() member functions, and
+ * make_stepper_cost() in make_stepper.hpp for runtime-configured steppers.
+ *
+ * The byte counts are the global memory traffic on state-sized buffers, i.e.
+ * every buffer element is assumed to be read or written once per kernel
+ * launch. An ODE evaluation reads its input state and writes its output,
+ * plus its accumulation buffer (see accumulate_method). Data that is internal
+ * to the ODE, like a Hamiltonian, is not known to the stepper and excluded.
+ * This makes the numbers a lower bound, suitable to compare steppers for the
+ * same ODE.
+ *
+ * NOTE: cost() is static for steppers with a fixed amount of work per step,
+ *       e.g. rk_stepper and taylor_stepper. Steppers that adapt it to the
+ *       step size or to error estimates, e.g. chebyshev_stepper or
+ *       krylov_stepper, provide a non-static cost() for their current state.
+ */
+struct stepper_cost
+{
+	size_t ode_evaluations = 0; // per step
+	size_t weighted_add_launches = 0; // per step, launches of the stepper's own kernels, e.g. rk_weighted_add
+	size_t temporary_buffers = 0; // held by the stepper for its lifetime
+	size_t temporary_byte = 0; // total size of the temporary buffers
+	size_t spare_byte = 0; // additional buffer of the in-place step(), allocated on first use, and copied back into the state (see spare_buffer)
+	size_t read_byte = 0; // per step
+	size_t written_byte = 0; // per step
+
+	// device memory the stepper needs in addition to the state itself
+	size_t memory_byte() const { return temporary_byte + spare_byte; }
+};
+
+std::ostream& operator<<(std::ostream& out, const stepper_cost& cost);
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_stepper_cost_hpp
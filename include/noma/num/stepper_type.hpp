@@ -24,11 +24,24 @@ namespace num {
  * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::rk4, num::accumulate_method::separated>;
  * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::rk4, num::accumulate_method::integrated>;
  * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::rk4, num::accumulate_method::subdiagonal>;
+ * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::dopri54, num::accumulate_method::fused>; // ODE with stage-fused solve(), see stage_input.hpp
+ * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::dopri54, num::accumulate_method::separated, num::k_storage::half>; // ODE kernel must store via NOMA_NUM_STORE_K()
  * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::fehlberg54>;
  * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::dopri54>;
  * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::cashkarp54>;
  * using stepper_t = num::rk_stepper<ODE_TYPE, num::rk_method_t::bosha32>;
  * using stepper_t = num::taylor_stepper<ODE_TYPE, 5>; // 5 can be any positive integer >=1
+ * using stepper_t = num::propagator_stepper<ODE_TYPE>; // linear time-invariant ODEs only
+ * using stepper_t = num::chebyshev_stepper<ODE_TYPE>; // linear ODEs with purely imaginary spectrum only
+ * using stepper_t = num::rkc_stepper<ODE_TYPE>; // mildly stiff ODEs with a spectrum near the negative real axis
+ * using stepper_t = num::imex_stepper<ODE_TYPE, num::imex_method_t::ark436l2sa>; // ODEs with a stiff linear part, see solve_implicit()
+ * using stepper_t = num::krylov_stepper<ODE_TYPE>; // linear ODEs only, adaptive Krylov dimension
+ * using stepper_t = num::bulirsch_stoer_stepper<ODE_TYPE>; // smooth ODEs with tight tolerances, adaptive order
+ * using stepper_t = num::splitting_stepper<ODE_TYPE, num::splitting_method_t::yoshida4>; // separable Hamiltonian systems, partitioned ODE interface
+ * using stepper_t = num::sde_stepper<ODE_TYPE, num::sde_method_t::milstein>; // SDEs, ODE with solve_diffusion()
+ *
+ * Every rk_method_t can be combined with accumulate_method::separated, ::integrated, and ::fused,
+ * accumulate_method::subdiagonal requires a subdiagonal Butcher tableau (midpoint, rk4).
  *
  * Does not make much sense alone, but valid (with any wrapped stepper type), intended to be used with
  * polymorphic_stepper interface:
@@ -39,50 +52,70 @@ namespace num {
  * using stepper_t = num::meta_stepper; // uses solver_stepper_t (see below), e.g. read from config
  */
 
+/**
+ * Compile-time list of all runtime configurable stepper types. Each entry is
+ * X(name, stepper class template, template arguments following the ODE type).
+ *
+ * stepper_type_t, stepper_type_names, stepper_type_to_type, and the runtime
+ * dispatch in make_unique_polymorphic_stepper() and the other generator functions
+ * of make_stepper.hpp are generated from this list.
+ *
+ * NOTE: accumulate_method::subdiagonal is only listed for methods with a
+ *       subdiagonal Butcher tableau, see is_subdiagonal().
+ * NOTE: new entries go to the end, to keep the values of existing ones.
+ */
+#define NOMA_NUM_STEPPER_TYPES(X) \
+	X(rk_euler,                 rk_stepper, rk_method_t::euler,      accumulate_method::separated) \
+	X(rk_midpoint,              rk_stepper, rk_method_t::midpoint,   accumulate_method::separated) \
+	X(rk_rk4,                   rk_stepper, rk_method_t::rk4,        accumulate_method::separated) \
+	X(rk_fehlberg54,            rk_stepper, rk_method_t::fehlberg54, accumulate_method::separated) \
+	X(rk_dopri54,               rk_stepper, rk_method_t::dopri54,    accumulate_method::separated) \
+	X(rk_cashkarp54,            rk_stepper, rk_method_t::cashkarp54, accumulate_method::separated) \
+	X(rk_bosha32,               rk_stepper, rk_method_t::bosha32,    accumulate_method::separated) \
+	X(taylor_1,                 taylor_stepper, 1) \
+	X(taylor_2,                 taylor_stepper, 2) \
+	X(taylor_3,                 taylor_stepper, 3) \
+	X(taylor_4,                 taylor_stepper, 4) \
+	X(taylor_5,                 taylor_stepper, 5) \
+	X(taylor_6,                 taylor_stepper, 6) \
+	X(taylor_7,                 taylor_stepper, 7) \
+	X(taylor_8,                 taylor_stepper, 8) \
+	X(taylor_9,                 taylor_stepper, 9) \
+	X(rk_euler_integrated,      rk_stepper, rk_method_t::euler,      accumulate_method::integrated) \
+	X(rk_midpoint_integrated,   rk_stepper, rk_method_t::midpoint,   accumulate_method::integrated) \
+	X(rk_rk4_integrated,        rk_stepper, rk_method_t::rk4,        accumulate_method::integrated) \
+	X(rk_fehlberg54_integrated, rk_stepper, rk_method_t::fehlberg54, accumulate_method::integrated) \
+	X(rk_dopri54_integrated,    rk_stepper, rk_method_t::dopri54,    accumulate_method::integrated) \
+	X(rk_cashkarp54_integrated, rk_stepper, rk_method_t::cashkarp54, accumulate_method::integrated) \
+	X(rk_bosha32_integrated,    rk_stepper, rk_method_t::bosha32,    accumulate_method::integrated) \
+	X(rk_midpoint_subdiagonal,  rk_stepper, rk_method_t::midpoint,   accumulate_method::subdiagonal) \
+	X(rk_rk4_subdiagonal,       rk_stepper, rk_method_t::rk4,        accumulate_method::subdiagonal) \
+	X(rk_euler_fused,           rk_stepper, rk_method_t::euler,      accumulate_method::fused) \
+	X(rk_midpoint_fused,        rk_stepper, rk_method_t::midpoint,   accumulate_method::fused) \
+	X(rk_rk4_fused,             rk_stepper, rk_method_t::rk4,        accumulate_method::fused) \
+	X(rk_fehlberg54_fused,      rk_stepper, rk_method_t::fehlberg54, accumulate_method::fused) \
+	X(rk_dopri54_fused,         rk_stepper, rk_method_t::dopri54,    accumulate_method::fused) \
+	X(rk_cashkarp54_fused,      rk_stepper, rk_method_t::cashkarp54, accumulate_method::fused) \
+	X(rk_bosha32_fused,         rk_stepper, rk_method_t::bosha32,    accumulate_method::fused)
+
 /**
  * Parseable stepper type for runtime configurable stepper type, e.g. for configuration files.
  */
 enum class stepper_type_t
 {
-	rk_euler = 0,
-	rk_midpoint,
-	rk_rk4,
-	rk_fehlberg54,
-	rk_dopri54,
-	rk_cashkarp54,
-	rk_bosha32,
-	taylor_1,
-	taylor_2,
-	taylor_3,
-	taylor_4,
-	taylor_5,
-	taylor_6,
-	taylor_7,
-	taylor_8,
-	taylor_9
+#define NOMA_NUM_STEPPER_TYPE_VALUE(name, ...) name,
+	NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_VALUE)
+#undef NOMA_NUM_STEPPER_TYPE_VALUE
 };
 
 const std::map<stepper_type_t, std::string> stepper_type_names{
-	{stepper_type_t::rk_euler,      "rk_euler"},
-	{stepper_type_t::rk_midpoint,   "rk_midpoint"},
-	{stepper_type_t::rk_rk4,        "rk_rk4"},
-	{stepper_type_t::rk_fehlberg54, "rk_fehlberg54"},
-	{stepper_type_t::rk_dopri54,    "rk_dopri54"},
-	{stepper_type_t::rk_cashkarp54, "rk_cashkarp54"},
-	{stepper_type_t::rk_bosha32,    "rk_bosha32"},
-	{stepper_type_t::taylor_1, "taylor_1"},
-	{stepper_type_t::taylor_2, "taylor_2"},
-	{stepper_type_t::taylor_3, "taylor_3"},
-	{stepper_type_t::taylor_4, "taylor_4"},
-	{stepper_type_t::taylor_5, "taylor_5"},
-	{stepper_type_t::taylor_6, "taylor_6"},
-	{stepper_type_t::taylor_7, "taylor_7"},
-	{stepper_type_t::taylor_8, "taylor_8"},
-	{stepper_type_t::taylor_9, "taylor_9"}
+#define NOMA_NUM_STEPPER_TYPE_NAME(name, ...) { stepper_type_t::name, #name },
+	NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_NAME)
+#undef NOMA_NUM_STEPPER_TYPE_NAME
 };
 
 std::ostream& operator<<(std::ostream& out, const stepper_type_t& t);
-std::istream& operator>>(std::istream& in, stepper_type_t& t);
+std::istream& operator>>(std::istream& in, stepper_type_t& t); // NOTE: rejects invalid combinations, e.g. subdiagonal accumulation of a non-subdiagonal method
 
 /**
  * Conversion from value to type.
@@ -93,103 +126,14 @@ struct stepper_type_to_type
 	// undefined, compile error
 };
 
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::rk_euler>
-{
-	using type = rk_stepper<ODE, num::rk_method_t::euler, num::accumulate_method::separated>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::rk_midpoint>
-{
-	using type = rk_stepper<ODE, num::rk_method_t::midpoint, num::accumulate_method::separated>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::rk_rk4>
-{
-	using type = rk_stepper<ODE, num::rk_method_t::rk4, num::accumulate_method::separated>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::rk_fehlberg54>
-{
-	using type = rk_stepper<ODE, num::rk_method_t::fehlberg54, num::accumulate_method::separated>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::rk_dopri54>
-{
-	using type = rk_stepper<ODE, num::rk_method_t::dopri54, num::accumulate_method::separated>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::rk_cashkarp54>
-{
-	using type = rk_stepper<ODE, num::rk_method_t::cashkarp54, num::accumulate_method::separated>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::rk_bosha32>
-{
-	using type = rk_stepper<ODE, num::rk_method_t::bosha32, num::accumulate_method::separated>;
-};
-
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_1>
-{
-	using type = taylor_stepper<ODE, 1>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_2>
-{
-	using type = taylor_stepper<ODE, 2>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_3>
-{
-	using type = taylor_stepper<ODE, 3>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_4>
-{
-	using type = taylor_stepper<ODE, 4>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_5>
-{
-	using type = taylor_stepper<ODE, 5>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_6>
-{
-	using type = taylor_stepper<ODE, 6>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_7>
-{
-	using type = taylor_stepper<ODE, 7>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_8>
-{
-	using type = taylor_stepper<ODE, 8>;
-};
-
-template<typename ODE>
-struct stepper_type_to_type<ODE, stepper_type_t::taylor_9>
-{
-	using type = taylor_stepper<ODE, 9>;
-};
-
+#define NOMA_NUM_STEPPER_TYPE_TO_TYPE(name, stepper, ...) \
+	template<typename ODE> \
+	struct stepper_type_to_type<ODE, stepper_type_t::name> \
+	{ \
+		using type = stepper<ODE, __VA_ARGS__>; \
+	};
+NOMA_NUM_STEPPER_TYPES(NOMA_NUM_STEPPER_TYPE_TO_TYPE)
+#undef NOMA_NUM_STEPPER_TYPE_TO_TYPE
 
 } // namespace num
 } // namespace noma
@@ -0,0 +1,99 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_streaming_integrator_hpp
+#define noma_num_streaming_integrator_hpp
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/polymorphic_stepper.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * ODE and stepper for one chunk of an ensemble, i.e. compiled for
+ * NUM_MATRICES = number of matrices in the chunk.
+ */
+struct chunk_stepper
+{
+	std::shared_ptr<void> ode; // NOTE: type-erased owner, keeps the ODE alive as long as the stepper
+	std::unique_ptr<polymorphic_stepper> stepper;
+};
+
+// creates the chunk_stepper for num_matrices matrices on ocl, the stepper must use ocl's command queue
+using chunk_stepper_factory = std::function<chunk_stepper(ocl::helper& ocl, size_t num_matrices)>;
+
+/**
+ * Integrates ensembles that do not fit into device memory, by streaming them
+ * in chunks through the device.
+ *
+ * The states are read from, and written back to, a memory-mapped binary
+ * file, that contains num_matrices consecutive states of matrix_size_byte
+ * each. Chunks cycle through three device buffer slots, such that the upload
+ * of chunk c + 1, the integration of chunk c, and the download of chunk c - 1
+ * are in flight at the same time:
+ * - upload and download are enqueued on two additional command queues,
+ * - the integration uses the command queue of ocl, as the steppers do,
+ * - the queues are synchronised by events only.
+ *
+ * The factory is called once for the chunk size, and once more if the last
+ * chunk is smaller, as NUM_MATRICES is a compile-time constant of the kernels.
+ */
+class streaming_integrator
+{
+public:
+	streaming_integrator(ocl::helper& ocl, size_t num_matrices, size_t matrix_size_byte, size_t chunk_matrices, chunk_stepper_factory factory);
+
+	// integrates num_steps steps of step_size from time, reads and writes the states in place
+	void run(const boost::filesystem::path& file, real_t time, real_t step_size, size_t num_steps, size_t offset_byte = 0);
+	// same as above, but writes the results to output_file, which is created or resized as needed
+	void run(const boost::filesystem::path& input_file, const boost::filesystem::path& output_file, real_t time, real_t step_size, size_t num_steps, size_t offset_byte = 0);
+
+	size_t chunk_matrices() const { return chunk_matrices_; }
+	size_t num_chunks() const { return (num_matrices_ + chunk_matrices_ - 1) / chunk_matrices_; }
+
+	/**
+	 * Largest chunk size whose three buffer slots, plus stepper_temporaries
+	 * state-sized stepper buffers, fit into memory_fraction of the device's
+	 * global memory, and whose states fit into a single allocation.
+	 */
+	static size_t max_chunk_matrices(ocl::helper& ocl, size_t matrix_size_byte, size_t stepper_temporaries, double memory_fraction = 0.8);
+
+private:
+	struct slot {
+		cl::Buffer in;
+		cl::Buffer out;
+	};
+
+	void stream(const char* input, char* output, real_t time, real_t step_size, size_t num_steps);
+	chunk_stepper& stepper_for(size_t matrices);
+
+	ocl::helper& ocl_;
+
+	const size_t num_matrices_;
+	const size_t matrix_size_byte_;
+	const size_t chunk_matrices_;
+	chunk_stepper_factory factory_;
+
+	cl::CommandQueue upload_queue_;
+	cl::CommandQueue download_queue_;
+
+	std::vector<slot> slots_;
+	chunk_stepper full_chunk_stepper_;
+	chunk_stepper last_chunk_stepper_; // only used if num_matrices is not a multiple of chunk_matrices
+
+	static constexpr size_t num_slots_ = 3;
+};
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_streaming_integrator_hpp
@@ -9,6 +9,9 @@
 
 #include <noma/ocl/helper.hpp>
 
+#include "noma/num/buffer_pool.hpp"
+#include "noma/num/stepper_cost.hpp"
+
 namespace noma {
 namespace num {
 
@@ -35,39 +38,53 @@ public:
 
 	static constexpr accumulate_method acc_method = accumulate_method::integrated;
 
-	taylor_stepper(ocl::helper& ocl, ODE_T& ode);
+	// NOTE: if pool is set, both temporary buffers are taken from it (see buffer_pool.hpp)
+	taylor_stepper(ocl::helper& ocl, ODE_T& ode, buffer_pool* pool = nullptr);
 
 	// to fullfill the same 'concept' as rk_stepper.hpp, even though this stepper does not have its own OpenCL kernel
-	taylor_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode)
-		: taylor_stepper(ocl, ode) { };
+	taylor_stepper(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: taylor_stepper(ocl, ode, pool) { };
 	taylor_stepper(ocl::helper& ocl, const std::string& kernel_source, const std::string& kernel_name,
-	               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode)
-		: taylor_stepper(ocl, ode) { };
+	               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: taylor_stepper(ocl, ode, pool) { };
 	taylor_stepper(ocl::helper& ocl, const boost::filesystem::path& file_name, const std::string& kernel_name,
-	               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode)
-		: taylor_stepper(ocl, ode) { };
+	               const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, ODE_T& ode, buffer_pool* pool = nullptr)
+		: taylor_stepper(ocl, ode, pool) { };
 
 	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out);
 
+	// in-place step, d_mem holds y_n before, and y_(n+1) afterwards, through a spare buffer (see buffer_pool.hpp)
+	real_t step(real_t time, real_t step_size, cl::Buffer& d_mem);
+
 	// generate OpenCL compile options for ODE implementation
 	static void ode_compile_options(std::ostream& os); // NOTE: needs to be static, as this is needed for ODE construction, which typically happens before stepper construction
 
+	// cost and memory model of step(), see stepper_cost.hpp
+	static stepper_cost cost(size_t buffer_size_byte);
+
+	// nominal order of the method, iff the WARNING above holds
+	static size_t order() { return ORDER; }
+
 private:
 	void initialise();
 
 	ODE_T& ode_;
 
 	// OpenCL buffers
+	spare_buffer spare_; // y_(n+1) of the in-place step(), copied back into d_mem
 	cl::Buffer tmp_buffer_a_;
 	cl::Buffer tmp_buffer_b_;
 };
 
 template<typename ODE_T, size_t ORDER>
-taylor_stepper<ODE_T, ORDER>::taylor_stepper(ocl::helper& ocl, ODE_T& ode)
+taylor_stepper<ODE_T, ORDER>::taylor_stepper(ocl::helper& ocl, ODE_T& ode, buffer_pool* pool)
 	: kernel_wrapper(ocl), ode_(ode) // NOTE: dummy initialisation of kernel_wrapper
 {
-	tmp_buffer_a_ = ocl_.create_buffer(CL_MEM_READ_WRITE, ode.buffer_size_byte(), nullptr);
-	tmp_buffer_b_ = ocl_.create_buffer(CL_MEM_READ_WRITE, ode.buffer_size_byte(), nullptr);
+	if (pool)
+		pool->begin_group();
+
+	tmp_buffer_a_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
+	tmp_buffer_b_ = create_temporary_buffer(ocl_, pool, ode.buffer_size_byte());
 }
 
 template<typename ODE_T, size_t ORDER>
@@ -76,6 +93,21 @@ void taylor_stepper<ODE_T, ORDER>::ode_compile_options(std::ostream& os)
 	os << "#define NOMA_NUM_ODE_ACCUMULATE" << "\n";
 }
 
+template<typename ODE_T, size_t ORDER>
+stepper_cost taylor_stepper<ODE_T, ORDER>::cost(size_t buffer_size_byte)
+{
+	stepper_cost c;
+	c.ode_evaluations = ORDER;
+	// every ODE evaluation reads the last term and writes the next one, and accumulates into d_mem_out,
+	// which is initialised from the input by the first evaluation
+	c.read_byte = ORDER * buffer_size_byte + (ORDER - 1) * buffer_size_byte;
+	c.written_byte = 2 * ORDER * buffer_size_byte;
+	c.temporary_buffers = 2;
+	c.temporary_byte = 2 * buffer_size_byte;
+	c.spare_byte = buffer_size_byte;
+	return c;
+}
+
 template<typename ODE_T, size_t ORDER>
 real_t taylor_stepper<ODE_T, ORDER>::step(real_t time, real_t step_size, cl::Buffer& d_mem_in, cl::Buffer& d_mem_out)
 {
@@ -118,6 +150,14 @@ real_t taylor_stepper<ODE_T, ORDER>::step(real_t time, real_t step_size, cl::Buf
 	return 0.0;
 }
 
+template<typename ODE_T, size_t ORDER>
+real_t taylor_stepper<ODE_T, ORDER>::step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	const real_t result = step(time, step_size, d_mem, spare_.get(ocl_, ode_.buffer_size_byte()));
+	spare_.copy_to(ocl_, d_mem);
+	return result;
+}
+
 } // namespace num
 } // namespace noma
 
@@ -0,0 +1,185 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#ifndef noma_num_work_precision_hpp
+#define noma_num_work_precision_hpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/make_stepper.hpp"
+#include "noma/num/meta_stepper.hpp"
+#include "noma/num/stepper_type.hpp"
+#include "noma/num/types.hpp"
+
+namespace noma {
+namespace num {
+
+/**
+ * One measurement of work_precision(): integration over a fixed time
+ * interval with a fixed number of steps.
+ */
+struct work_precision_point
+{
+	stepper_type_t stepper_type;
+	std::string stepper_name; // replaces stepper_type in the output if set, for steppers without one, e.g. imex_stepper
+	size_t order = 0; // nominal order of the stepper type
+	size_t steps = 0;
+	real_t step_size = 0.0;
+	size_t ode_evaluations = 0; // total, from the stepper's cost()
+	double seconds = 0.0; // wall-clock time of all steps
+	long_real_t error = 0.0; // max. absolute error of all state elements at the final time
+};
+
+// CSV output, one line per point, without line break
+void write_work_precision_csv_header(std::ostream& out);
+std::ostream& operator<<(std::ostream& out, const work_precision_point& point);
+
+/**
+ * Observed convergence order, i.e. least squares slope of log(error) over
+ * log(step_size), of the points with an error in (error_floor, error_ceiling).
+ * The floor excludes points dominated by round-off, the ceiling points
+ * outside the asymptotic regime. Returns 0.0 for less than two such points.
+ */
+real_t observed_order(const std::vector<work_precision_point>& points, long_real_t error_floor, long_real_t error_ceiling = 1.0e-1);
+
+// exact solution at time, with long_real_t precision
+using reference_solution = std::function<std::vector<long_complex_t>(real_t time)>;
+
+/**
+ * Reference problem with an analytic solution: Rabi oscillations, i.e. the
+ * von Neumann equation (see commutator_ode) of a driven two-level system
+ *
+ * h = 1/2 * (detuning * sigma_z + rabi_frequency * sigma_x)
+ *
+ * for num_matrices pure initial states, spread over the Bloch sphere.
+ *
+ * Optionally with dephasing, i.e. decay of the off-diagonal elements with
+ * dephasing_rate, as split implicit part of commutator_ode (see
+ * commutator_ode::decay() and decay_rates()).
+ */
+class rabi_problem
+{
+public:
+	rabi_problem(size_t num_matrices, real_t detuning, real_t rabi_frequency, real_t dephasing_rate = 0.0);
+
+	const std::vector<complex_t>& hamiltonian() const { return hamiltonian_; } // 2 x 2, row-major
+	const std::vector<complex_t>& decay_rates() const { return decay_rates_; } // 2 x 2, row-major
+	const std::vector<complex_t>& initial_state() const { return initial_state_; }
+	// sigma(t) = U(t) * sigma(0) * U(t)^H, with U(t) = exp(-i * h * t), or the solution of the Bloch equations with dephasing
+	std::vector<long_complex_t> solution(real_t time) const;
+
+private:
+	std::vector<long_complex_t> dephased_solution(real_t time) const;
+
+	const size_t num_matrices_;
+	const long_real_t detuning_;
+	const long_real_t rabi_frequency_;
+	const long_real_t dephasing_rate_;
+
+	std::vector<complex_t> hamiltonian_;
+	std::vector<complex_t> decay_rates_;
+	std::vector<complex_t> initial_state_;
+};
+
+// creates an ODE for the complete source_header, range, and the accumulate method of the stepper type, see work_precision()
+template<typename ODE>
+using work_precision_ode_factory = std::function<std::unique_ptr<ODE>(const std::string& source_header, const ocl::nd_range& range, accumulate_method acc_method)>;
+
+/**
+ * Work-precision measurement of an already constructed stepper, e.g. one that
+ * is not a runtime configurable stepper type, such as imex_stepper: integrates
+ * initial_state from time 0 to end_time with each of the passed step counts,
+ * and compares the result against the reference solution.
+ *
+ * STEPPER must provide the in-place step(), and cost(). order is the nominal
+ * order of the stepper. The points' stepper_type is not set, see stepper_name.
+ */
+template<typename STEPPER>
+std::vector<work_precision_point> work_precision(STEPPER& stepper, const std::string& stepper_name, size_t order, ocl::helper& ocl, size_t buffer_size_byte,
+                                                 const std::vector<complex_t>& initial_state, const reference_solution& reference, real_t end_time, const std::vector<size_t>& step_counts)
+{
+	const size_t size_byte = initial_state.size() * sizeof(complex_t);
+	if (size_byte != buffer_size_byte)
+		throw std::runtime_error("work_precision(): error: state size does not match the ODE's buffer size");
+
+	const std::vector<long_complex_t> exact = reference(end_time);
+	if (exact.size() != initial_state.size())
+		throw std::runtime_error("work_precision(): error: reference solution size does not match the state size");
+
+	cl::Buffer d_mem = ocl.create_buffer(CL_MEM_READ_WRITE, size_byte, nullptr);
+	std::vector<complex_t> state(initial_state.size());
+
+	std::vector<work_precision_point> points;
+	for (size_t steps : step_counts) {
+		work_precision_point point;
+		point.stepper_name = stepper_name;
+		point.order = order;
+		point.steps = steps;
+		point.step_size = end_time / static_cast<real_t>(steps);
+		point.ode_evaluations = steps * stepper.cost(size_byte).ode_evaluations;
+
+		cl_int err = ocl.command_queue().enqueueWriteBuffer(d_mem, CL_TRUE, 0, size_byte, initial_state.data());
+		ocl::error_handler(err, "clEnqueueWriteBuffer(d_mem)");
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < steps; ++i)
+			stepper.step(static_cast<real_t>(i) * point.step_size, point.step_size, d_mem);
+		ocl.command_queue().finish();
+		const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		point.seconds = elapsed.count();
+
+		err = ocl.command_queue().enqueueReadBuffer(d_mem, CL_TRUE, 0, size_byte, state.data());
+		ocl::error_handler(err, "clEnqueueReadBuffer(d_mem)");
+
+		for (size_t i = 0; i < state.size(); ++i)
+			point.error = std::max(point.error, std::abs(long_complex_t(state[i]) - exact[i]));
+
+		points.push_back(point);
+	}
+
+	return points;
+}
+
+/**
+ * Work-precision measurement of stepper_type, as above.
+ *
+ * The factory is called with the complete source header, i.e. including the
+ * stepper's ODE compile options, and the accumulate method of stepper_type
+ * (see make_stepper_acc_method()), as for autotune().
+ */
+template<typename ODE>
+std::vector<work_precision_point> work_precision(stepper_type_t stepper_type, ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+                                                 const work_precision_ode_factory<ODE>& factory,
+                                                 const std::vector<complex_t>& initial_state, const reference_solution& reference, real_t end_time, const std::vector<size_t>& step_counts)
+{
+	std::stringstream header;
+	make_stepper_ode_compile_option<ODE, meta_stepper>(stepper_type, header);
+	header << source_header;
+
+	std::unique_ptr<ODE> ode = factory(header.str(), range, make_stepper_acc_method<ODE, meta_stepper>(stepper_type));
+	meta_stepper stepper(stepper_type, ocl, header.str(), ocl_compile_options, range, *ode);
+
+	std::vector<work_precision_point> points = work_precision(stepper, "", make_stepper_order<ODE, meta_stepper>(stepper_type), ocl, ode->buffer_size_byte(),
+	                                                          initial_state, reference, end_time, step_counts);
+	for (auto& point : points)
+		point.stepper_type = stepper_type;
+
+	return points;
+}
+
+} // namespace num
+} // namespace noma
+
+#endif // noma_num_work_precision_hpp
@@ -0,0 +1,114 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/autotuner.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace noma {
+namespace num {
+
+std::ostream& operator<<(std::ostream& out, const tuning_config& config)
+{
+	out << config.stepper_type << " local_size=" << config.local_size << " VEC_LENGTH=" << config.vec_length;
+	return out;
+}
+
+tuning_cache::tuning_cache(const boost::filesystem::path& file_name)
+	: file_name_(file_name)
+{
+	std::ifstream file(file_name_.string());
+	if (!file)
+		return; // NOTE: no cache yet
+
+	// format: one entry per line, key <tab> stepper_type <tab> local_size <tab> vec_length
+	std::string line;
+	while (std::getline(file, line)) {
+		std::stringstream ss(line);
+		std::string key, type_name, local_size, vec_length;
+		if (!std::getline(ss, key, '\t') || !std::getline(ss, type_name, '\t') || !std::getline(ss, local_size, '\t') || !std::getline(ss, vec_length))
+			continue; // skip malformed lines
+
+		tuning_config config;
+		std::stringstream type_ss(type_name);
+		try {
+			type_ss >> config.stepper_type;
+			config.local_size = std::stoul(local_size);
+			config.vec_length = std::stoul(vec_length);
+		} catch (const std::exception&) {
+			continue; // skip entries that do not parse anymore, e.g. of removed stepper types
+		}
+		entries_[key] = config;
+	}
+}
+
+bool tuning_cache::lookup(const std::string& key, tuning_config& config) const
+{
+	auto it = entries_.find(key);
+	if (it == entries_.end())
+		return false;
+
+	config = it->second;
+	return true;
+}
+
+void tuning_cache::store(const std::string& key, const tuning_config& config)
+{
+	entries_[key] = config;
+	save();
+}
+
+void tuning_cache::save() const
+{
+	std::ofstream file(file_name_.string(), std::ios::trunc);
+	if (!file)
+		throw std::runtime_error("tuning_cache::save(): error: cannot write '" + file_name_.string() + "'");
+
+	for (const auto& entry : entries_)
+		file << entry.first << '\t' << entry.second.stepper_type << '\t' << entry.second.local_size << '\t' << entry.second.vec_length << '\n';
+}
+
+std::string tuning_cache::make_key(ocl::helper& ocl, size_t num_matrices, size_t num_states, stepper_type_t stepper_type)
+{
+	std::string device_name, device_vendor, driver_version;
+	ocl.device().getInfo(CL_DEVICE_NAME, &device_name);
+	ocl.device().getInfo(CL_DEVICE_VENDOR, &device_vendor);
+	ocl.device().getInfo(CL_DRIVER_VERSION, &driver_version);
+
+	std::stringstream key;
+	key << device_vendor << " " << device_name << " (" << driver_version << ")"
+	    << " NUM_MATRICES=" << num_matrices << " NUM_STATES=" << num_states
+	    << " " << stepper_type;
+
+	std::string result = key.str();
+	std::replace(result.begin(), result.end(), '\t', ' '); // NOTE: tab is the field separator
+	std::replace(result.begin(), result.end(), '\n', ' ');
+	return result;
+}
+
+std::vector<stepper_type_t> accumulate_variants(stepper_type_t stepper_type)
+{
+	// NOTE: relies on the naming scheme of the registry, see NOMA_NUM_STEPPER_TYPES
+	const std::vector<std::string> suffixes { "_integrated", "_subdiagonal", "_fused" };
+
+	std::string base = stepper_type_names.at(stepper_type);
+	for (const auto& suffix : suffixes)
+		if (base.size() > suffix.size() && base.compare(base.size() - suffix.size(), suffix.size(), suffix) == 0)
+			base = base.substr(0, base.size() - suffix.size());
+
+	std::vector<stepper_type_t> variants;
+	for (const auto& entry : stepper_type_names) {
+		if (entry.second == base)
+			variants.push_back(entry.first);
+		for (const auto& suffix : suffixes)
+			if (entry.second == base + suffix)
+				variants.push_back(entry.first);
+	}
+
+	return variants;
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,64 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/bessel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace noma {
+namespace num {
+
+std::vector<long_real_t> bessel_j_sequence(long_real_t z, size_t n)
+{
+	if (z < 0.0)
+		throw std::runtime_error("bessel_j_sequence(): error: negative argument.");
+
+	std::vector<long_real_t> result(n + 1, 0.0);
+
+	if (z == 0.0) {
+		result[0] = 1.0;
+		return result;
+	}
+
+	// even start index well above n and z, where J_m(z) is negligible
+	const size_t k_max = std::max(n, static_cast<size_t>(std::ceil(z)));
+	size_t m = k_max + 16 + static_cast<size_t>(std::sqrt(40.0 * k_max));
+	m += m % 2;
+
+	const long_real_t rescale_threshold = 1.0e250;
+
+	long_real_t j_next = 0.0;   // J_(k+1)
+	long_real_t j = 1.0e-30;    // J_k, arbitrary non-zero start value
+	long_real_t norm = 2.0 * j; // J_0 + 2 * sum(k) J_2k, m is even
+
+	for (size_t k = m; k > 0; --k) {
+		const long_real_t j_prev = (2.0 * k / z) * j - j_next; // J_(k-1)
+		j_next = j;
+		j = j_prev;
+
+		if (k - 1 <= n)
+			result[k - 1] = j;
+
+		norm += ((k - 1) == 0) ? j : (((k - 1) % 2 == 0) ? 2.0 * j : 0.0);
+
+		// avoid overflow, everything computed so far is scaled consistently
+		if (std::abs(j) > rescale_threshold) {
+			j /= rescale_threshold;
+			j_next /= rescale_threshold;
+			norm /= rescale_threshold;
+			for (size_t i = k - 1; i <= n; ++i)
+				result[i] /= rescale_threshold;
+		}
+	}
+
+	for (auto& x : result)
+		x /= norm;
+
+	return result;
+}
+
+} // namespace num
+} // namespace noma
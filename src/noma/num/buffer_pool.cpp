@@ -0,0 +1,80 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/buffer_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace noma {
+namespace num {
+
+buffer_pool::buffer_pool(ocl::helper& ocl, size_t capacity_byte)
+	: ocl_(ocl), capacity_(capacity_byte)
+{
+	// CL_DEVICE_MEM_BASE_ADDR_ALIGN is given in bits
+	alignment_ = ocl_.device().getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8;
+	alignment_ = std::max(alignment_, static_cast<size_t>(1));
+
+	buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, capacity_, nullptr);
+}
+
+void buffer_pool::begin_group()
+{
+	offset_ = 0;
+}
+
+cl::Buffer buffer_pool::allocate(size_t size_byte)
+{
+	// round origin up to the next multiple of the alignment
+	const size_t origin = ((offset_ + alignment_ - 1) / alignment_) * alignment_;
+	const size_t end = origin + size_byte;
+
+	high_water_mark_ = std::max(high_water_mark_, end);
+
+	if (end > capacity_)
+		throw std::runtime_error("buffer_pool::allocate(): error: capacity of " + std::to_string(capacity_) + " byte exceeded, at least " + std::to_string(high_water_mark_) + " byte are needed.");
+
+	cl_buffer_region region { origin, size_byte };
+	cl_int err = 0;
+	cl::Buffer result = buffer_.createSubBuffer(CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+	ocl::error_handler(err, "clCreateSubBuffer()");
+
+	offset_ = end;
+
+	return result;
+}
+
+cl::Buffer create_temporary_buffer(ocl::helper& ocl, buffer_pool* pool, size_t size_byte)
+{
+	if (pool)
+		return pool->allocate(size_byte);
+	else
+		return ocl.create_buffer(CL_MEM_READ_WRITE, size_byte, nullptr);
+}
+
+cl::Buffer& spare_buffer::get(ocl::helper& ocl, size_t size_byte)
+{
+	if (size_byte_ != size_byte) {
+		buffer_ = ocl.create_buffer(CL_MEM_READ_WRITE, size_byte, nullptr);
+		size_byte_ = size_byte;
+	}
+	return buffer_;
+}
+
+void spare_buffer::swap(cl::Buffer& d_mem)
+{
+	std::swap(buffer_, d_mem);
+}
+
+void spare_buffer::copy_to(ocl::helper& ocl, cl::Buffer& d_mem)
+{
+	cl_int err = ocl.command_queue().enqueueCopyBuffer(buffer_, d_mem, 0, 0, size_byte_);
+	ocl::error_handler(err, "clEnqueueCopyBuffer(d_mem)");
+}
+
+} // namespace num
+} // namespace noma
@@ -4,6 +4,14 @@
 
 #include "noma/num/butcher_tableau.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <noma/typa/parser_error.hpp>
+
 namespace noma {
 namespace num {
 
@@ -29,5 +37,265 @@ const butcher_tableau& get_butcher_tableau(const rk_method_t rkm)
 	}
 }
 
+bool is_subdiagonal(const butcher_tableau& b_tab)
+{
+	if (b_tab.a.size() < 2)
+		return false;
+
+	for (size_t i = 0; i < b_tab.a.size(); ++i)
+		for (size_t j = 0; j < b_tab.a[i].size(); ++j)
+			if (j + 1 != i && b_tab.a[i][j] != 0.0)
+				return false;
+
+	return true;
+}
+
+namespace {
+
+using long_vector_t = std::vector<long_real_t>;
+
+// a * v
+long_vector_t a_times(const butcher_tableau::a_coeffs_t& a, const long_vector_t& v)
+{
+	long_vector_t result(a.size(), 0.0);
+	for (size_t i = 0; i < a.size(); ++i)
+		for (size_t j = 0; j < a[i].size(); ++j)
+			result[i] += a[i][j] * v[j];
+	return result;
+}
+
+// element-wise product
+long_vector_t times(const long_vector_t& u, const long_vector_t& v)
+{
+	long_vector_t result(u.size());
+	for (size_t i = 0; i < u.size(); ++i)
+		result[i] = u[i] * v[i];
+	return result;
+}
+
+std::string trim(const std::string& s)
+{
+	const size_t first = s.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos)
+		return std::string();
+	return s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+// white space separated list of decimal numbers or fractions p/q
+std::vector<real_t> parse_coefficients(const std::string& text)
+{
+	std::vector<real_t> result;
+	std::istringstream in(text);
+	std::string token;
+	while (in >> token) {
+		const size_t slash = token.find('/');
+		const std::string parts[] = { token.substr(0, slash), (slash == std::string::npos) ? std::string("1") : token.substr(slash + 1) };
+		long_real_t values[2];
+		for (size_t l = 0; l < 2; ++l) {
+			std::istringstream part(parts[l]);
+			if (!(part >> values[l]) || !(part >> std::ws).eof())
+				throw noma::typa::parser_error("'" + token + "' is not a valid Butcher tableau coefficient.");
+		}
+		if (values[1] == 0.0)
+			throw noma::typa::parser_error("'" + token + "' is a division by zero.");
+		result.push_back(static_cast<real_t>(values[0] / values[1]));
+	}
+	return result;
+}
+
+void write_coefficients(std::ostream& out, const std::vector<real_t>& coeffs)
+{
+	for (size_t j = 0; j < coeffs.size(); ++j)
+		out << (j > 0 ? " " : "") << coeffs[j];
+}
+
+} // namespace
+
+size_t tableau_order(const butcher_tableau& b_tab, const butcher_tableau::b_coeffs_t& b, real_t tolerance)
+{
+	const long_vector_t one(b.size(), 1.0);
+	const long_vector_t c(b_tab.c.begin(), b_tab.c.end());
+	const long_vector_t c2 = times(c, c);
+	const long_vector_t c3 = times(c2, c);
+	const long_vector_t ac = a_times(b_tab.a, c);
+	const long_vector_t ac2 = a_times(b_tab.a, c2);
+	const long_vector_t aac = a_times(b_tab.a, ac);
+
+	// elementary weight vector v and 1 / gamma of every rooted tree, i.e. the condition sum(i)(b_i * v_i) = 1 / gamma
+	// J.C. Butcher, Numerical Methods for Ordinary Differential Equations, 2nd ed., Wiley (2008), table 318(I)
+	struct condition { long_vector_t v; long_real_t gamma; };
+	const std::vector<std::vector<condition>> conditions {
+		{ { one, 1.0 } },
+		{ { c, 2.0 } },
+		{ { c2, 3.0 }, { ac, 6.0 } },
+		{ { c3, 4.0 }, { times(c, ac), 8.0 }, { ac2, 12.0 }, { aac, 24.0 } },
+		{ { times(c3, c), 5.0 }, { times(c2, ac), 10.0 }, { times(c, ac2), 15.0 }, { times(c, aac), 30.0 }, { times(ac, ac), 20.0 },
+		  { a_times(b_tab.a, c3), 20.0 }, { a_times(b_tab.a, times(c, ac)), 40.0 }, { a_times(b_tab.a, ac2), 60.0 }, { a_times(b_tab.a, aac), 120.0 } }
+	};
+
+	size_t order = 0;
+	for (const std::vector<condition>& trees : conditions) {
+		for (const condition& tree : trees) {
+			long_real_t sum = 0.0;
+			for (size_t i = 0; i < b.size(); ++i)
+				sum += b[i] * tree.v[i];
+			if (std::abs(sum - 1.0 / tree.gamma) > tolerance)
+				return order;
+		}
+		++order;
+	}
+	return order;
+}
+
+tableau_structure analyse_butcher_tableau(const butcher_tableau& b_tab, real_t tolerance)
+{
+	const size_t stages = b_tab.a.size();
+	if (stages == 0 || b_tab.b.size() != stages || b_tab.c.size() != stages || (!b_tab.b_cmp.empty() && b_tab.b_cmp.size() != stages))
+		throw std::runtime_error("analyse_butcher_tableau(): error: a, b, b_cmp, and c must have one entry per stage.");
+
+	tableau_structure result;
+	result.stages = stages;
+	result.zero_row.resize(stages, true);
+	result.unused.resize(stages, false);
+
+	for (size_t i = 0; i < stages; ++i) {
+		if (b_tab.a[i].size() != stages)
+			throw std::runtime_error("analyse_butcher_tableau(): error: a must be a square matrix.");
+
+		long_real_t row_sum = 0.0;
+		size_t terms = 0;
+		for (size_t j = 0; j < stages; ++j) {
+			if (b_tab.a[i][j] == 0.0)
+				continue;
+			if (j >= i)
+				throw std::runtime_error("analyse_butcher_tableau(): error: only explicit methods are supported, i.e. a must be strictly lower triangular.");
+			row_sum += b_tab.a[i][j];
+			result.zero_row[i] = false;
+			++terms;
+		}
+		if (std::abs(row_sum - b_tab.c[i]) > tolerance)
+			throw std::runtime_error("analyse_butcher_tableau(): error: c_" + std::to_string(i) + " is not the row sum of a.");
+		result.max_terms = std::max(result.max_terms, terms);
+	}
+	result.max_terms = std::max(result.max_terms, static_cast<size_t>(std::count_if(b_tab.b.begin(), b_tab.b.end(), [](real_t coeff) { return coeff != 0.0; })));
+
+	result.order = tableau_order(b_tab, b_tab.b, tolerance);
+	if (result.order == 0)
+		throw std::runtime_error("analyse_butcher_tableau(): error: b is not consistent, i.e. sum(b) is not one.");
+
+	result.embedded = !b_tab.b_cmp.empty();
+	if (result.embedded)
+		result.embedded_order = tableau_order(b_tab, b_tab.b_cmp, tolerance);
+
+	result.subdiagonal = is_subdiagonal(b_tab);
+
+	result.fsal = stages > 1 && b_tab.c.back() == 1.0;
+	for (size_t j = 0; j < stages && result.fsal; ++j)
+		result.fsal = std::abs(b_tab.a.back()[j] - b_tab.b[j]) <= tolerance;
+
+	// backwards, since a stage is only used if it is used by b, or by a later used stage
+	// NOTE: the first stage is always evaluated, since it initialises the accumulation of the result
+	for (size_t j = stages; j-- > 1; ) {
+		bool used = (b_tab.b[j] != 0.0);
+		for (size_t i = j + 1; i < stages && !used; ++i)
+			used = !result.unused[i] && b_tab.a[i][j] != 0.0;
+		result.unused[j] = !used;
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const butcher_tableau& b_tab)
+{
+	const std::streamsize precision = out.precision(std::numeric_limits<real_t>::max_digits10);
+
+	out << "a = ";
+	for (size_t i = 0; i < b_tab.a.size(); ++i) {
+		out << (i > 0 ? "; " : "");
+		write_coefficients(out, b_tab.a[i]);
+	}
+	out << " | b = ";
+	write_coefficients(out, b_tab.b);
+	if (!b_tab.b_cmp.empty()) {
+		out << " | b_cmp = ";
+		write_coefficients(out, b_tab.b_cmp);
+	}
+	out << " | c = ";
+	write_coefficients(out, b_tab.c);
+
+	out.precision(precision);
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, butcher_tableau& b_tab)
+{
+	// split into sections at new lines and '|', without comments
+	std::vector<std::string> sections;
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream line_stream(line.substr(0, line.find('#')));
+		std::string section;
+		while (std::getline(line_stream, section, '|'))
+			if (!trim(section).empty())
+				sections.push_back(trim(section));
+	}
+
+	butcher_tableau result;
+	std::vector<std::string> keys;
+	for (const std::string& section : sections) {
+		const size_t equals = section.find('=');
+		if (equals == std::string::npos)
+			throw noma::typa::parser_error("'" + section + "' is not a 'key = coefficients' section of a Butcher tableau.");
+
+		const std::string key = trim(section.substr(0, equals));
+		const std::string value = section.substr(equals + 1);
+		if (std::find(keys.begin(), keys.end(), key) != keys.end())
+			throw noma::typa::parser_error("'" + key + "' is set twice in a Butcher tableau.");
+		keys.push_back(key);
+
+		if (key == "a") {
+			std::istringstream rows(value);
+			std::string row;
+			while (std::getline(rows, row, ';'))
+				result.a.push_back(parse_coefficients(row));
+		} else if (key == "b") {
+			result.b = parse_coefficients(value);
+		} else if (key == "b_cmp") {
+			result.b_cmp = parse_coefficients(value);
+		} else if (key == "c") {
+			result.c = parse_coefficients(value);
+		} else {
+			throw noma::typa::parser_error("'" + key + "' is not a valid Butcher tableau key, i.e. a, b, b_cmp, or c.");
+		}
+	}
+
+	if (result.a.empty() || result.b.empty())
+		throw noma::typa::parser_error("a Butcher tableau needs at least a and b.");
+
+	// pad the rows of a with zeros, and compute c if omitted
+	const size_t stages = result.a.size();
+	const bool row_sums = result.c.empty();
+	for (size_t i = 0; i < stages; ++i) {
+		if (result.a[i].size() > stages)
+			throw noma::typa::parser_error("row " + std::to_string(i) + " of a has more coefficients than the tableau has stages.");
+		result.a[i].resize(stages, 0.0);
+		if (row_sums) {
+			long_real_t sum = 0.0;
+			for (real_t coeff : result.a[i])
+				sum += coeff;
+			result.c.push_back(static_cast<real_t>(sum));
+		}
+	}
+
+	try {
+		analyse_butcher_tableau(result);
+	} catch (const std::runtime_error& e) {
+		throw noma::typa::parser_error(std::string("invalid Butcher tableau: ") + e.what());
+	}
+
+	b_tab = result;
+	return in;
+}
+
 } // namespace num
 } // namespace noma
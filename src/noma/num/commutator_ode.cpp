@@ -0,0 +1,126 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/commutator_ode.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace noma {
+namespace num {
+
+const std::string commutator_ode::embedded_ocl_source_ {
+#include "complex_matrix.cl.hpp"  // NOTE: generated by CMake
+};
+
+commutator_ode::commutator_ode(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+                               size_t num_matrices, const std::vector<complex_t>& hamiltonian, accumulate_method acc_method,
+                               commutator_variant variant, complex_t alpha, bool packed)
+	: ocl_(ocl), acc_method_(acc_method),
+	  kernel_(ocl, embedded_ocl_source_, packed ? "complex_matrix_commutator_packed" : "complex_matrix_commutator",
+	          accumulate_defines(acc_method) + source_header, ocl_compile_options, range),
+	  num_matrices_(num_matrices),
+	  num_states_(static_cast<size_t>(std::lround(std::sqrt(static_cast<double>(hamiltonian.size()))))),
+	  alpha_(alpha),
+	  sign_(variant == commutator_variant::commutator ? -1.0 : 1.0),
+	  source_header_(accumulate_defines(acc_method) + source_header), ocl_compile_options_(ocl_compile_options), range_(range), packed_(packed)
+{
+	if (packed && acc_method == accumulate_method::fused)
+		throw std::runtime_error("commutator_ode::commutator_ode(): error: accumulate_method::fused is not supported for the packed layout.");
+
+	h_buffer_ = ocl_.create_buffer(CL_MEM_READ_ONLY, num_states_ * num_states_ * sizeof(complex_t), nullptr);
+	this->hamiltonian(hamiltonian);
+}
+
+std::string commutator_ode::accumulate_defines(accumulate_method acc_method)
+{
+	std::stringstream ss;
+	accumulate_compile_options(acc_method, ss);
+	return ss.str();
+}
+
+void commutator_ode::hamiltonian(const std::vector<complex_t>& h)
+{
+	if (h.size() != num_states_ * num_states_ || h.empty())
+		throw std::runtime_error("commutator_ode::hamiltonian(): error: expected a square, non-empty matrix of unchanged size");
+
+	cl_int err = ocl_.command_queue().enqueueWriteBuffer(h_buffer_, CL_TRUE, 0, h.size() * sizeof(complex_t), h.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(h_buffer_)");
+}
+
+void commutator_ode::decay(const std::vector<complex_t>& rates)
+{
+	if (packed_)
+		throw std::runtime_error("commutator_ode::decay(): error: decay is not supported for the packed layout.");
+	if (rates.size() != num_states_ * num_states_)
+		throw std::runtime_error("commutator_ode::decay(): error: expected a num_states x num_states matrix of rates");
+
+	if (!decay_kernel_) {
+		decay_kernel_.reset(new kernel_function(ocl_, embedded_ocl_source_, "complex_matrix_decay", source_header_, ocl_compile_options_, range_));
+		rates_buffer_ = ocl_.create_buffer(CL_MEM_READ_ONLY, rates.size() * sizeof(complex_t), nullptr);
+	}
+
+	cl_int err = ocl_.command_queue().enqueueWriteBuffer(rates_buffer_, CL_TRUE, 0, rates.size() * sizeof(complex_t), rates.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(rates_buffer_)");
+}
+
+void commutator_ode::solve(real_t /* time */, real_t /* time_step */, cl::Buffer& in, cl::Buffer& out, real_t /* coeff */)
+{
+	if (acc_method_ != accumulate_method::separated)
+		throw std::runtime_error("commutator_ode::solve(): error: kernel was compiled for accumulation, but called without accumulation buffer");
+
+	kernel_(out, in, h_buffer_, alpha_.real(), alpha_.imag(), sign_);
+}
+
+void commutator_ode::solve(real_t /* time */, real_t /* time_step */, cl::Buffer& in, cl::Buffer& out, cl::Buffer& acc, real_t acc_coeff, bool init)
+{
+	if (acc_method_ == accumulate_method::separated)
+		throw std::runtime_error("commutator_ode::solve(): error: kernel was compiled for accumulate_method::separated, but called with accumulation buffer");
+
+	if (init)
+		y_n_ = in;
+
+	if (acc_method_ == accumulate_method::subdiagonal) {
+		// last stage, there is no next stage input to compute
+		kernel_(out, in, h_buffer_, alpha_.real(), alpha_.imag(), sign_, acc, acc_coeff, static_cast<int_t>(init), y_n_, static_cast<real_t>(0.0), static_cast<int_t>(0));
+	} else if (acc_method_ == accumulate_method::fused) {
+		// the stage input is in itself
+		std::vector<cl::Buffer> no_ks;
+		run_with_stage_input(kernel_, stage_input(0.0, {}, no_ks, in), out, in, h_buffer_, alpha_.real(), alpha_.imag(), sign_, acc, acc_coeff, static_cast<int_t>(init));
+	} else {
+		kernel_(out, in, h_buffer_, alpha_.real(), alpha_.imag(), sign_, acc, acc_coeff, static_cast<int_t>(init));
+	}
+}
+
+void commutator_ode::solve(real_t /* time */, real_t /* time_step */, cl::Buffer& in, cl::Buffer& out, real_t next_coeff, cl::Buffer& acc, real_t acc_coeff, bool init)
+{
+	if (acc_method_ != accumulate_method::subdiagonal)
+		throw std::runtime_error("commutator_ode::solve(): error: subdiagonal call requires accumulate_method::subdiagonal");
+
+	if (init)
+		y_n_ = in;
+
+	kernel_(out, in, h_buffer_, alpha_.real(), alpha_.imag(), sign_, acc, acc_coeff, static_cast<int_t>(init), y_n_, next_coeff, static_cast<int_t>(1));
+}
+
+void commutator_ode::solve(real_t /* time */, real_t /* time_step */, cl::Buffer& y_n, real_t h, const std::vector<real_t>& stage_coeffs, std::vector<cl::Buffer>& ks,
+                           cl::Buffer& out, cl::Buffer& acc, real_t acc_coeff, bool init)
+{
+	if (acc_method_ != accumulate_method::fused)
+		throw std::runtime_error("commutator_ode::solve(): error: stage-fused call requires accumulate_method::fused");
+
+	run_with_stage_input(kernel_, stage_input(h, stage_coeffs, ks, y_n), out, y_n, h_buffer_, alpha_.real(), alpha_.imag(), sign_, acc, acc_coeff, static_cast<int_t>(init));
+}
+
+void commutator_ode::solve_implicit(real_t /* time */, real_t /* time_step */, cl::Buffer& in, cl::Buffer& out)
+{
+	if (!decay_kernel_)
+		throw std::runtime_error("commutator_ode::solve_implicit(): error: no decay rates, see decay()");
+
+	(*decay_kernel_)(out, in, rates_buffer_);
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,25 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/complex_matrix_kernels.hpp"
+
+namespace noma {
+namespace num {
+
+const std::string complex_matrix_kernels::embedded_ocl_source_ {
+#include "complex_matrix.cl.hpp"  // NOTE: generated by CMake
+};
+
+complex_matrix_kernels::complex_matrix_kernels(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range)
+	: gemm_kernel_(ocl, embedded_ocl_source_, "complex_matrix_gemm", source_header, ocl_compile_options, range)
+{
+}
+
+void complex_matrix_kernels::gemm(cl::Buffer& c, complex_t alpha, cl::Buffer& a, cl::Buffer& b, complex_t beta)
+{
+	gemm_kernel_(c, alpha.real(), alpha.imag(), a, b, beta.real(), beta.imag());
+}
+
+} // namespace num
+} // namespace noma
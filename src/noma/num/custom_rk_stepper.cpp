@@ -0,0 +1,240 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/custom_rk_stepper.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+
+namespace noma {
+namespace num {
+
+namespace {
+
+const std::string embedded_ocl_source {
+#include "custom_rk.cl.hpp"  // NOTE: generated by CMake
+};
+
+size_t count_terms(const std::vector<real_t>& coeffs)
+{
+	return std::count_if(coeffs.begin(), coeffs.end(), [](real_t coeff) { return coeff != 0.0; });
+}
+
+// out = y_n + h * sum(j)(coeffs[j] * k_j), with a kernel argument k<j> for every non-zero coefficient, see cl/custom_rk.cl
+void write_weighted_add_kernel(std::ostream& os, const std::string& name, const std::vector<real_t>& coeffs)
+{
+	const char* suffix = std::is_same<real_t, float>::value ? "f" : "";
+
+	os << "\n__kernel void " << name << "(const real_t h, __global real_t* out, __global const real_t* y_n";
+	for (size_t j = 0; j < coeffs.size(); ++j)
+		if (coeffs[j] != 0.0)
+			os << ", __global const k_real_t* restrict k" << j;
+	os << ")\n{\n";
+	os << "\tNOMA_NUM_CUSTOM_RK_FOR_EACH_ELEMENT(e)\n";
+	os << "\t\tout[e] = y_n[e] + h * (";
+	bool first = true;
+	for (size_t j = 0; j < coeffs.size(); ++j)
+		if (coeffs[j] != 0.0) {
+			os << (first ? "" : " + ") << "(" << coeffs[j] << suffix << ") * NOMA_NUM_LOAD_K(k" << j << ", e)";
+			first = false;
+		}
+	os << ");\n}\n";
+}
+
+} // namespace
+
+bool is_applicable(const butcher_tableau& b_tab, accumulate_method acc_method, k_storage storage, bool fused_ode)
+{
+	const tableau_structure structure = analyse_butcher_tableau(b_tab);
+
+	switch (acc_method) {
+		case accumulate_method::separated:
+		case accumulate_method::integrated:
+			return true;
+		case accumulate_method::subdiagonal:
+			// NOTE: the k buffers hold stage inputs, i.e. states
+			return structure.subdiagonal && storage == k_storage::full;
+		case accumulate_method::fused:
+			if (!fused_ode)
+				return false;
+			for (const std::vector<real_t>& row : b_tab.a)
+				if (count_terms(row) > stage_input::max_ks)
+					return false;
+			return true;
+		default:
+			return false;
+	}
+}
+
+custom_rk_plan make_custom_rk_plan(const butcher_tableau& b_tab, accumulate_method acc_method)
+{
+	const tableau_structure structure = analyse_butcher_tableau(b_tab);
+	const size_t stages = structure.stages;
+
+	custom_rk_plan plan;
+	plan.acc_method = acc_method;
+	plan.k_buffer.resize(stages, 0);
+
+	if (acc_method == accumulate_method::subdiagonal) {
+		if (!structure.subdiagonal)
+			throw std::runtime_error("make_custom_rk_plan(): error: accumulate_method::subdiagonal used with a non-subdiagonal Butcher tableau.");
+
+		// every stage is evaluated, and the input of stage i is in buffer (i + 1) % 2, as in rk_stepper
+		for (size_t i = 0; i < stages; ++i) {
+			plan.stages.push_back(i);
+			plan.k_buffer[i] = (i + 1) % 2;
+		}
+		plan.num_k_buffers = 2;
+		return plan;
+	}
+
+	for (size_t i = 0; i < stages; ++i)
+		if (!structure.unused[i]) {
+			plan.stages.push_back(i);
+			plan.stage_inputs = plan.stage_inputs || (i > 0 && !structure.zero_row[i]);
+		}
+
+	// last stage that reads k_j, or stages for the result of separated accumulation, at least the stage that writes it
+	std::vector<size_t> last_use(stages, 0);
+	for (size_t i : plan.stages) {
+		last_use[i] = i;
+		for (size_t j = 0; j < i; ++j)
+			if (b_tab.a[i][j] != 0.0)
+				last_use[j] = i;
+	}
+	if (acc_method == accumulate_method::separated)
+		for (size_t j = 0; j < stages; ++j)
+			if (b_tab.b[j] != 0.0)
+				last_use[j] = stages;
+
+	// greedy allocation in stage order, i.e. the minimum number of buffers, since the k's are live for intervals,
+	// the weighted add of a stage input runs before the ODE writes the stage's k, so the k buffers of its last use can be reused by it,
+	// unless the ODE kernel forms the stage input itself (fused)
+	const bool reuse_at_last_use = (acc_method != accumulate_method::fused);
+	std::vector<size_t> live; // stages with a k in a buffer
+	std::vector<size_t> free_buffers;
+	for (size_t i : plan.stages) {
+		for (auto it = live.begin(); it != live.end(); ) {
+			if (last_use[*it] < i || (reuse_at_last_use && last_use[*it] == i)) {
+				free_buffers.push_back(plan.k_buffer[*it]);
+				it = live.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		if (free_buffers.empty()) {
+			plan.k_buffer[i] = plan.num_k_buffers++;
+		} else {
+			auto lowest = std::min_element(free_buffers.begin(), free_buffers.end());
+			plan.k_buffer[i] = *lowest;
+			free_buffers.erase(lowest);
+		}
+		live.push_back(i);
+	}
+
+	return plan;
+}
+
+stepper_cost custom_rk_cost(const butcher_tableau& b_tab, const custom_rk_plan& plan, size_t buffer_size_byte, size_t k_buffer_size_byte)
+{
+	stepper_cost c;
+	c.ode_evaluations = plan.stages.size();
+	c.temporary_buffers = plan.num_k_buffers;
+	c.temporary_byte = plan.num_k_buffers * k_buffer_size_byte;
+	c.spare_byte = buffer_size_byte; // y_(n+1) of the in-place step(), copied back into d_mem
+
+	if (plan.acc_method == accumulate_method::subdiagonal) {
+		// see rk_stepper::cost()
+		const size_t stages = plan.stages.size();
+		c.read_byte = stages * buffer_size_byte + (stages > 2 ? stages - 2 : 0) * buffer_size_byte + (stages - 1) * buffer_size_byte;
+		c.written_byte = 2 * stages * buffer_size_byte;
+		return c;
+	}
+
+	// the generated kernels read y_n and the k's with non-zero coefficients, and write one state
+	auto weighted_add = [&](const std::vector<real_t>& coeffs) {
+		++c.weighted_add_launches;
+		c.read_byte += buffer_size_byte + count_terms(coeffs) * k_buffer_size_byte;
+		c.written_byte += buffer_size_byte;
+	};
+
+	for (size_t i : plan.stages) {
+		// every ODE evaluation reads its stage input and writes a k
+		c.read_byte += buffer_size_byte;
+		c.written_byte += k_buffer_size_byte;
+
+		// plus accumulation into d_mem_out, which is initialised from the input by the first evaluation
+		if (plan.acc_method != accumulate_method::separated) {
+			c.read_byte += (i == plan.stages.front()) ? 0 : buffer_size_byte;
+			c.written_byte += buffer_size_byte;
+		}
+
+		if (count_terms(b_tab.a[i]) == 0)
+			continue; // reads y_n
+		else if (plan.acc_method == accumulate_method::fused)
+			c.read_byte += count_terms(b_tab.a[i]) * k_buffer_size_byte; // once per element, see stage_input.cl
+		else
+			weighted_add(b_tab.a[i]);
+	}
+
+	if (plan.acc_method == accumulate_method::separated) {
+		weighted_add(b_tab.b);
+		c.spare_byte = plan.stage_inputs ? buffer_size_byte : 0; // stage inputs of in-place steps
+	} else if (plan.acc_method == accumulate_method::integrated && plan.stage_inputs) {
+		++c.temporary_buffers;
+		c.temporary_byte += buffer_size_byte;
+	}
+
+	return c;
+}
+
+accumulate_method cheapest_accumulate_method(const butcher_tableau& b_tab, k_storage storage, bool fused_ode)
+{
+	const size_t buffer_size_byte = sizeof(real_t);
+	const size_t k_buffer_size_byte = k_storage_element_size_byte(storage);
+
+	bool found = false;
+	accumulate_method best = accumulate_method::separated;
+	stepper_cost best_cost;
+	for (accumulate_method acc_method : { accumulate_method::subdiagonal, accumulate_method::fused, accumulate_method::integrated, accumulate_method::separated }) {
+		if (!is_applicable(b_tab, acc_method, storage, fused_ode))
+			continue;
+
+		// NOTE: subdiagonal always uses full storage
+		const stepper_cost c = custom_rk_cost(b_tab, make_custom_rk_plan(b_tab, acc_method), buffer_size_byte, (acc_method == accumulate_method::subdiagonal) ? buffer_size_byte : k_buffer_size_byte);
+		const size_t traffic = c.read_byte + c.written_byte;
+		const size_t best_traffic = best_cost.read_byte + best_cost.written_byte;
+		if (!found || traffic < best_traffic || (traffic == best_traffic && c.memory_byte() < best_cost.memory_byte())) {
+			found = true;
+			best = acc_method;
+			best_cost = c;
+		}
+	}
+
+	return best;
+}
+
+std::string custom_rk_kernel_source(const butcher_tableau& b_tab, const custom_rk_plan& plan)
+{
+	std::ostringstream os;
+	os << embedded_ocl_source << "\n";
+	os << std::scientific << std::setprecision(std::numeric_limits<real_t>::max_digits10);
+
+	// stage inputs, see custom_rk_stepper::step()
+	if (plan.acc_method == accumulate_method::separated || plan.acc_method == accumulate_method::integrated)
+		for (size_t i : plan.stages)
+			if (count_terms(b_tab.a[i]) > 0)
+				write_weighted_add_kernel(os, "custom_rk_stage_" + std::to_string(i), b_tab.a[i]);
+
+	write_weighted_add_kernel(os, "custom_rk_result", b_tab.b);
+
+	return os.str();
+}
+
+} // namespace num
+} // namespace noma
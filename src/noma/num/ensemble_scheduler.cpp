@@ -0,0 +1,181 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/ensemble_scheduler.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace noma {
+namespace num {
+
+ensemble_scheduler::ensemble_scheduler(const std::vector<ocl::helper*>& ocls, chunk_stepper_factory factory, size_t num_matrices, completion_callback on_completion)
+	: on_completion_(std::move(on_completion))
+{
+	if (ocls.empty())
+		throw std::runtime_error("ensemble_scheduler::ensemble_scheduler(): error: at least one worker is required");
+
+	// NOTE: create all steppers before starting any thread, such that construction errors leave no threads behind
+	for (ocl::helper* ocl : ocls) {
+		workers_.emplace_back(new worker());
+		workers_.back()->ocl = ocl;
+		workers_.back()->stepper = factory(*ocl, num_matrices);
+	}
+
+	for (size_t w = 0; w < workers_.size(); ++w)
+		workers_[w]->thread = std::thread(&ensemble_scheduler::run_worker, this, w);
+}
+
+ensemble_scheduler::~ensemble_scheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	work_available_.notify_all();
+
+	for (auto& w : workers_)
+		w->thread.join();
+}
+
+void ensemble_scheduler::submit(integration_job job)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	worker& w = *workers_[next_worker_];
+	next_worker_ = (next_worker_ + 1) % workers_.size();
+	{
+		std::lock_guard<std::mutex> worker_lock(w.mutex);
+		w.jobs.push_back(std::move(job));
+	}
+	++pending_;
+	work_available_.notify_all();
+}
+
+void ensemble_scheduler::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	all_done_.wait(lock, [this]() { return pending_ == 0; });
+
+	if (error_) {
+		std::exception_ptr error = error_;
+		error_ = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+size_t ensemble_scheduler::num_completed() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return completed_;
+}
+
+size_t ensemble_scheduler::num_stolen() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stolen_;
+}
+
+bool ensemble_scheduler::take_job(size_t w, integration_job& job)
+{
+	// own deque first, from the front
+	{
+		worker& own = *workers_[w];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty()) {
+			job = std::move(own.jobs.front());
+			own.jobs.pop_front();
+			return true;
+		}
+	}
+
+	// steal from the back of the others, starting with the next worker
+	bool stolen = false;
+	for (size_t i = 1; i < workers_.size() && !stolen; ++i) {
+		worker& victim = *workers_[(w + i) % workers_.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.back());
+			victim.jobs.pop_back();
+			stolen = true;
+		}
+	}
+
+	// NOTE: lock order is mutex_ before any worker mutex, i.e. not while holding the victim's
+	if (stolen) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		++stolen_;
+	}
+
+	return stolen;
+}
+
+void ensemble_scheduler::integrate(worker& w, integration_job& job)
+{
+	const size_t size_byte = job.state.size() * sizeof(complex_t);
+	if (w.size_byte != size_byte) {
+		w.state = w.ocl->create_buffer(CL_MEM_READ_WRITE, size_byte, nullptr);
+		w.size_byte = size_byte;
+	}
+
+	if (job.configure)
+		job.configure(w.stepper);
+
+	cl::CommandQueue& queue = w.ocl->command_queue();
+	cl_int err = queue.enqueueWriteBuffer(w.state, CL_FALSE, 0, size_byte, job.state.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(w.state)");
+
+	for (size_t i = 0; i < job.num_steps; ++i)
+		w.stepper.stepper->step(job.time + static_cast<real_t>(i) * job.step_size, job.step_size, w.state);
+
+	err = queue.enqueueReadBuffer(w.state, CL_TRUE, 0, size_byte, job.state.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(w.state)");
+
+	job.time += static_cast<real_t>(job.num_steps) * job.step_size;
+}
+
+void ensemble_scheduler::run_worker(size_t w)
+{
+	while (true) {
+		integration_job job;
+		if (!take_job(w, job)) {
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (stop_)
+				return;
+			// NOTE: re-check under the scheduler lock, as submit() notifies while holding it
+			work_available_.wait(lock, [&]() {
+				if (stop_)
+					return true;
+				for (auto& other : workers_) {
+					std::lock_guard<std::mutex> worker_lock(other->mutex);
+					if (!other->jobs.empty())
+						return true;
+				}
+				return false;
+			});
+			continue;
+		}
+
+		std::exception_ptr error;
+		try {
+			integrate(*workers_[w], job);
+			if (on_completion_)
+				on_completion_(job);
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (error && !error_)
+				error_ = error;
+			++completed_;
+			--pending_;
+			if (pending_ == 0)
+				all_done_.notify_all();
+		}
+	}
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,159 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/event_detector.hpp"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+#include <noma/typa/parser_error.hpp>
+
+namespace noma {
+namespace num {
+
+const std::string event_detector::embedded_ocl_source_ {
+#include "event.cl.hpp"  // NOTE: generated by CMake
+};
+
+std::ostream& operator<<(std::ostream& out, const event_direction& direction)
+{
+	out << event_direction_names.at(direction);
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, event_direction& direction)
+{
+	std::string value;
+	std::getline(in, value);
+
+	// get key to value
+	// NOTE: we trust event_direction_names to be complete here
+	bool found = false;
+	for (auto it = event_direction_names.begin(); it != event_direction_names.end(); ++it)
+		if (it->second == value) {
+			direction = it->first;
+			found = true;
+			break;
+		}
+
+	if (!found)
+		throw noma::typa::parser_error("'" + value + "' is not a valid event_direction.");
+
+	return in;
+}
+
+std::ostream& operator<<(std::ostream& out, const event_record& record)
+{
+	out << "event " << record.event << " of system " << record.system << " at time " << record.time << (record.terminal ? " (terminal)" : "");
+	return out;
+}
+
+event_detector::event_detector(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, size_t buffer_size_byte,
+                               const std::vector<event_spec>& events)
+	: ocl_(ocl), buffer_size_byte_(buffer_size_byte), events_(events),
+	  dimensions_kernel_(ocl, embedded_ocl_source_, "event_dimensions", source_header, ocl_compile_options, range),
+	  initialise_kernel_(ocl, embedded_ocl_source_, "event_initialise", source_header, ocl_compile_options, range),
+	  detect_kernel_(ocl, embedded_ocl_source_, "event_detect", source_header, ocl_compile_options, range)
+{
+	std::vector<int_t> dims(2);
+	cl::Buffer dims_buffer = ocl_.create_buffer(CL_MEM_READ_WRITE, dims.size() * sizeof(int_t), nullptr);
+	dimensions_kernel_(dims_buffer);
+	cl_int err = ocl_.command_queue().enqueueReadBuffer(dims_buffer, CL_TRUE, 0, dims.size() * sizeof(int_t), dims.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(dims_buffer)");
+
+	num_matrices_ = static_cast<size_t>(dims[0]);
+	if (static_cast<size_t>(dims[1]) != events_.size())
+		throw std::runtime_error("event_detector::event_detector(): error: number of event specs does not match NOMA_NUM_EVENTS.");
+
+	// direction and terminal flag per event, see event.cl
+	std::vector<int_t> config;
+	for (const event_spec& spec : events_) {
+		config.push_back(static_cast<int_t>(spec.direction));
+		config.push_back(spec.terminal ? 1 : 0);
+	}
+
+	const size_t max_records = num_matrices_ * events_.size();
+	y_n_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, buffer_size_byte_, nullptr);
+	g_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, max_records * sizeof(real_t), nullptr);
+	frozen_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, num_matrices_ * sizeof(int_t), nullptr);
+	config_buffer_ = ocl_.create_buffer(CL_MEM_READ_ONLY, config.size() * sizeof(int_t), nullptr);
+	count_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, sizeof(int_t), nullptr);
+	record_id_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, 2 * max_records * sizeof(int_t), nullptr);
+	record_theta_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, max_records * sizeof(real_t), nullptr);
+
+	err = ocl_.command_queue().enqueueWriteBuffer(config_buffer_, CL_TRUE, 0, config.size() * sizeof(int_t), config.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(config_buffer_)");
+}
+
+void event_detector::initialise(real_t time, cl::Buffer& d_mem)
+{
+	initialise_kernel_(time, d_mem, g_buffer_, frozen_buffer_);
+	num_frozen_ = 0;
+}
+
+void event_detector::before_step(cl::Buffer& d_mem)
+{
+	cl_int err = ocl_.command_queue().enqueueCopyBuffer(d_mem, y_n_buffer_, 0, 0, buffer_size_byte_);
+	ocl::error_handler(err, "clEnqueueCopyBuffer(d_mem, y_n_buffer_)");
+}
+
+std::vector<event_record> event_detector::after_step(real_t time, real_t step_size, cl::Buffer& d_mem)
+{
+	return after_step(time, step_size, y_n_buffer_, d_mem);
+}
+
+std::vector<event_record> event_detector::after_step(real_t time, real_t step_size, cl::Buffer& y_n, cl::Buffer& y_np1)
+{
+	if (y_n() == y_np1())
+		throw std::runtime_error("event_detector::after_step(): error: y_n and y_np1 must differ, use before_step() for in-place steps.");
+
+	cl_int err = ocl_.command_queue().enqueueFillBuffer(count_buffer_, static_cast<int_t>(0), 0, sizeof(int_t));
+	ocl::error_handler(err, "clEnqueueFillBuffer(count_buffer_)");
+
+	detect_kernel_(time, step_size, y_n, y_np1, g_buffer_, frozen_buffer_, config_buffer_, count_buffer_, record_id_buffer_, record_theta_buffer_);
+
+	// NOTE: only the records of the flagged systems are read back
+	int_t count = 0;
+	err = ocl_.command_queue().enqueueReadBuffer(count_buffer_, CL_TRUE, 0, sizeof(int_t), &count);
+	ocl::error_handler(err, "clEnqueueReadBuffer(count_buffer_)");
+
+	std::vector<event_record> records;
+	if (count == 0)
+		return records;
+
+	std::vector<int_t> ids(2 * count);
+	std::vector<real_t> thetas(count);
+	err = ocl_.command_queue().enqueueReadBuffer(record_id_buffer_, CL_FALSE, 0, ids.size() * sizeof(int_t), ids.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(record_id_buffer_)");
+	err = ocl_.command_queue().enqueueReadBuffer(record_theta_buffer_, CL_TRUE, 0, thetas.size() * sizeof(real_t), thetas.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(record_theta_buffer_)");
+
+	for (int_t i = 0; i < count; ++i) {
+		event_record record;
+		record.system = static_cast<size_t>(ids[2 * i]);
+		record.event = static_cast<size_t>(ids[2 * i + 1]);
+		record.time = time + thetas[i] * step_size;
+		record.terminal = events_.at(record.event).terminal;
+		records.push_back(record);
+	}
+
+	// the records are appended in arbitrary order by the device
+	std::sort(records.begin(), records.end(), [](const event_record& a, const event_record& b) {
+		return (a.system != b.system) ? a.system < b.system : (a.time != b.time) ? a.time < b.time : a.event < b.event;
+	});
+
+	// several terminal events of one system can happen in one step, interleaved with non-terminal ones, count systems, not records
+	// NOTE: frozen systems do not report further events, see cl/event.cl
+	std::set<size_t> frozen_systems;
+	for (const event_record& record : records)
+		if (record.terminal)
+			frozen_systems.insert(record.system);
+	num_frozen_ += frozen_systems.size();
+
+	return records;
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,127 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/host_buffer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+namespace noma {
+namespace num {
+
+bool is_host_unified(ocl::helper& ocl)
+{
+	const cl_device_type type = ocl.device().getInfo<CL_DEVICE_TYPE>();
+	const bool unified = ocl.device().getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>();
+	return (type & CL_DEVICE_TYPE_CPU) || unified;
+}
+
+host_buffer_mode default_host_buffer_mode(ocl::helper& ocl)
+{
+	return is_host_unified(ocl) ? host_buffer_mode::use_host_ptr : host_buffer_mode::device;
+}
+
+buffer_mapping::buffer_mapping(cl::CommandQueue& queue, cl::Buffer& buffer, cl_map_flags flags, size_t size_byte, size_t offset_byte)
+	: queue_(&queue), buffer_(buffer), size_byte_(size_byte)
+{
+	cl_int err = CL_SUCCESS;
+	data_ = queue_->enqueueMapBuffer(buffer_, CL_TRUE, flags, offset_byte, size_byte, nullptr, nullptr, &err);
+	ocl::error_handler(err, "clEnqueueMapBuffer(buffer_)");
+}
+
+buffer_mapping::buffer_mapping(buffer_mapping&& other)
+	: queue_(other.queue_), buffer_(other.buffer_), data_(other.data_), size_byte_(other.size_byte_)
+{
+	other.data_ = nullptr;
+}
+
+buffer_mapping::~buffer_mapping()
+{
+	// NOTE: no exceptions from destructors, errors are reported by an explicit unmap() only
+	if (data_)
+		queue_->enqueueUnmapMemObject(buffer_, data_);
+}
+
+void buffer_mapping::unmap()
+{
+	if (!data_)
+		return;
+
+	cl_int err = queue_->enqueueUnmapMemObject(buffer_, data_);
+	data_ = nullptr;
+	ocl::error_handler(err, "clEnqueueUnmapMemObject(buffer_)");
+}
+
+void host_buffer::aligned_deleter::operator()(void* ptr) const
+{
+	std::free(ptr);
+}
+
+size_t host_buffer::page_size()
+{
+	const long size = sysconf(_SC_PAGESIZE);
+	return size > 0 ? static_cast<size_t>(size) : 4096;
+}
+
+host_buffer::host_buffer(ocl::helper& ocl, size_t size_byte)
+	: host_buffer(ocl, size_byte, default_host_buffer_mode(ocl))
+{
+}
+
+host_buffer::host_buffer(ocl::helper& ocl, size_t size_byte, host_buffer_mode mode)
+	: ocl_(ocl), size_byte_(size_byte), mode_(mode)
+{
+	if (size_byte_ == 0)
+		throw std::runtime_error("host_buffer::host_buffer(): error: size_byte must be positive");
+
+	switch (mode_) {
+		case host_buffer_mode::device:
+			buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, size_byte_, nullptr);
+			break;
+		case host_buffer_mode::alloc_host_ptr:
+			buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size_byte_, nullptr);
+			break;
+		case host_buffer_mode::use_host_ptr: {
+			// alignment: page size, and at least the device's base address alignment (given in bits)
+			const size_t device_alignment = ocl_.device().getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8;
+			const size_t alignment = std::max(page_size(), device_alignment);
+			const size_t padded_size = (size_byte_ + cache_line_size - 1) / cache_line_size * cache_line_size;
+
+			void* ptr = nullptr;
+			if (posix_memalign(&ptr, alignment, padded_size) != 0)
+				throw std::runtime_error("host_buffer::host_buffer(): error: aligned allocation of " + std::to_string(padded_size) + " bytes failed");
+			host_memory_.reset(ptr);
+
+			buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, padded_size, host_memory_.get());
+			break;
+		}
+	}
+}
+
+buffer_mapping host_buffer::map(cl_map_flags flags)
+{
+	return buffer_mapping(ocl_.command_queue(), buffer_, flags, size_byte_);
+}
+
+void host_buffer::write(const void* src)
+{
+	buffer_mapping mapping = map(CL_MAP_WRITE);
+	std::memcpy(mapping.data(), src, size_byte_);
+	mapping.unmap();
+}
+
+void host_buffer::read(void* dst)
+{
+	buffer_mapping mapping = map(CL_MAP_READ);
+	std::memcpy(dst, mapping.data(), size_byte_);
+	mapping.unmap();
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,54 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/imex_stepper.hpp"
+
+#include <string>
+
+#include <noma/typa/parser_error.hpp>
+
+namespace noma {
+namespace num {
+
+std::ostream& operator<<(std::ostream& out, const imex_method_t& m)
+{
+	out << imex_method_names.at(m);
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, imex_method_t& m)
+{
+	std::string value;
+	std::getline(in, value);
+
+	// get key to value
+	// NOTE: we trust imex_method_names to be complete here
+	bool found = false;
+	for (auto it = imex_method_names.begin(); it != imex_method_names.end(); ++it)
+		if (it->second == value) {
+			m = it->first;
+			found = true;
+			break;
+		}
+
+	if (!found)
+		throw noma::typa::parser_error("'" + value + "' is not a valid imex_method.");
+
+	return in;
+}
+
+const imex_tableau& get_imex_tableau(const imex_method_t m)
+{
+	switch (m) {
+		case imex_method_t::ark324l2sa:
+			return ark324l2sa_tableau;
+		case imex_method_t::ark436l2sa:
+			return ark436l2sa_tableau;
+		default:
+			throw std::runtime_error("get_imex_tableau(): error: Unknown IMEX method");
+	}
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,72 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/k_storage.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include <noma/typa/parser_error.hpp>
+
+namespace noma {
+namespace num {
+
+std::ostream& operator<<(std::ostream& out, const k_storage& s)
+{
+	out << k_storage_names.at(s);
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, k_storage& s)
+{
+	std::string value;
+	std::getline(in, value);
+
+	// get key to value
+	// NOTE: we trust k_storage_names to be complete here
+	bool found = false;
+	for (auto it = k_storage_names.begin(); it != k_storage_names.end(); ++it)
+		if (it->second == value) {
+			s = it->first;
+			found = true;
+			break;
+		}
+
+	if (!found)
+		throw noma::typa::parser_error("'" + value + "' is not a valid k_storage.");
+
+	return in;
+}
+
+size_t k_storage_element_size_byte(k_storage storage)
+{
+	switch (storage) {
+		case k_storage::full:
+			return sizeof(real_t);
+		case k_storage::half:
+		case k_storage::bf16:
+			return 2;
+		default:
+			throw std::runtime_error("k_storage_element_size_byte(): error: Unknown k storage");
+	}
+}
+
+void k_storage_compile_options(k_storage storage, std::ostream& os)
+{
+	if (storage == k_storage::half)
+		os << "#define NOMA_NUM_K_STORAGE_HALF" << "\n";
+	else if (storage == k_storage::bf16)
+		os << "#define NOMA_NUM_K_STORAGE_BF16" << "\n";
+}
+
+std::ostream& operator<<(std::ostream& out, const k_storage_report& report)
+{
+	out << "k storage: max. abs. error: " << report.max_abs_error
+	    << ", max. rel. error: " << report.max_rel_error
+	    << ", bytes per element: " << report.bytes_per_k_element;
+	return out;
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,136 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/matrix_exp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace noma {
+namespace num {
+
+namespace {
+
+template<typename COMPLEX_T>
+std::vector<COMPLEX_T> matrix_mult(const std::vector<COMPLEX_T>& a, const std::vector<COMPLEX_T>& b, size_t n)
+{
+	std::vector<COMPLEX_T> c(n * n, COMPLEX_T(0.0));
+	for (size_t i = 0; i < n; ++i)
+		for (size_t k = 0; k < n; ++k) {
+			const COMPLEX_T a_ik = a[i * n + k];
+			for (size_t j = 0; j < n; ++j)
+				c[i * n + j] += a_ik * b[k * n + j];
+		}
+	return c;
+}
+
+} // namespace
+
+template<typename COMPLEX_T>
+void matrix_solve(std::vector<COMPLEX_T>& a, std::vector<COMPLEX_T>& b, size_t n, size_t m)
+{
+	for (size_t col = 0; col < n; ++col) {
+		// find pivot
+		size_t pivot = col;
+		for (size_t row = col + 1; row < n; ++row)
+			if (std::abs(a[row * n + col]) > std::abs(a[pivot * n + col]))
+				pivot = row;
+
+		if (std::abs(a[pivot * n + col]) == 0.0)
+			throw std::runtime_error("matrix_solve(): error: singular matrix.");
+
+		if (pivot != col) {
+			for (size_t j = 0; j < n; ++j)
+				std::swap(a[col * n + j], a[pivot * n + j]);
+			for (size_t j = 0; j < m; ++j)
+				std::swap(b[col * m + j], b[pivot * m + j]);
+		}
+
+		// eliminate below the pivot
+		for (size_t row = col + 1; row < n; ++row) {
+			const COMPLEX_T factor = a[row * n + col] / a[col * n + col];
+			if (factor == COMPLEX_T(0.0))
+				continue;
+			for (size_t j = col; j < n; ++j)
+				a[row * n + j] -= factor * a[col * n + j];
+			for (size_t j = 0; j < m; ++j)
+				b[row * m + j] -= factor * b[col * m + j];
+		}
+	}
+
+	// back substitution
+	for (size_t row = n; row-- > 0; ) {
+		for (size_t j = 0; j < m; ++j) {
+			COMPLEX_T sum = b[row * m + j];
+			for (size_t k = row + 1; k < n; ++k)
+				sum -= a[row * n + k] * b[k * m + j];
+			b[row * m + j] = sum / a[row * n + row];
+		}
+	}
+}
+
+template<typename COMPLEX_T>
+std::vector<COMPLEX_T> matrix_exp(const std::vector<COMPLEX_T>& a, size_t n)
+{
+	using scalar_t = typename COMPLEX_T::value_type;
+	const size_t q = 6; // degree of the Pade approximant
+
+	// 1-norm, i.e. maximum absolute column sum
+	scalar_t norm = 0.0;
+	for (size_t j = 0; j < n; ++j) {
+		scalar_t sum = 0.0;
+		for (size_t i = 0; i < n; ++i)
+			sum += std::abs(a[i * n + j]);
+		norm = std::max(norm, sum);
+	}
+
+	// scale such that the norm is <= 1/2
+	int squarings = 0;
+	if (norm > 0.5)
+		squarings = static_cast<int>(std::ceil(std::log2(norm / 0.5)));
+	const scalar_t scale = std::ldexp(scalar_t(1.0), -squarings);
+
+	std::vector<COMPLEX_T> a_scaled(a);
+	for (auto& x : a_scaled)
+		x *= scale;
+
+	// numerator and denominator of the Pade approximant
+	std::vector<COMPLEX_T> numer(n * n, COMPLEX_T(0.0));
+	std::vector<COMPLEX_T> denom(n * n, COMPLEX_T(0.0));
+	for (size_t i = 0; i < n; ++i) {
+		numer[i * n + i] = 1.0;
+		denom[i * n + i] = 1.0;
+	}
+
+	std::vector<COMPLEX_T> power(a_scaled);
+	scalar_t coeff = 1.0;
+	for (size_t k = 1; k <= q; ++k) {
+		coeff *= static_cast<scalar_t>(q - k + 1) / static_cast<scalar_t>(k * (2 * q - k + 1));
+		const scalar_t sign = (k % 2) == 0 ? 1.0 : -1.0;
+		for (size_t i = 0; i < n * n; ++i) {
+			numer[i] += coeff * power[i];
+			denom[i] += sign * coeff * power[i];
+		}
+		if (k < q)
+			power = matrix_mult(power, a_scaled, n);
+	}
+
+	// exp(a_scaled) = denom^-1 * numer
+	matrix_solve(denom, numer, n, n);
+
+	// undo scaling by repeated squaring
+	for (int s = 0; s < squarings; ++s)
+		numer = matrix_mult(numer, numer, n);
+
+	return numer;
+}
+
+template std::vector<complex_t> matrix_exp(const std::vector<complex_t>& a, size_t n);
+template std::vector<long_complex_t> matrix_exp(const std::vector<long_complex_t>& a, size_t n);
+template void matrix_solve(std::vector<complex_t>& a, std::vector<complex_t>& b, size_t n, size_t m);
+template void matrix_solve(std::vector<long_complex_t>& a, std::vector<long_complex_t>& b, size_t n, size_t m);
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,190 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/parareal.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace noma {
+namespace num {
+
+std::ostream& operator<<(std::ostream& out, const parareal_report& report)
+{
+	out << "parareal: iterations: " << report.iterations
+	    << ", converged: " << (report.converged ? "yes" : "no")
+	    << ", correction: " << report.correction
+	    << ", wall time: " << report.wall_time << " s"
+	    << ", fine slice time: " << report.fine_slice_time << " s"
+	    << ", serial estimate: " << report.serial_time << " s"
+	    << ", speedup: " << report.speedup;
+	return out;
+}
+
+parareal::parareal(ocl::helper& coarse_ocl, chunk_stepper_factory coarse_factory,
+                   const std::vector<ocl::helper*>& fine_ocls, chunk_stepper_factory fine_factory,
+                   size_t num_matrices)
+{
+	if (fine_ocls.empty())
+		throw std::runtime_error("parareal::parareal(): error: at least one fine worker is required");
+
+	coarse_.ocl = &coarse_ocl;
+	coarse_.stepper = coarse_factory(coarse_ocl, num_matrices);
+
+	for (ocl::helper* ocl : fine_ocls) {
+		fine_.push_back(worker());
+		fine_.back().ocl = ocl;
+		fine_.back().stepper = fine_factory(*ocl, num_matrices);
+	}
+}
+
+void parareal::allocate(worker& w, size_t size_byte)
+{
+	// NOTE: buffers are kept between runs of the same state size
+	if (w.size_byte == size_byte)
+		return;
+
+	w.state = w.ocl->create_buffer(CL_MEM_READ_WRITE, size_byte, nullptr);
+	w.size_byte = size_byte;
+}
+
+void parareal::propagate(worker& w, std::vector<complex_t>& state, real_t time, real_t step_size, size_t num_steps)
+{
+	const size_t size_byte = state.size() * sizeof(complex_t);
+	cl::CommandQueue& queue = w.ocl->command_queue();
+
+	cl_int err = queue.enqueueWriteBuffer(w.state, CL_FALSE, 0, size_byte, state.data());
+	ocl::error_handler(err, "clEnqueueWriteBuffer(w.state)");
+
+	for (size_t i = 0; i < num_steps; ++i)
+		w.stepper.stepper->step(time + static_cast<real_t>(i) * step_size, step_size, w.state);
+
+	err = queue.enqueueReadBuffer(w.state, CL_TRUE, 0, size_byte, state.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(w.state)");
+}
+
+// max. norm of the difference of two states
+static real_t max_difference(const std::vector<complex_t>& a, const std::vector<complex_t>& b)
+{
+	real_t result = 0.0;
+	for (size_t i = 0; i < a.size(); ++i)
+		result = std::max(result, std::abs(a[i] - b[i]));
+	return result;
+}
+
+static real_t max_norm(const std::vector<complex_t>& a)
+{
+	real_t result = 0.0;
+	for (const complex_t& v : a)
+		result = std::max(result, std::abs(v));
+	return result;
+}
+
+parareal_report parareal::run(std::vector<complex_t>& state, real_t t_begin, real_t t_end, size_t num_slices,
+                              size_t coarse_steps_per_slice, size_t fine_steps_per_slice,
+                              real_t tolerance, size_t max_iterations)
+{
+	if (num_slices == 0 || coarse_steps_per_slice == 0 || fine_steps_per_slice == 0)
+		throw std::runtime_error("parareal::run(): error: number of slices and steps per slice must be positive");
+
+	using clock = std::chrono::high_resolution_clock;
+	const auto start = clock::now();
+
+	const size_t size_byte = state.size() * sizeof(complex_t);
+	allocate(coarse_, size_byte);
+	for (worker& w : fine_)
+		allocate(w, size_byte);
+
+	const real_t slice_length = (t_end - t_begin) / static_cast<real_t>(num_slices);
+	const real_t coarse_step = slice_length / static_cast<real_t>(coarse_steps_per_slice);
+	const real_t fine_step = slice_length / static_cast<real_t>(fine_steps_per_slice);
+	auto slice_begin = [&](size_t n) { return t_begin + static_cast<real_t>(n) * slice_length; };
+
+	// u[n]: state at the beginning of slice n, u[num_slices] is the result
+	std::vector<std::vector<complex_t>> u(num_slices + 1, state);
+	std::vector<std::vector<complex_t>> coarse(num_slices); // G(u[n]) of the last iteration
+	std::vector<std::vector<complex_t>> fine(num_slices); // F(u[n]) of the current iteration
+
+	// initial coarse sweep
+	for (size_t n = 0; n < num_slices; ++n) {
+		coarse[n] = u[n];
+		propagate(coarse_, coarse[n], slice_begin(n), coarse_step, coarse_steps_per_slice);
+		u[n + 1] = coarse[n];
+	}
+
+	parareal_report report;
+	double fine_time_sum = 0.0;
+	size_t fine_slices = 0;
+
+	for (size_t k = 1; k <= max_iterations && !report.converged; ++k) {
+		// slices before k - 1 start from exact values, i.e. do not change anymore
+		const size_t first = k - 1;
+
+		// parallel fine sweep
+		std::vector<double> worker_time(fine_.size(), 0.0);
+		std::vector<std::exception_ptr> errors(fine_.size());
+		std::vector<std::thread> threads;
+		for (size_t w = 0; w < fine_.size(); ++w) {
+			threads.emplace_back([&, w]() {
+				try {
+					for (size_t n = first + w; n < num_slices; n += fine_.size()) {
+						const auto slice_start = clock::now();
+						fine[n] = u[n];
+						propagate(fine_[w], fine[n], slice_begin(n), fine_step, fine_steps_per_slice);
+						worker_time[w] += std::chrono::duration<double>(clock::now() - slice_start).count();
+					}
+				} catch (...) {
+					errors[w] = std::current_exception();
+				}
+			});
+		}
+		for (std::thread& t : threads)
+			t.join();
+		for (const std::exception_ptr& e : errors)
+			if (e)
+				std::rethrow_exception(e);
+
+		for (double t : worker_time)
+			fine_time_sum += t;
+		fine_slices += num_slices - first;
+
+		// sequential coarse correction
+		real_t correction = 0.0;
+		for (size_t n = first; n < num_slices; ++n) {
+			std::vector<complex_t> coarse_new = u[n];
+			propagate(coarse_, coarse_new, slice_begin(n), coarse_step, coarse_steps_per_slice);
+
+			std::vector<complex_t> u_new(state.size());
+			for (size_t i = 0; i < u_new.size(); ++i)
+				u_new[i] = coarse_new[i] + fine[n][i] - coarse[n][i];
+
+			correction = std::max(correction, max_difference(u_new, u[n + 1]));
+			u[n + 1] = std::move(u_new);
+			coarse[n] = std::move(coarse_new);
+		}
+
+		report.iterations = k;
+		report.correction = correction / std::max(max_norm(u[num_slices]), std::numeric_limits<real_t>::min());
+		// NOTE: after num_slices iterations, the result equals the sequential fine solution
+		report.converged = report.correction <= tolerance || k == num_slices;
+	}
+
+	state = u[num_slices];
+
+	report.wall_time = std::chrono::duration<double>(clock::now() - start).count();
+	report.fine_slice_time = fine_slices > 0 ? fine_time_sum / static_cast<double>(fine_slices) : 0.0;
+	report.serial_time = report.fine_slice_time * static_cast<double>(num_slices);
+	report.speedup = report.wall_time > 0.0 ? report.serial_time / report.wall_time : 0.0;
+
+	return report;
+}
+
+} // namespace num
+} // namespace noma
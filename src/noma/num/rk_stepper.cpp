@@ -4,4 +4,40 @@
 
 #include "noma/num/rk_stepper.hpp"
 
-// NOTE: this file is currently only needed for dependency management within CMake. Namely to attach OpenCL kernel code generation.
\ No newline at end of file
+#include <sstream>
+
+namespace noma {
+namespace num {
+
+void accumulate_compile_options(accumulate_method acc_method, std::ostream& os)
+{
+	if (acc_method == accumulate_method::integrated ||
+	    acc_method == accumulate_method::subdiagonal ||
+	    acc_method == accumulate_method::fused) {
+		os << "#define NOMA_NUM_ODE_ACCUMULATE" << "\n";
+	}
+
+	if (acc_method == accumulate_method::subdiagonal) {
+		os << "#define NOMA_NUM_SUBDIAGONAL" << "\n";
+	}
+
+	if (acc_method == accumulate_method::fused) {
+		os << "#define NOMA_NUM_ODE_FUSED" << "\n";
+	}
+}
+
+std::string weighted_add_source_header(const std::string& source_header, k_storage storage, bool track_status)
+{
+	std::ostringstream os;
+	os << source_header << "\n";
+	os << "#undef NOMA_NUM_K_STORAGE_HALF" << "\n";
+	os << "#undef NOMA_NUM_K_STORAGE_BF16" << "\n";
+	os << "#undef NOMA_NUM_STATUS" << "\n";
+	k_storage_compile_options(storage, os);
+	if (track_status)
+		status_compile_options(os);
+	return os.str();
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,84 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/rkc_stepper.hpp"
+
+namespace noma {
+namespace num {
+
+namespace {
+
+// T_j(w0), T_j'(w0), and T_j''(w0) of the Chebyshev polynomials of the first kind for j = 0 to s, w0 = 1 + damping / s^2
+struct chebyshev_values
+{
+	chebyshev_values(size_t s, long_real_t damping)
+		: w0(1.0 + damping / (static_cast<long_real_t>(s) * s)), t(s + 1), dt(s + 1), ddt(s + 1)
+	{
+		t[0] = 1.0; dt[0] = 0.0; ddt[0] = 0.0;
+		t[1] = w0;  dt[1] = 1.0; ddt[1] = 0.0;
+		for (size_t j = 2; j <= s; ++j) {
+			t[j] = 2.0 * w0 * t[j - 1] - t[j - 2];
+			dt[j] = 2.0 * t[j - 1] + 2.0 * w0 * dt[j - 1] - dt[j - 2];
+			ddt[j] = 4.0 * dt[j - 1] + 2.0 * w0 * ddt[j - 1] - ddt[j - 2];
+		}
+	}
+
+	long_real_t w0;
+	std::vector<long_real_t> t, dt, ddt;
+};
+
+} // namespace
+
+rkc_coefficients::rkc_coefficients(size_t stages, real_t damping)
+	: stages(stages), mu(stages + 1, 0.0), nu(stages + 1, 0.0), mu_tilde(stages + 1, 0.0), gamma_tilde(stages + 1, 0.0), c(stages + 1, 0.0)
+{
+	if (stages < 2)
+		throw std::runtime_error("rkc_coefficients::rkc_coefficients(): error: at least two stages are needed.");
+
+	const size_t s = stages;
+	const chebyshev_values cheb(s, damping);
+	const long_real_t w0 = cheb.w0;
+	const long_real_t w1 = cheb.dt[s] / cheb.ddt[s];
+
+	// b_j = T_j''(w0) / T_j'(w0)^2, with b_0 = b_1 = b_2 for second order at every stage
+	std::vector<long_real_t> b(s + 1);
+	for (size_t j = 2; j <= s; ++j)
+		b[j] = cheb.ddt[j] / (cheb.dt[j] * cheb.dt[j]);
+	b[0] = b[1] = b[2];
+
+	mu_tilde[1] = static_cast<real_t>(b[1] * w1);
+	for (size_t j = 2; j <= s; ++j) {
+		mu[j] = static_cast<real_t>(2.0 * b[j] * w0 / b[j - 1]);
+		nu[j] = static_cast<real_t>(-b[j] / b[j - 2]);
+		mu_tilde[j] = static_cast<real_t>(2.0 * b[j] * w1 / b[j - 1]);
+		gamma_tilde[j] = static_cast<real_t>(-(1.0 - b[j - 1] * cheb.t[j - 1]) * 2.0 * b[j] * w1 / b[j - 1]);
+	}
+
+	// c_j = w1 * T_j''(w0) / T_j'(w0), approximately (j^2 - 1) / (s^2 - 1)
+	for (size_t j = 2; j <= s; ++j)
+		c[j] = static_cast<real_t>(w1 * cheb.ddt[j] / cheb.dt[j]);
+	c[1] = static_cast<real_t>(c[2] / cheb.dt[2]);
+}
+
+real_t rkc_stability_bound(size_t stages, real_t damping)
+{
+	// the stability polynomial is a_s + b_s * T_s(w0 + w1 * z), i.e. bounded while w0 + w1 * z >= -1
+	const chebyshev_values cheb(stages, damping);
+	return static_cast<real_t>((1.0 + cheb.w0) * cheb.ddt[stages] / cheb.dt[stages]);
+}
+
+size_t rkc_stages(real_t step_size, real_t spectral_radius, real_t damping)
+{
+	const real_t z = step_size * spectral_radius;
+	size_t s = std::max(static_cast<size_t>(2), 1 + static_cast<size_t>(std::sqrt(1.0 + 1.54 * z)));
+
+	// NOTE: the formula is for the default damping
+	while (rkc_stability_bound(s, damping) < z)
+		++s;
+
+	return s;
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,42 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/sde_stepper.hpp"
+
+#include <string>
+
+#include <noma/typa/parser_error.hpp>
+
+namespace noma {
+namespace num {
+
+std::ostream& operator<<(std::ostream& out, const sde_method_t& m)
+{
+	out << sde_method_names.at(m);
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, sde_method_t& m)
+{
+	std::string value;
+	std::getline(in, value);
+
+	// get key to value
+	// NOTE: we trust sde_method_names to be complete here
+	bool found = false;
+	for (auto it = sde_method_names.begin(); it != sde_method_names.end(); ++it)
+		if (it->second == value) {
+			m = it->first;
+			found = true;
+			break;
+		}
+
+	if (!found)
+		throw noma::typa::parser_error("'" + value + "' is not a valid sde_method.");
+
+	return in;
+}
+
+} // namespace num
+} // namespace noma
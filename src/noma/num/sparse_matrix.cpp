@@ -0,0 +1,176 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/sparse_matrix.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace noma {
+namespace num {
+
+csr_matrix make_csr_matrix(const std::vector<complex_t>& dense, size_t size, real_t threshold)
+{
+	if (dense.size() != size * size)
+		throw std::runtime_error("make_csr_matrix(): error: dense matrix must have size x size elements");
+
+	csr_matrix a;
+	a.size = size;
+	a.row_ptr.push_back(0);
+	for (size_t i = 0; i < size; ++i) {
+		for (size_t j = 0; j < size; ++j) {
+			if (std::abs(dense[i * size + j]) > threshold) {
+				a.col_idx.push_back(static_cast<int_t>(j));
+				a.values.push_back(dense[i * size + j]);
+			}
+		}
+		a.row_ptr.push_back(static_cast<int_t>(a.values.size()));
+	}
+
+	return a;
+}
+
+// per entry of a, its position in transpose(a), in the order of a.values
+static std::vector<size_t> transpose_permutation(const csr_matrix& a, csr_matrix& t)
+{
+	t.size = a.size;
+	t.row_ptr.assign(a.size + 1, 0);
+	t.col_idx.resize(a.non_zeros());
+	t.values.resize(a.non_zeros());
+
+	// count entries per column, i.e. per row of t
+	for (int_t j : a.col_idx)
+		++t.row_ptr[j + 1];
+	for (size_t i = 0; i < a.size; ++i)
+		t.row_ptr[i + 1] += t.row_ptr[i];
+
+	std::vector<size_t> permutation(a.non_zeros());
+	std::vector<int_t> next(t.row_ptr.begin(), t.row_ptr.end() - 1);
+	for (size_t i = 0; i < a.size; ++i) {
+		for (int_t e = a.row_ptr[i]; e < a.row_ptr[i + 1]; ++e) {
+			const size_t pos = static_cast<size_t>(next[a.col_idx[e]]++);
+			t.col_idx[pos] = static_cast<int_t>(i);
+			t.values[pos] = a.values[e];
+			permutation[e] = pos;
+		}
+	}
+
+	return permutation;
+}
+
+csr_matrix transpose(const csr_matrix& a)
+{
+	csr_matrix t;
+	transpose_permutation(a, t);
+	return t;
+}
+
+ell_matrix make_ell_matrix(const csr_matrix& a)
+{
+	ell_matrix ell;
+	ell.size = a.size;
+	for (size_t i = 0; i < a.size; ++i)
+		ell.width = std::max(ell.width, static_cast<size_t>(a.row_ptr[i + 1] - a.row_ptr[i]));
+
+	ell.col_idx.assign(ell.size * ell.width, 0);
+	ell.values.assign(ell.size * ell.width, complex_t(0.0, 0.0));
+	for (size_t i = 0; i < a.size; ++i) {
+		size_t k = 0;
+		for (int_t e = a.row_ptr[i]; e < a.row_ptr[i + 1]; ++e, ++k) {
+			ell.col_idx[i * ell.width + k] = a.col_idx[e];
+			ell.values[i * ell.width + k] = a.values[e];
+		}
+		// padding: repeat the last valid column, to keep the access pattern local
+		const int_t pad_col = k > 0 ? ell.col_idx[i * ell.width + k - 1] : 0;
+		for (; k < ell.width; ++k)
+			ell.col_idx[i * ell.width + k] = pad_col;
+	}
+
+	return ell;
+}
+
+sliced_ell_matrix make_sliced_ell_matrix(const csr_matrix& a, const std::vector<std::vector<complex_t>>& values, size_t slice_size)
+{
+	if (slice_size == 0)
+		throw std::runtime_error("make_sliced_ell_matrix(): error: slice_size must be positive");
+	for (const auto& v : values)
+		if (v.size() != a.non_zeros())
+			throw std::runtime_error("make_sliced_ell_matrix(): error: every value set must match the sparsity pattern");
+
+	sliced_ell_matrix s;
+	s.size = a.size;
+	s.slice_size = slice_size;
+	s.num_systems = values.size();
+
+	const size_t num_slices = (a.size + slice_size - 1) / slice_size;
+	s.slice_ptr.push_back(0);
+	for (size_t sl = 0; sl < num_slices; ++sl) {
+		int_t width = 0;
+		for (size_t i = sl * slice_size; i < std::min(a.size, (sl + 1) * slice_size); ++i)
+			width = std::max(width, a.row_ptr[i + 1] - a.row_ptr[i]);
+		s.slice_width.push_back(width);
+		s.slice_ptr.push_back(s.slice_ptr.back() + width * static_cast<int_t>(slice_size));
+	}
+
+	s.col_idx.assign(s.padded_entries(), 0);
+	s.values.assign(s.padded_entries() * s.num_systems, complex_t(0.0, 0.0));
+	for (size_t sl = 0; sl < num_slices; ++sl) {
+		for (size_t r = 0; r < slice_size; ++r) {
+			const size_t i = sl * slice_size + r;
+			int_t k = 0;
+			int_t pad_col = 0;
+			if (i < a.size) {
+				for (int_t e = a.row_ptr[i]; e < a.row_ptr[i + 1]; ++e, ++k) {
+					const size_t pos = static_cast<size_t>(s.slice_ptr[sl]) + static_cast<size_t>(k) * slice_size + r;
+					s.col_idx[pos] = a.col_idx[e];
+					for (size_t m = 0; m < s.num_systems; ++m)
+						s.values[pos * s.num_systems + m] = values[m][e];
+					pad_col = a.col_idx[e];
+				}
+			}
+			for (; k < s.slice_width[sl]; ++k)
+				s.col_idx[static_cast<size_t>(s.slice_ptr[sl]) + static_cast<size_t>(k) * slice_size + r] = pad_col;
+		}
+	}
+
+	return s;
+}
+
+sliced_ell_matrix transpose(const sliced_ell_matrix& a)
+{
+	// recover the CSR pattern and the per-system values in CSR order
+	csr_matrix pattern;
+	pattern.size = a.size;
+	pattern.row_ptr.push_back(0);
+	std::vector<size_t> positions; // position of each CSR entry in a
+	for (size_t i = 0; i < a.size; ++i) {
+		const size_t sl = i / a.slice_size;
+		const size_t r = i % a.slice_size;
+		for (int_t k = 0; k < a.slice_width[sl]; ++k) {
+			const size_t pos = static_cast<size_t>(a.slice_ptr[sl]) + static_cast<size_t>(k) * a.slice_size + r;
+			bool non_zero = false;
+			for (size_t m = 0; m < a.num_systems && !non_zero; ++m)
+				non_zero = a.values[pos * a.num_systems + m] != complex_t(0.0, 0.0);
+			if (non_zero) {
+				pattern.col_idx.push_back(a.col_idx[pos]);
+				pattern.values.push_back(complex_t(0.0, 0.0));
+				positions.push_back(pos);
+			}
+		}
+		pattern.row_ptr.push_back(static_cast<int_t>(positions.size()));
+	}
+
+	csr_matrix pattern_t;
+	const std::vector<size_t> permutation = transpose_permutation(pattern, pattern_t);
+
+	std::vector<std::vector<complex_t>> values_t(a.num_systems, std::vector<complex_t>(positions.size()));
+	for (size_t e = 0; e < positions.size(); ++e)
+		for (size_t m = 0; m < a.num_systems; ++m)
+			values_t[m][permutation[e]] = a.values[positions[e] * a.num_systems + m];
+
+	return make_sliced_ell_matrix(pattern_t, values_t, a.slice_size);
+}
+
+} // namespace num
+} // namespace noma
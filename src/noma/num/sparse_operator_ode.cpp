@@ -0,0 +1,158 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/sparse_operator_ode.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace noma {
+namespace num {
+
+const std::string sparse_operator_ode::embedded_ocl_source_ {
+#include "sparse.cl.hpp"  // NOTE: generated by CMake
+};
+
+sparse_operator_ode::sparse_operator_ode(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+                                         size_t num_matrices, const csr_matrix& a, sparse_format format, accumulate_method acc_method,
+                                         real_t sign, complex_t alpha)
+	: ocl_(ocl), format_(format), acc_method_(acc_method),
+	  kernel_(ocl, embedded_ocl_source_, kernel_name(format), accumulate_defines(acc_method) + source_header, ocl_compile_options, range),
+	  num_matrices_(num_matrices), num_states_(a.size), sign_(sign), alpha_(alpha)
+{
+	if (format == sparse_format::sliced_ell)
+		throw std::runtime_error("sparse_operator_ode::sparse_operator_ode(): error: sliced ELL requires a sliced_ell_matrix with values per matrix");
+
+	const csr_matrix a_t = transpose(a);
+
+	if (format == sparse_format::csr) {
+		a_.ptr = upload(a.row_ptr);
+		a_.col_idx = upload(a.col_idx);
+		a_.values = upload(a.values);
+		at_.ptr = upload(a_t.row_ptr);
+		at_.col_idx = upload(a_t.col_idx);
+		at_.values = upload(a_t.values);
+	} else {
+		const ell_matrix ell = make_ell_matrix(a);
+		const ell_matrix ell_t = make_ell_matrix(a_t);
+		a_.width = static_cast<int_t>(ell.width);
+		a_.col_idx = upload(ell.col_idx);
+		a_.values = upload(ell.values);
+		at_.width = static_cast<int_t>(ell_t.width);
+		at_.col_idx = upload(ell_t.col_idx);
+		at_.values = upload(ell_t.values);
+	}
+}
+
+sparse_operator_ode::sparse_operator_ode(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range,
+                                         size_t num_matrices, const sliced_ell_matrix& a, accumulate_method acc_method,
+                                         real_t sign, complex_t alpha)
+	: ocl_(ocl), format_(sparse_format::sliced_ell), acc_method_(acc_method),
+	  kernel_(ocl, embedded_ocl_source_, kernel_name(sparse_format::sliced_ell), accumulate_defines(acc_method) + source_header, ocl_compile_options, range),
+	  num_matrices_(num_matrices), num_states_(a.size), slice_size_(static_cast<int_t>(a.slice_size)), sign_(sign), alpha_(alpha)
+{
+	if (a.num_systems != num_matrices)
+		throw std::runtime_error("sparse_operator_ode::sparse_operator_ode(): error: sliced ELL matrix must have one value set per matrix");
+
+	const sliced_ell_matrix a_t = transpose(a);
+
+	a_.ptr = upload(a.slice_ptr);
+	a_.slice_width = upload(a.slice_width);
+	a_.col_idx = upload(a.col_idx);
+	a_.values = upload(a.values);
+	at_.ptr = upload(a_t.slice_ptr);
+	at_.slice_width = upload(a_t.slice_width);
+	at_.col_idx = upload(a_t.col_idx);
+	at_.values = upload(a_t.values);
+}
+
+std::string sparse_operator_ode::accumulate_defines(accumulate_method acc_method)
+{
+	std::stringstream ss;
+	accumulate_compile_options(acc_method, ss);
+	return ss.str();
+}
+
+std::string sparse_operator_ode::kernel_name(sparse_format format)
+{
+	switch (format) {
+		case sparse_format::csr:
+			return "sparse_csr_operator";
+		case sparse_format::ell:
+			return "sparse_ell_operator";
+		case sparse_format::sliced_ell:
+			return "sparse_sliced_ell_operator";
+	}
+	throw std::runtime_error("sparse_operator_ode::kernel_name(): error: unknown sparse_format");
+}
+
+template<typename T>
+cl::Buffer sparse_operator_ode::upload(const std::vector<T>& data)
+{
+	// NOTE: at least one element, as zero-sized buffers are not allowed
+	cl::Buffer buffer = ocl_.create_buffer(CL_MEM_READ_ONLY, std::max<size_t>(data.size(), 1) * sizeof(T), nullptr);
+	if (!data.empty()) {
+		cl_int err = ocl_.command_queue().enqueueWriteBuffer(buffer, CL_TRUE, 0, data.size() * sizeof(T), data.data());
+		ocl::error_handler(err, "clEnqueueWriteBuffer(sparse_operator_ode::upload)");
+	}
+	return buffer;
+}
+
+template<typename... ACC_ARGS>
+void sparse_operator_ode::run(cl::Buffer& in, cl::Buffer& out, const ACC_ARGS&... acc_args)
+{
+	switch (format_) {
+		case sparse_format::csr:
+			kernel_(out, in, a_.ptr, a_.col_idx, a_.values, at_.ptr, at_.col_idx, at_.values,
+			        alpha_.real(), alpha_.imag(), sign_, acc_args...);
+			break;
+		case sparse_format::ell:
+			kernel_(out, in, a_.width, a_.col_idx, a_.values, at_.width, at_.col_idx, at_.values,
+			        alpha_.real(), alpha_.imag(), sign_, acc_args...);
+			break;
+		case sparse_format::sliced_ell:
+			kernel_(out, in, slice_size_, a_.ptr, a_.slice_width, a_.col_idx, a_.values, at_.ptr, at_.slice_width, at_.col_idx, at_.values,
+			        alpha_.real(), alpha_.imag(), sign_, acc_args...);
+			break;
+	}
+}
+
+void sparse_operator_ode::solve(real_t /* time */, real_t /* time_step */, cl::Buffer& in, cl::Buffer& out, real_t /* coeff */)
+{
+	if (acc_method_ != accumulate_method::separated)
+		throw std::runtime_error("sparse_operator_ode::solve(): error: kernel was compiled for accumulation, but called without accumulation buffer");
+
+	run(in, out);
+}
+
+void sparse_operator_ode::solve(real_t /* time */, real_t /* time_step */, cl::Buffer& in, cl::Buffer& out, cl::Buffer& acc, real_t acc_coeff, bool init)
+{
+	if (acc_method_ == accumulate_method::separated)
+		throw std::runtime_error("sparse_operator_ode::solve(): error: kernel was compiled for accumulate_method::separated, but called with accumulation buffer");
+
+	if (init)
+		y_n_ = in;
+
+	if (acc_method_ == accumulate_method::subdiagonal) {
+		// last stage, there is no next stage input to compute
+		run(in, out, acc, acc_coeff, static_cast<int_t>(init), y_n_, static_cast<real_t>(0.0), static_cast<int_t>(0));
+	} else {
+		run(in, out, acc, acc_coeff, static_cast<int_t>(init));
+	}
+}
+
+void sparse_operator_ode::solve(real_t /* time */, real_t /* time_step */, cl::Buffer& in, cl::Buffer& out, real_t next_coeff, cl::Buffer& acc, real_t acc_coeff, bool init)
+{
+	if (acc_method_ != accumulate_method::subdiagonal)
+		throw std::runtime_error("sparse_operator_ode::solve(): error: subdiagonal call requires accumulate_method::subdiagonal");
+
+	if (init)
+		y_n_ = in;
+
+	run(in, out, acc, acc_coeff, static_cast<int_t>(init), y_n_, next_coeff, static_cast<int_t>(1));
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,7 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/splitting_stepper.hpp"
+
+// NOTE: this file is currently only needed for dependency management within CMake. Namely to attach OpenCL kernel code generation.
@@ -0,0 +1,123 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/splitting_tableau.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include <noma/typa/parser_error.hpp>
+
+namespace noma {
+namespace num {
+
+std::ostream& operator<<(std::ostream& out, const splitting_method_t& m)
+{
+	out << splitting_method_names.at(m);
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, splitting_method_t& m)
+{
+	std::string value;
+	std::getline(in, value);
+
+	// get key to value
+	// NOTE: we trust splitting_method_names to be complete here
+	bool found = false;
+	for (auto it = splitting_method_names.begin(); it != splitting_method_names.end(); ++it)
+		if (it->second == value) {
+			m = it->first;
+			found = true;
+			break;
+		}
+
+	if (!found)
+		throw noma::typa::parser_error("'" + value + "' is not a valid splitting_method.");
+
+	return in;
+}
+
+splitting_tableau make_verlet_composition(const std::vector<long_real_t>& gamma, size_t order)
+{
+	// kick(gamma_1 / 2) drift(gamma_1) kick((gamma_1 + gamma_2) / 2) drift(gamma_2) ... drift(gamma_m) kick(gamma_m / 2)
+	splitting_tableau result;
+	result.order = order;
+	result.a.push_back(0.0);
+	result.b.push_back(static_cast<real_t>(gamma.front() / 2.0));
+	for (size_t k = 0; k < gamma.size(); ++k) {
+		result.a.push_back(static_cast<real_t>(gamma[k]));
+		result.b.push_back(static_cast<real_t>(k + 1 < gamma.size() ? (gamma[k] + gamma[k + 1]) / 2.0 : gamma[k] / 2.0));
+	}
+	return result;
+}
+
+// Stoermer-Verlet, velocity form, 2nd order
+// https://en.wikipedia.org/wiki/Verlet_integration#Velocity_Verlet
+static const splitting_tableau verlet_tableau = make_verlet_composition({ 1.0 }, 2);
+
+// Yoshida, triple jump composition of Verlet, 4th order
+// H. Yoshida, Construction of higher order symplectic integrators, Phys. Lett. A 150 (1990)
+static splitting_tableau make_yoshida4_tableau()
+{
+	const long_real_t cbrt2 = std::cbrt(static_cast<long_real_t>(2.0));
+	const long_real_t w1 = 1.0 / (2.0 - cbrt2);
+	const long_real_t w0 = -cbrt2 / (2.0 - cbrt2);
+	return make_verlet_composition({ w1, w0, w1 }, 4);
+}
+static const splitting_tableau yoshida4_tableau = make_yoshida4_tableau();
+
+// Yoshida, symmetric composition of 7 Verlet steps, solution A, 6th order
+// H. Yoshida, Construction of higher order symplectic integrators, Phys. Lett. A 150 (1990)
+static splitting_tableau make_yoshida6_tableau()
+{
+	const long_real_t w1 = -1.17767998417887;
+	const long_real_t w2 = 0.235573213359357;
+	const long_real_t w3 = 0.784513610477560;
+	const long_real_t w0 = 1.0 - 2.0 * (w1 + w2 + w3);
+	return make_verlet_composition({ w3, w2, w1, w0, w1, w2, w3 }, 6);
+}
+static const splitting_tableau yoshida6_tableau = make_yoshida6_tableau();
+
+// Blanes-Moan, symmetric 6-stage PRK method S6, 4th order with small error constants
+// S. Blanes, P.C. Moan, Practical symplectic partitioned Runge-Kutta and Runge-Kutta-Nystroem methods, J. Comput. Appl. Math. 142 (2002)
+static splitting_tableau make_blanes_moan4_tableau()
+{
+	const long_real_t a1 = 0.0792036964311957;
+	const long_real_t a2 = 0.353172906049774;
+	const long_real_t a3 = -0.0420650803577195;
+	const long_real_t a4 = 1.0 - 2.0 * (a1 + a2 + a3);
+	const long_real_t b1 = 0.209515106613362;
+	const long_real_t b2 = -0.143851773179818;
+	const long_real_t b3 = 0.5 - (b1 + b2);
+
+	splitting_tableau result;
+	result.order = 4;
+	for (long_real_t a : { a1, a2, a3, a4, a3, a2, a1 })
+		result.a.push_back(static_cast<real_t>(a));
+	for (long_real_t b : { b1, b2, b3, b3, b2, b1, static_cast<long_real_t>(0.0) })
+		result.b.push_back(static_cast<real_t>(b));
+	return result;
+}
+static const splitting_tableau blanes_moan4_tableau = make_blanes_moan4_tableau();
+
+const splitting_tableau& get_splitting_tableau(const splitting_method_t method)
+{
+	switch (method) {
+		case splitting_method_t::verlet:
+			return verlet_tableau;
+		case splitting_method_t::yoshida4:
+			return yoshida4_tableau;
+		case splitting_method_t::yoshida6:
+			return yoshida6_tableau;
+		case splitting_method_t::blanes_moan4:
+			return blanes_moan4_tableau;
+		default:
+			throw std::runtime_error("get_splitting_tableau(): error: Unknown splitting method");
+	}
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,32 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/stage_input.hpp"
+
+#include <stdexcept>
+
+namespace noma {
+namespace num {
+
+constexpr size_t stage_input::max_ks;
+
+stage_input::stage_input(real_t h, const std::vector<real_t>& stage_coeffs, std::vector<cl::Buffer>& stage_ks, cl::Buffer& y_n)
+	: h(h), n(0)
+{
+	size_t used = stage_coeffs.size();
+	while (used > 0 && stage_coeffs[used - 1] == 0.0)
+		--used;
+
+	if (used > max_ks || used > stage_ks.size())
+		throw std::runtime_error("stage_input::stage_input(): error: too many coefficients for the available k buffers.");
+
+	n = static_cast<int_t>(used);
+	for (size_t l = 0; l < max_ks; ++l) {
+		coeffs[l] = (l < used) ? stage_coeffs[l] : 0.0;
+		ks[l] = (l < used) ? stage_ks[l] : y_n;
+	}
+}
+
+} // namespace num
+} // namespace noma
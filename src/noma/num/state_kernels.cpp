@@ -0,0 +1,55 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/state_kernels.hpp"
+
+namespace noma {
+namespace num {
+
+const std::string state_kernels::embedded_ocl_source_ {
+#include "state_kernels.cl.hpp"  // NOTE: generated by CMake
+};
+
+state_kernels::state_kernels(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range)
+	: ocl_(ocl),
+	  dimensions_kernel_(ocl, embedded_ocl_source_, "state_dimensions", source_header, ocl_compile_options, range),
+	  set_basis_kernel_(ocl, embedded_ocl_source_, "state_set_basis", source_header, ocl_compile_options, range),
+	  scale_kernel_(ocl, embedded_ocl_source_, "state_scale", source_header, ocl_compile_options, range),
+	  norm2_kernel_(ocl, embedded_ocl_source_, "state_norm2", source_header, ocl_compile_options, range)
+{
+	std::vector<int_t> dims(2);
+	cl::Buffer dims_buffer = ocl_.create_buffer(CL_MEM_READ_WRITE, dims.size() * sizeof(int_t), nullptr);
+	dimensions_kernel_(dims_buffer);
+	cl_int err = ocl_.command_queue().enqueueReadBuffer(dims_buffer, CL_TRUE, 0, dims.size() * sizeof(int_t), dims.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(dims_buffer)");
+
+	num_matrices_ = static_cast<size_t>(dims[0]);
+	num_states_ = static_cast<size_t>(dims[1]);
+
+	norm2_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, num_matrices_ * sizeof(real_t), nullptr);
+}
+
+void state_kernels::set_basis(cl::Buffer& out, size_t j)
+{
+	set_basis_kernel_(out, static_cast<int_t>(j));
+}
+
+void state_kernels::scale(cl::Buffer& out, real_t alpha, cl::Buffer& in)
+{
+	scale_kernel_(out, alpha, in);
+}
+
+std::vector<real_t> state_kernels::norm2(cl::Buffer& in)
+{
+	norm2_kernel_(norm2_buffer_, in);
+
+	std::vector<real_t> result(num_matrices_);
+	cl_int err = ocl_.command_queue().enqueueReadBuffer(norm2_buffer_, CL_TRUE, 0, result.size() * sizeof(real_t), result.data());
+	ocl::error_handler(err, "clEnqueueReadBuffer(norm2_buffer_)");
+
+	return result;
+}
+
+} // namespace num
+} // namespace noma
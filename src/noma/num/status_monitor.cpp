@@ -0,0 +1,186 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/status_monitor.hpp"
+
+#include <sstream>
+
+#include <noma/typa/parser_error.hpp>
+
+namespace noma {
+namespace num {
+
+const std::string status_monitor::embedded_ocl_source_ {
+#include "status_monitor.cl.hpp"  // NOTE: generated by CMake
+};
+
+std::ostream& operator<<(std::ostream& out, const status_action& action)
+{
+	out << status_action_names.at(action);
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, status_action& action)
+{
+	std::string value;
+	std::getline(in, value);
+
+	// get key to value
+	// NOTE: we trust status_action_names to be complete here
+	bool found = false;
+	for (auto it = status_action_names.begin(); it != status_action_names.end(); ++it)
+		if (it->second == value) {
+			action = it->first;
+			found = true;
+			break;
+		}
+
+	if (!found)
+		throw noma::typa::parser_error("'" + value + "' is not a valid status_action.");
+
+	return in;
+}
+
+void status_compile_options(std::ostream& os)
+{
+	os << "#define NOMA_NUM_STATUS" << "\n";
+}
+
+status_monitor::status_monitor(ocl::helper& ocl, const std::string& source_header, const std::string& ocl_compile_options, const ocl::nd_range& range, size_t buffer_size_byte)
+	: ocl_(ocl), buffer_size_byte_(buffer_size_byte),
+	  reduce_kernel_(ocl, embedded_ocl_source_, "status_reduce", source_header, ocl_compile_options, ocl::nd_range(cl::NDRange(1), cl::NullRange)),
+	  scan_kernel_(ocl, embedded_ocl_source_, "status_scan", source_header, ocl_compile_options, range)
+{
+	if (range.local.dimensions() == 0)
+		throw std::runtime_error("status_monitor::status_monitor(): error: range needs an explicit work-group size.");
+
+	local_size_ = 1;
+	num_groups_ = 1;
+	for (size_t i = 0; i < range.global.dimensions(); ++i) {
+		if (range.global[i] % range.local[i] != 0)
+			throw std::runtime_error("status_monitor::status_monitor(): error: global size is not a multiple of the work-group size.");
+		local_size_ *= range.local[i];
+		num_groups_ *= range.global[i] / range.local[i];
+	}
+
+	status_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, num_groups_ * sizeof(real_t), nullptr);
+	result_buffer_ = ocl_.create_buffer(CL_MEM_READ_WRITE, sizeof(real_t), nullptr);
+	reset();
+}
+
+void status_monitor::poll_interval(size_t steps)
+{
+	if (steps == 0)
+		throw std::runtime_error("status_monitor::poll_interval(): error: poll interval must be at least one step.");
+	poll_interval_ = steps;
+}
+
+void status_monitor::scan(cl::Buffer& in)
+{
+	scan_kernel_(in, status_buffer_, status_local());
+}
+
+void status_monitor::after_step(real_t time, cl::Buffer& d_mem, bool fused)
+{
+	if (++steps_ < poll_interval_)
+		return;
+
+	// the previous poll was enqueued poll_interval_ steps ago, i.e. waiting for it should not stall the device
+	evaluate(d_mem);
+	poll(time, d_mem, fused);
+}
+
+void status_monitor::check(real_t time, cl::Buffer& d_mem, bool fused)
+{
+	evaluate(d_mem);
+	poll(time, d_mem, fused);
+	evaluate(d_mem);
+}
+
+void status_monitor::reset()
+{
+	if (pending_) {
+		cl_int err = pending_event_.wait();
+		ocl::error_handler(err, "clWaitForEvents(pending_event_)");
+	}
+
+	cl_int err = ocl_.command_queue().enqueueFillBuffer(status_buffer_, static_cast<real_t>(0.0), 0, num_groups_ * sizeof(real_t));
+	ocl::error_handler(err, "clEnqueueFillBuffer(status_buffer_)");
+
+	steps_ = 0;
+	pending_ = false;
+	verified_ = false;
+	last_status_ = state_status();
+}
+
+void status_monitor::poll(real_t time, cl::Buffer& d_mem, bool fused)
+{
+	if (!fused)
+		scan(d_mem);
+
+	// reduces and resets the status words
+	reduce_kernel_(static_cast<int_t>(num_groups_), status_buffer_, result_buffer_);
+
+	cl_int err = CL_SUCCESS;
+	if (action_ == status_action::rollback) {
+		err = ocl_.command_queue().enqueueCopyBuffer(d_mem, pending_checkpoint_.get(ocl_, buffer_size_byte_), 0, 0, buffer_size_byte_);
+		ocl::error_handler(err, "clEnqueueCopyBuffer(d_mem, pending_checkpoint_)");
+	}
+
+	// NOTE: non-blocking, evaluated by the next poll
+	err = ocl_.command_queue().enqueueReadBuffer(result_buffer_, CL_FALSE, 0, sizeof(real_t), &pending_result_, nullptr, &pending_event_);
+	ocl::error_handler(err, "clEnqueueReadBuffer(result_buffer_)");
+	err = ocl_.command_queue().flush();
+	ocl::error_handler(err, "clFlush()");
+
+	steps_ = 0;
+	pending_ = true;
+	pending_time_ = time;
+}
+
+void status_monitor::evaluate(cl::Buffer& d_mem)
+{
+	if (!pending_)
+		return;
+
+	cl_int err = pending_event_.wait();
+	ocl::error_handler(err, "clWaitForEvents(pending_event_)");
+	pending_ = false;
+
+	last_status_.max_norm = pending_result_;
+
+	// NOTE: NaN is mapped to INFINITY by the kernels, i.e. the comparison is always defined
+	if (last_status_.max_norm <= max_norm_) {
+		// the checkpoint taken with the poll is fine
+		if (action_ == status_action::rollback) {
+			pending_checkpoint_.swap(verified_checkpoint_.get(ocl_, buffer_size_byte_));
+			verified_ = true;
+			verified_time_ = pending_time_;
+		}
+		return;
+	}
+
+	std::stringstream msg;
+	msg << "status_monitor::evaluate(): error: " << (last_status_.finite() ? "max. norm limit exceeded" : "NaN or Inf detected")
+	    << " at or before time " << pending_time_ << ", max. norm: " << last_status_.max_norm;
+
+	const bool rolled_back = (action_ == status_action::rollback) && verified_;
+	if (rolled_back) {
+		err = ocl_.command_queue().enqueueCopyBuffer(verified_checkpoint_.get(ocl_, buffer_size_byte_), d_mem, 0, 0, buffer_size_byte_);
+		ocl::error_handler(err, "clEnqueueCopyBuffer(verified_checkpoint_, d_mem)");
+		msg << ", rolled back to time " << verified_time_;
+	}
+
+	// the status words of the steps after the failure are meaningless
+	err = ocl_.command_queue().enqueueFillBuffer(status_buffer_, static_cast<real_t>(0.0), 0, num_groups_ * sizeof(real_t));
+	ocl::error_handler(err, "clEnqueueFillBuffer(status_buffer_)");
+	err = ocl_.command_queue().finish();
+	ocl::error_handler(err, "clFinish()");
+	steps_ = 0;
+
+	throw status_error(msg.str(), last_status_, pending_time_, rolled_back, verified_time_);
+}
+
+} // namespace num
+} // namespace noma
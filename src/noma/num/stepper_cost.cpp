@@ -0,0 +1,23 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/stepper_cost.hpp"
+
+namespace noma {
+namespace num {
+
+std::ostream& operator<<(std::ostream& out, const stepper_cost& cost)
+{
+	out << "stepper cost: ODE evaluations: " << cost.ode_evaluations
+	    << ", weighted add launches: " << cost.weighted_add_launches
+	    << ", temporary buffers: " << cost.temporary_buffers
+	    << ", temporary bytes: " << cost.temporary_byte
+	    << ", spare bytes: " << cost.spare_byte
+	    << ", bytes read: " << cost.read_byte
+	    << ", bytes written: " << cost.written_byte;
+	return out;
+}
+
+} // namespace num
+} // namespace noma
@@ -30,8 +30,21 @@ std::istream& operator>>(std::istream& in, stepper_type_t& t)
 			break;
 		}
 
-	if (!found)
+	if (!found) {
+		// give a more specific message for subdiagonal accumulation of a valid, but non-subdiagonal method
+		const std::string prefix { "rk_" };
+		const std::string suffix { "_subdiagonal" };
+		if (value.size() > prefix.size() + suffix.size()
+		    && value.compare(0, prefix.size(), prefix) == 0
+		    && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0) {
+			const std::string method = value.substr(prefix.size(), value.size() - prefix.size() - suffix.size());
+			for (auto it = rk_method_names.begin(); it != rk_method_names.end(); ++it)
+				if (it->second == method && !is_subdiagonal(get_butcher_tableau(it->first)))
+					throw noma::typa::parser_error("'" + value + "' is not a valid stepper_type: '" + method + "' has no subdiagonal Butcher tableau.");
+		}
+
 		throw noma::typa::parser_error("'" + value + "' is not a valid stepper_type.");
+	}
 
 	return in;
 }
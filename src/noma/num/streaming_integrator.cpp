@@ -0,0 +1,145 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/streaming_integrator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace noma {
+namespace num {
+
+streaming_integrator::streaming_integrator(ocl::helper& ocl, size_t num_matrices, size_t matrix_size_byte, size_t chunk_matrices, chunk_stepper_factory factory)
+	: ocl_(ocl), num_matrices_(num_matrices), matrix_size_byte_(matrix_size_byte),
+	  chunk_matrices_(std::min(chunk_matrices, num_matrices)), factory_(std::move(factory))
+{
+	if (num_matrices_ == 0 || chunk_matrices_ == 0 || matrix_size_byte_ == 0)
+		throw std::runtime_error("streaming_integrator::streaming_integrator(): error: number of matrices, chunk size, and matrix size must be positive");
+
+	cl_int err = CL_SUCCESS;
+	upload_queue_ = cl::CommandQueue(ocl_.context(), ocl_.device(), 0, &err);
+	ocl::error_handler(err, "clCreateCommandQueue(upload_queue_)");
+	download_queue_ = cl::CommandQueue(ocl_.context(), ocl_.device(), 0, &err);
+	ocl::error_handler(err, "clCreateCommandQueue(download_queue_)");
+
+	const size_t chunk_size_byte = chunk_matrices_ * matrix_size_byte_;
+	for (size_t i = 0; i < num_slots_; ++i)
+		slots_.push_back(slot { ocl_.create_buffer(CL_MEM_READ_WRITE, chunk_size_byte, nullptr),
+		                        ocl_.create_buffer(CL_MEM_READ_WRITE, chunk_size_byte, nullptr) });
+
+	full_chunk_stepper_ = factory_(ocl_, chunk_matrices_);
+}
+
+size_t streaming_integrator::max_chunk_matrices(ocl::helper& ocl, size_t matrix_size_byte, size_t stepper_temporaries, double memory_fraction)
+{
+	const size_t global_mem_size = static_cast<size_t>(ocl.device().getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>());
+	const size_t max_alloc_size = static_cast<size_t>(ocl.device().getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>());
+
+	// two buffers per slot, plus the stepper's temporaries
+	const size_t buffers = 2 * num_slots_ + stepper_temporaries;
+	const size_t usable = static_cast<size_t>(memory_fraction * static_cast<double>(global_mem_size));
+
+	return std::min(usable / (buffers * matrix_size_byte), max_alloc_size / matrix_size_byte);
+}
+
+chunk_stepper& streaming_integrator::stepper_for(size_t matrices)
+{
+	if (matrices == chunk_matrices_)
+		return full_chunk_stepper_;
+
+	// NOTE: created on first use, as the last chunk is the only smaller one
+	if (!last_chunk_stepper_.stepper)
+		last_chunk_stepper_ = factory_(ocl_, matrices);
+
+	return last_chunk_stepper_;
+}
+
+void streaming_integrator::run(const boost::filesystem::path& file, real_t time, real_t step_size, size_t num_steps, size_t offset_byte)
+{
+	boost::iostreams::mapped_file mapped(file.string(), boost::iostreams::mapped_file::readwrite);
+	if (mapped.size() < offset_byte + num_matrices_ * matrix_size_byte_)
+		throw std::runtime_error("streaming_integrator::run(): error: file '" + file.string() + "' is smaller than the ensemble");
+
+	char* data = mapped.data() + offset_byte;
+	stream(data, data, time, step_size, num_steps);
+}
+
+void streaming_integrator::run(const boost::filesystem::path& input_file, const boost::filesystem::path& output_file, real_t time, real_t step_size, size_t num_steps, size_t offset_byte)
+{
+	boost::iostreams::mapped_file_source input(input_file.string());
+	if (input.size() < offset_byte + num_matrices_ * matrix_size_byte_)
+		throw std::runtime_error("streaming_integrator::run(): error: file '" + input_file.string() + "' is smaller than the ensemble");
+
+	boost::iostreams::mapped_file_params params(output_file.string());
+	params.flags = boost::iostreams::mapped_file::readwrite;
+	params.new_file_size = static_cast<boost::iostreams::stream_offset>(num_matrices_ * matrix_size_byte_);
+	boost::iostreams::mapped_file output(params);
+
+	stream(input.data() + offset_byte, output.data(), time, step_size, num_steps);
+}
+
+void streaming_integrator::stream(const char* input, char* output, real_t time, real_t step_size, size_t num_steps)
+{
+	cl::CommandQueue& compute_queue = ocl_.command_queue();
+	cl_int err = CL_SUCCESS;
+
+	std::vector<cl::Event> uploaded(num_slots_);
+	std::vector<cl::Event> computed(num_slots_);
+	std::vector<cl::Event> downloaded(num_slots_);
+	std::vector<bool> slot_in_use(num_slots_, false);
+
+	for (size_t c = 0; c < num_chunks(); ++c) {
+		const size_t s = c % num_slots_;
+		const size_t first = c * chunk_matrices_;
+		const size_t matrices = std::min(chunk_matrices_, num_matrices_ - first);
+		const size_t offset_byte = first * matrix_size_byte_;
+		const size_t size_byte = matrices * matrix_size_byte_;
+
+		// upload, after the previous download from this slot
+		std::vector<cl::Event> upload_wait;
+		if (slot_in_use[s])
+			upload_wait.push_back(downloaded[s]);
+		err = upload_queue_.enqueueWriteBuffer(slots_[s].in, CL_FALSE, 0, size_byte, input + offset_byte, &upload_wait, &uploaded[s]);
+		ocl::error_handler(err, "clEnqueueWriteBuffer(slots_[s].in)");
+		upload_queue_.flush();
+
+		// integrate, after the upload
+		std::vector<cl::Event> compute_wait { uploaded[s] };
+		err = compute_queue.enqueueBarrierWithWaitList(&compute_wait);
+		ocl::error_handler(err, "clEnqueueBarrierWithWaitList(compute_queue)");
+
+		chunk_stepper& stepper = stepper_for(matrices);
+		cl::Buffer* in = &slots_[s].in;
+		cl::Buffer* out = &slots_[s].out;
+		for (size_t i = 0; i < num_steps; ++i) {
+			stepper.stepper->step(time + static_cast<real_t>(i) * step_size, step_size, *in, *out);
+			std::swap(in, out);
+		}
+		err = compute_queue.enqueueMarkerWithWaitList(nullptr, &computed[s]);
+		ocl::error_handler(err, "clEnqueueMarkerWithWaitList(compute_queue)");
+		compute_queue.flush();
+
+		// download the result, which is in *in after the last swap, after the integration
+		std::vector<cl::Event> download_wait { computed[s] };
+		err = download_queue_.enqueueReadBuffer(*in, CL_FALSE, 0, size_byte, output + offset_byte, &download_wait, &downloaded[s]);
+		ocl::error_handler(err, "clEnqueueReadBuffer(*in)");
+		download_queue_.flush();
+
+		slot_in_use[s] = true;
+	}
+
+	// NOTE: the mapped files must not be closed before all transfers are finished
+	err = download_queue_.finish();
+	ocl::error_handler(err, "clFinish(download_queue_)");
+	err = compute_queue.finish();
+	ocl::error_handler(err, "clFinish(compute_queue)");
+	err = upload_queue_.finish();
+	ocl::error_handler(err, "clFinish(upload_queue_)");
+}
+
+} // namespace num
+} // namespace noma
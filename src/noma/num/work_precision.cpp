@@ -0,0 +1,169 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+#include "noma/num/work_precision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace noma {
+namespace num {
+
+void write_work_precision_csv_header(std::ostream& out)
+{
+	out << "stepper_type,order,steps,step_size,ode_evaluations,seconds,error";
+}
+
+std::ostream& operator<<(std::ostream& out, const work_precision_point& point)
+{
+	if (point.stepper_name.empty())
+		out << point.stepper_type;
+	else
+		out << point.stepper_name;
+	out << ',' << point.order << ',' << point.steps << ',' << point.step_size << ','
+	    << point.ode_evaluations << ',' << point.seconds << ',' << point.error;
+	return out;
+}
+
+real_t observed_order(const std::vector<work_precision_point>& points, long_real_t error_floor, long_real_t error_ceiling)
+{
+	// least squares fit of log(error) = order * log(step_size) + c
+	long_real_t sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_xy = 0.0;
+	size_t n = 0;
+	for (const auto& point : points) {
+		if (point.error <= error_floor || point.error >= error_ceiling || !std::isfinite(point.error))
+			continue;
+		const long_real_t x = std::log(static_cast<long_real_t>(point.step_size));
+		const long_real_t y = std::log(point.error);
+		sum_x += x;
+		sum_y += y;
+		sum_xx += x * x;
+		sum_xy += x * y;
+		++n;
+	}
+
+	const long_real_t denominator = n * sum_xx - sum_x * sum_x;
+	if (n < 2 || denominator == 0.0)
+		return 0.0;
+
+	return static_cast<real_t>((n * sum_xy - sum_x * sum_y) / denominator);
+}
+
+namespace {
+
+// 3 x 3 matrix product, row-major
+void multiply3(const long_real_t* a, const long_real_t* b, long_real_t* c)
+{
+	for (size_t i = 0; i < 3; ++i)
+		for (size_t j = 0; j < 3; ++j) {
+			c[i * 3 + j] = 0.0;
+			for (size_t k = 0; k < 3; ++k)
+				c[i * 3 + j] += a[i * 3 + k] * b[k * 3 + j];
+		}
+}
+
+} // namespace
+
+rabi_problem::rabi_problem(size_t num_matrices, real_t detuning, real_t rabi_frequency, real_t dephasing_rate)
+	: num_matrices_(num_matrices), detuning_(detuning), rabi_frequency_(rabi_frequency), dephasing_rate_(dephasing_rate)
+{
+	hamiltonian_ = { complex_t(0.5 * detuning, 0.0),        complex_t(0.5 * rabi_frequency, 0.0),
+	                 complex_t(0.5 * rabi_frequency, 0.0), complex_t(-0.5 * detuning, 0.0) };
+	decay_rates_ = { complex_t(0.0, 0.0),            complex_t(dephasing_rate, 0.0),
+	                 complex_t(dephasing_rate, 0.0), complex_t(0.0, 0.0) };
+
+	// sigma = |psi><psi|, with psi = (cos(theta / 2), exp(i * phi) * sin(theta / 2))
+	const long_real_t pi = std::acos(static_cast<long_real_t>(-1.0));
+	initial_state_.reserve(num_matrices_ * 4);
+	for (size_t m = 0; m < num_matrices_; ++m) {
+		const long_real_t theta = pi * (m + 0.5) / num_matrices_;
+		const long_real_t phi = 2.0 * pi * m / num_matrices_ * 7.0; // NOTE: 7 windings, such that neighbours differ
+		const long_complex_t psi[2] = { std::cos(0.5 * theta), std::polar(std::sin(0.5 * theta), phi) };
+		for (size_t i = 0; i < 2; ++i)
+			for (size_t j = 0; j < 2; ++j)
+				initial_state_.push_back(complex_t(psi[i] * std::conj(psi[j])));
+	}
+}
+
+std::vector<long_complex_t> rabi_problem::solution(real_t time) const
+{
+	if (dephasing_rate_ != 0.0)
+		return dephased_solution(time);
+
+	// U = cos(omega * t / 2) * I - i * sin(omega * t / 2) * (detuning * sigma_z + rabi_frequency * sigma_x) / omega
+	const long_real_t omega = std::sqrt(detuning_ * detuning_ + rabi_frequency_ * rabi_frequency_);
+	const long_real_t c = std::cos(0.5 * omega * time);
+	const long_real_t s = omega > 0.0 ? std::sin(0.5 * omega * time) / omega : 0.0;
+	const long_complex_t i_unit(0.0, 1.0);
+	const long_complex_t u[4] = { c - i_unit * s * detuning_, -i_unit * s * rabi_frequency_,
+	                              -i_unit * s * rabi_frequency_, c + i_unit * s * detuning_ };
+
+	std::vector<long_complex_t> result(initial_state_.size());
+	for (size_t m = 0; m < num_matrices_; ++m) {
+		const complex_t* sigma = &initial_state_[m * 4];
+		// U * sigma * U^H
+		for (size_t i = 0; i < 2; ++i)
+			for (size_t j = 0; j < 2; ++j) {
+				long_complex_t sum = 0.0;
+				for (size_t k = 0; k < 2; ++k)
+					for (size_t l = 0; l < 2; ++l)
+						sum += u[i * 2 + k] * long_complex_t(sigma[k * 2 + l]) * std::conj(u[j * 2 + l]);
+				result[m * 4 + i * 2 + j] = sum;
+			}
+	}
+
+	return result;
+}
+
+std::vector<long_complex_t> rabi_problem::dephased_solution(real_t time) const
+{
+	// Bloch equations: d/dt r = a * r, with sigma = (tr(sigma) * I + r_x * sigma_x + r_y * sigma_y + r_z * sigma_z) / 2,
+	// i.e. the rotation around (rabi_frequency, 0, detuning), and the decay of r_x and r_y with the dephasing rate
+	const long_real_t a[9] = { -dephasing_rate_, -detuning_,        0.0,
+	                           detuning_,        -dephasing_rate_, -rabi_frequency_,
+	                           0.0,               rabi_frequency_,  0.0 };
+
+	// exp(a * t) by scaling and squaring of the Taylor series, with |a * t / 2^squarings| <= 1/2
+	const long_real_t norm = std::abs(static_cast<long_real_t>(time)) * (2.0 * std::abs(dephasing_rate_) + std::abs(detuning_) + std::abs(rabi_frequency_));
+	size_t squarings = 0;
+	while (norm > 0.5 * std::ldexp(static_cast<long_real_t>(1.0), static_cast<int>(squarings)))
+		++squarings;
+	const long_real_t tau = std::ldexp(static_cast<long_real_t>(time), -static_cast<int>(squarings));
+
+	long_real_t propagator[9] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+	long_real_t term[9] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+	long_real_t tmp[9];
+	for (size_t n = 1; n <= 30; ++n) {
+		multiply3(term, a, tmp);
+		for (size_t e = 0; e < 9; ++e) {
+			term[e] = tmp[e] * tau / static_cast<long_real_t>(n);
+			propagator[e] += term[e];
+		}
+	}
+	for (size_t s = 0; s < squarings; ++s) {
+		multiply3(propagator, propagator, tmp);
+		std::copy(tmp, tmp + 9, propagator);
+	}
+
+	std::vector<long_complex_t> result(initial_state_.size());
+	for (size_t m = 0; m < num_matrices_; ++m) {
+		const complex_t* sigma = &initial_state_[m * 4];
+		const long_real_t trace = static_cast<long_real_t>(sigma[0].real()) + sigma[3].real();
+		const long_real_t r[3] = { 2.0 * sigma[1].real(), -2.0 * sigma[1].imag(), static_cast<long_real_t>(sigma[0].real()) - sigma[3].real() };
+
+		long_real_t r_t[3];
+		for (size_t i = 0; i < 3; ++i)
+			r_t[i] = propagator[i * 3] * r[0] + propagator[i * 3 + 1] * r[1] + propagator[i * 3 + 2] * r[2];
+
+		result[m * 4]     = 0.5 * (trace + r_t[2]);
+		result[m * 4 + 1] = long_complex_t(0.5 * r_t[0], -0.5 * r_t[1]);
+		result[m * 4 + 2] = long_complex_t(0.5 * r_t[0], 0.5 * r_t[1]);
+		result[m * 4 + 3] = 0.5 * (trace - r_t[2]);
+	}
+
+	return result;
+}
+
+} // namespace num
+} // namespace noma
@@ -0,0 +1,131 @@
+// Copyright (c) 2017 Matthias Noack <ma.noack.pr@gmail.com>
+//
+// See accompanying file LICENSE and README for further information.
+
+// Work-precision benchmark of all runtime configurable stepper types (see
+// NOMA_NUM_STEPPER_TYPES) on Rabi oscillations with an analytic reference
+// solution, and of the IMEX steppers on the same problem with dephasing as
+// split implicit part. Writes one CSV line per stepper and step count, and
+// checks the observed convergence order against the nominal order of each method.
+//
+// usage: work_precision <ocl config file> [csv file]
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <noma/ocl/config.hpp>
+#include <noma/ocl/helper.hpp>
+
+#include "noma/num/commutator_ode.hpp"
+#include "noma/num/imex_stepper.hpp"
+#include "noma/num/stepper_type.hpp"
+#include "noma/num/work_precision.hpp"
+
+using namespace noma;
+
+// work-precision points of imex_stepper with METHOD, for the dephasing of problem as implicit part
+template<num::imex_method_t METHOD>
+std::vector<num::work_precision_point> imex_work_precision(ocl::helper& ocl, const std::string& source_header, const ocl::nd_range& range, size_t num_matrices,
+                                                           const num::rabi_problem& problem, num::real_t end_time, const std::vector<size_t>& step_counts)
+{
+	using stepper_t = num::imex_stepper<num::commutator_ode, METHOD>;
+
+	std::stringstream header;
+	stepper_t::ode_compile_options(header);
+	header << source_header;
+
+	num::commutator_ode ode(ocl, header.str(), "", range, num_matrices, problem.hamiltonian(), stepper_t::acc_method);
+	ode.decay(problem.decay_rates());
+	stepper_t stepper(ocl, header.str(), "", range, ode);
+
+	std::stringstream name;
+	name << "imex_" << METHOD;
+	const num::reference_solution reference = [&](num::real_t time) { return problem.solution(time); };
+	return num::work_precision(stepper, name.str(), stepper_t::order(), ocl, ode.buffer_size_byte(), problem.initial_state(), reference, end_time, step_counts);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <ocl config file> [csv file]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	ocl::config ocl_config(argv[1]);
+	ocl::helper ocl(ocl_config);
+
+	std::ofstream csv_file;
+	if (argc > 2)
+		csv_file.open(argv[2], std::ios::trunc);
+	std::ostream& csv = (argc > 2) ? csv_file : std::cout;
+
+	// problem setup
+	const size_t num_matrices = 1024;
+	const size_t num_states = 2;
+	const num::real_t end_time = 2.0;
+	const std::vector<size_t> step_counts { 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+	const num::rabi_problem problem(num_matrices, 1.0, 6.283185307179586);
+
+	std::stringstream source_header;
+	source_header << "#define NUM_MATRICES " << num_matrices << "\n"
+	              << "#define NUM_STATES " << num_states << "\n";
+	const ocl::nd_range range(cl::NDRange(num_matrices), cl::NullRange);
+
+	num::work_precision_ode_factory<num::commutator_ode> factory = [&](const std::string& header, const ocl::nd_range& r, num::accumulate_method acc_method) {
+		return std::unique_ptr<num::commutator_ode>(new num::commutator_ode(ocl, header, "", r, num_matrices, problem.hamiltonian(), acc_method));
+	};
+	const num::reference_solution reference = [&](num::real_t time) { return problem.solution(time); };
+
+	// points below are dominated by round-off, points above are not in the asymptotic regime
+	const num::long_real_t error_floor = 1.0e4 * std::numeric_limits<num::real_t>::epsilon();
+	const num::long_real_t error_ceiling = 1.0e-1;
+	const num::real_t order_tolerance = 0.5;
+
+	num::write_work_precision_csv_header(csv);
+	csv << "\n";
+
+	bool success = true;
+	// writes the points, and checks the observed order
+	auto evaluate = [&](const std::string& name, const std::vector<num::work_precision_point>& points) {
+		for (const auto& point : points)
+			csv << point << "\n";
+
+		const size_t nominal = points.front().order;
+		const num::real_t observed = num::observed_order(points, error_floor, error_ceiling);
+
+		std::cerr << name << ": nominal order: " << nominal << ", observed order: ";
+		if (observed == 0.0) {
+			// NOTE: high orders may have less than two points above the round-off floor, which is only fine if the
+			//       finest, i.e. last, step count reaches it, not if all errors are above the ceiling
+			if (points.back().error <= error_floor) {
+				std::cerr << "n/a" << std::endl;
+			} else {
+				std::cerr << "n/a, error " << points.back().error << " above round-off, FAILED" << std::endl;
+				success = false;
+			}
+		} else if (observed < nominal - order_tolerance) {
+			std::cerr << observed << ", FAILED" << std::endl;
+			success = false;
+		} else {
+			std::cerr << observed << ", ok" << std::endl;
+		}
+	};
+
+	for (const auto& entry : num::stepper_type_names) {
+		evaluate(entry.second, num::work_precision<num::commutator_ode>(entry.first, ocl, source_header.str(), "", range, factory,
+		                                                                problem.initial_state(), reference, end_time, step_counts));
+	}
+
+	// IMEX steppers, with the dephasing as split implicit part (see commutator_ode::decay()), the nominal order must be reached
+	const num::rabi_problem dephased_problem(num_matrices, 1.0, 6.283185307179586, 1.0);
+	evaluate("imex_ark324l2sa", imex_work_precision<num::imex_method_t::ark324l2sa>(ocl, source_header.str(), range, num_matrices, dephased_problem, end_time, step_counts));
+	evaluate("imex_ark436l2sa", imex_work_precision<num::imex_method_t::ark436l2sa>(ocl, source_header.str(), range, num_matrices, dephased_problem, end_time, step_counts));
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}